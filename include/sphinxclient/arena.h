@@ -0,0 +1,118 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * SphinxClient header file - monotonic memory arena used when decoding
+ * search responses
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file arena.h
+
+#ifndef __SPHINXARENA_H__
+#define __SPHINXARENA_H__
+
+#include <stddef.h>
+
+namespace Sphinx
+{
+
+/** @brief Monotonic memory arena
+ *
+ *  Hands out memory from a list of chunks. Memory is never returned
+ *  one piece at a time, all of it is released at once by clear() or
+ *  by the destructor. Objects placed into the arena must be destroyed
+ *  by the owner before the arena is cleared.
+ *
+ *  Copying an arena never copies its memory - the copy starts empty and
+ *  the assignment keeps the current content of the target. This makes
+ *  structures holding an arena (such as Response_t) safely copyable.
+ */
+
+class Arena_t
+{
+public:
+    /** @brief Constructor
+     *  @param chunkSize size of one memory chunk (bigger requests get
+     *         dedicated chunk)
+     */
+    Arena_t(size_t chunkSize = 16384);
+
+    //! @brief copy constructor, creates empty arena
+    Arena_t(const Arena_t &from);
+
+    //! @brief assignment, does nothing (memory is never shared)
+    Arena_t &operator=(const Arena_t &from);
+
+    //! @brief destructor, frees all chunks
+    ~Arena_t();
+
+    /** @brief allocates memory from arena
+     *  @param size number of bytes to allocate
+     *  @return pointer to memory aligned for any fundamental type
+     */
+    void *alloc(size_t size);
+
+    /** @brief releases all memory allocated so far
+     *
+     *  Memory is kept for reuse: when more chunks were in use they are
+     *  replaced by one chunk of their total size, so filling the arena
+     *  with the same amount again allocates nothing. Complexity is
+     *  O(chunks).
+     */
+    void clear();
+
+    //! @brief exchanges memory with another arena, no copying involved
+    void swap(Arena_t &other);
+
+    //! @brief returns count of chunks currently held
+    size_t getChunkCount() const;
+
+private:
+    struct Chunk_t;
+
+    /// allocates new chunk with at least size bytes free
+    void addChunk(size_t size);
+
+    /// list of chunks, the most recent first
+    Chunk_t *chunks;
+    /// first free byte in current chunk
+    char *ptr;
+    /// end of current chunk
+    char *end;
+    /// default chunk size
+    size_t chunkSize;
+};
+
+}//namespace
+
+#endif
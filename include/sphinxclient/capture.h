@@ -0,0 +1,174 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * SphinxClient header file - capture of requests for replay
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file capture.h
+
+#ifndef __SPHINXCAPTURE_H__
+#define __SPHINXCAPTURE_H__
+
+#include <sphinxclient/sphinxclientquery.h>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+class RecordWriter_t;
+class RecordReader_t;
+
+/** @brief Request capture configuration
+ */
+struct CaptureConfig_t
+{
+    CaptureConfig_t(const std::string &path = "");
+
+    /// capture file, rotated files get suffix .1, .2, ...
+    std::string path;
+    /// rotate when the capture file would exceed this size (bytes)
+    uint64_t maxFileSize;
+    /// number of rotated files kept
+    uint32_t maxFiles;
+    /// capacity of the ring buffer (records), rounded up to power of two
+    uint32_t queueSize;
+};//struct
+
+/** @brief One request body of captured call
+ */
+struct CapturedRequest_t
+{
+    /// number of queries in the body (multi-queries)
+    uint32_t queryCount;
+    /// serialized request body as passed to buildHeader (no header)
+    std::string body;
+};//struct
+
+/** @brief One captured client call
+ */
+struct CapturedCall_t
+{
+    CapturedCall_t();
+
+    /** @brief adds request body of the call
+     */
+    void addRequest(const Query_t &body, uint32_t queryCount = 1);
+
+    /// wall clock time the call started (microseconds since epoch)
+    uint64_t timestamp;
+    /// duration of the original call (microseconds)
+    uint32_t elapsed;
+    /// searchd command (Command_t)
+    uint16_t command;
+    /// command version
+    uint16_t version;
+    /// requests sent in parallel (groups of optimised multiquery)
+    std::vector<CapturedRequest_t> requests;
+};//struct
+
+/** @brief Captures client calls for later replay
+ *
+ *  Register by Client_t::setCapture(), one capture can be shared by
+ *  clients in many threads. Every call completing without exception
+ *  (search calls also with warning) is recorded with its command,
+ *  version, timing and request bodies. Records go thru lock-free ring
+ *  buffer to background writer like SlowQueryLog_t, they are dropped
+ *  when the buffer is full (see getDropped()).
+ *
+ *  File starts with magic "SPHXCAPT" and uint32_t format version,
+ *  followed by records, each prefixed by uint32_t length. Numbers are
+ *  in network byte order, see RequestCaptureReader_t. Test program
+ *  sphinxreplay reissues captured calls with original timing.
+ */
+class RequestCapture_t
+{
+public:
+    /** @brief rotates existing file, opens new one and starts writer
+     *  @throws ClientUsageError_t when the file can't be opened
+     */
+    RequestCapture_t(const CaptureConfig_t &config);
+
+    //! @brief writes pending records and stops writer thread
+    ~RequestCapture_t();
+
+    /** @brief queues call for writing (any thread)
+     */
+    void submit(const CapturedCall_t &call);
+
+    //! @brief blocks until the records queued so far are written
+    void flush();
+
+    //! @brief number of records written to file
+    uint64_t getWritten() const;
+
+    //! @brief number of records dropped on full buffer
+    uint64_t getDropped() const;
+
+private:
+    RequestCapture_t(const RequestCapture_t &);
+    RequestCapture_t &operator=(const RequestCapture_t &);
+
+    RecordWriter_t *writer;
+};//class
+
+/** @brief Reads calls of capture file
+ */
+class RequestCaptureReader_t
+{
+public:
+    /** @brief opens capture file
+     *  @throws ClientUsageError_t when file can't be opened or is not
+     *          a capture file
+     */
+    RequestCaptureReader_t(const std::string &path);
+    ~RequestCaptureReader_t();
+
+    /** @brief reads next call
+     *  @return false at the end of file (or on truncated record)
+     */
+    bool next(CapturedCall_t &call);
+
+private:
+    RequestCaptureReader_t(const RequestCaptureReader_t &);
+    RequestCaptureReader_t &operator=(const RequestCaptureReader_t &);
+
+    RecordReader_t *reader;
+};//class
+
+}//namespace
+
+#endif
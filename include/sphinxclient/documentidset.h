@@ -0,0 +1,132 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Sorted sets of document ids and their set algebra
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file documentidset.h
+
+#ifndef __SPHINX_DOCUMENTIDSET_H__
+#define __SPHINX_DOCUMENTIDSET_H__
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+class SharedEnumFilter_t;
+
+/** @brief Set of document ids, kept as sorted vector without duplicates
+ *
+ *  Filled by Client_t::query() decoding document ids of matches only, or
+ *  from any id array. Intersection, union and difference are linear
+ *  merges of the vectors (SIMD block compare where the CPU has it),
+ *  galloping when one set is much smaller. The result can be fed back
+ *  to the next search as filter on "@id".
+ *
+ *  @code
+ *  Sphinx::DocumentIdSet_t seen, wanted;
+ *  client.query("first", config, seen, response);
+ *  client.query("second", config, wanted, response);
+ *  Sphinx::DocumentIdSet_t::subtract(wanted, seen, wanted);
+ *  next.addEnumFilter("@id", wanted.getFilter());
+ *  @endcode
+ */
+class DocumentIdSet_t
+{
+public:
+    DocumentIdSet_t() {}
+
+    //! @brief set of ids in any order, duplicates are dropped
+    explicit DocumentIdSet_t(const std::vector<uint64_t> &ids);
+
+    //! @brief replaces content by ids in any order
+    void assign(const std::vector<uint64_t> &ids);
+
+    /** @brief replaces content by ids in any order, takes their memory
+     *         (ids get the previous content)
+     */
+    void adopt(std::vector<uint64_t> &ids);
+
+    //! @brief ids in ascending order
+    const std::vector<uint64_t> &getIds() const { return ids; }
+
+    size_t size() const { return ids.size(); }
+
+    bool empty() const { return ids.empty(); }
+
+    //! @brief binary search for id
+    bool contains(uint64_t id) const;
+
+    void clear() { ids.clear(); }
+
+    void swap(DocumentIdSet_t &other) { ids.swap(other.ids); }
+
+    bool operator==(const DocumentIdSet_t &other) const
+    {
+        return ids == other.ids;
+    }
+
+    /** @brief ids serialized as enum filter payload
+     *  @see SearchConfig_t::addEnumFilter()
+     */
+    SharedEnumFilter_t getFilter() const;
+
+    /** @brief ids in both a and b
+     *
+     *  Result may be one of the operands, its memory is reused.
+     */
+    static void intersect(const DocumentIdSet_t &a, const DocumentIdSet_t &b,
+                          DocumentIdSet_t &result);
+
+    //! @brief ids in a or b
+    static void unite(const DocumentIdSet_t &a, const DocumentIdSet_t &b,
+                      DocumentIdSet_t &result);
+
+    //! @brief ids in a and not in b
+    static void subtract(const DocumentIdSet_t &a, const DocumentIdSet_t &b,
+                         DocumentIdSet_t &result);
+
+private:
+    /// sorts and drops duplicates
+    void normalize();
+
+    std::vector<uint64_t> ids;
+};//class
+
+}//namespace
+
+#endif
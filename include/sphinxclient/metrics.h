@@ -0,0 +1,101 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * SphinxClient header file - library-wide metrics export
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file metrics.h
+
+#ifndef __SPHINXMETRICS_H__
+#define __SPHINXMETRICS_H__
+
+#include <string>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+/** @brief Type of exported metric family (Prometheus semantics)
+ */
+enum MetricType_t {
+    METRIC_COUNTER   = 0,
+    METRIC_GAUGE     = 1,
+    METRIC_HISTOGRAM = 2
+};
+
+/** @brief One sample of the metrics snapshot
+ *
+ *  Histogram families are exported as cumulative name_bucket samples
+ *  (with le label), name_sum and name_count, as in Prometheus text
+ *  exposition format.
+ */
+struct MetricSample_t
+{
+    const char *family;    //!< @brief metric family name
+    const char *help;      //!< @brief family description
+    MetricType_t type;     //!< @brief family type
+    std::string name;      //!< @brief sample name (family with suffix)
+    std::string labels;    //!< @brief labels without braces, may be empty
+    int64_t value;         //!< @brief sample value
+};//struct
+
+/** @brief called for every sample of the snapshot
+ *  @param sample exported sample
+ *  @param data user data passed to exportMetrics
+ */
+typedef void (*MetricsCallback_t)(const MetricSample_t &sample, void *data);
+
+/** @brief Takes snapshot of client metrics and passes it to callback
+ *
+ *  Client_t records metrics of every call into one of a few shards
+ *  (threads are assigned round robin) without locking: requests,
+ *  errors by exception class and in-flight calls per command, connect
+ *  retries, timeouts per query machine state, and latency
+ *  (microseconds) and response size (bytes) histograms per searchd
+ *  endpoint. Snapshot sums all shards, samples
+ *  of one family are passed in a row.
+ *
+ *  @param callback function called for each sample
+ *  @param data passed to callback
+ */
+void exportMetrics(MetricsCallback_t callback, void *data);
+
+/** @brief Takes snapshot of client metrics in Prometheus text format
+ *  @return exposition text (version 0.0.4)
+ */
+std::string exportMetricsText();
+
+}//namespace
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * SphinxClient header file - observer of query machine events
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file observer.h
+
+#ifndef __SPHINXOBSERVER_H__
+#define __SPHINXOBSERVER_H__
+
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+class ConnectionConfig_t;
+struct QueryStats_t;
+
+/** @brief State of one query in the query machine
+ */
+enum QueryState_t {
+    /// waiting for connect to finish
+    QS_WAIT_WR_CONNECT          = 0,
+    /// waiting to read the protocol version from server
+    QS_WAIT_RD_VERSION          = 1,
+    /// waiting for write the protocol version to server
+    QS_WAIT_WR_VERSION          = 2,
+    /// wating to write reguest to server
+    QS_WAIT_WR_REQUEST          = 3,
+    /// waiting to read the response header from server
+    QS_WAIT_RD_RESPONSE_HEADER  = 4,
+    /// waiting to read the response body from server
+    QS_WAIT_RD_RESPONSE         = 5,
+    /// query is successfully processed
+    QS_FINISHED                 = 6,
+    /// query processing failed
+    QS_FAILED                   = 7,
+    /// waiting between connect retries
+    QS_WAIT_RETRY_CONNECT       = 8
+};
+
+/** @brief Query machine event passed to QueryObserver_t
+ */
+struct QueryEvent_t
+{
+    /// index of query within one client call (group of optimised multiquery)
+    size_t query;
+    /// searchd endpoint
+    const ConnectionConfig_t *connection;
+    /// state of the query when the event occured
+    QueryState_t state;
+    /// microseconds since the query was started
+    uint32_t elapsed;
+    /// bytes, socket calls and timestamps of the query so far
+    const QueryStats_t *stats;
+};//struct
+
+/** @brief Observer of query machine events
+ *
+ *  Register by Client_t::setObserver(). Methods are called from the
+ *  thread running the client call, while the query machine is blocked.
+ *  Observer must not throw. Without observer registered the query
+ *  machine only tests a null pointer.
+ */
+class QueryObserver_t
+{
+public:
+    virtual ~QueryObserver_t() {}
+
+    /** @brief query was added and its connect started
+     */
+    virtual void started(const QueryEvent_t &/*event*/) {}
+
+    /** @brief query moved from event.state to state
+     */
+    virtual void stateChanged(const QueryEvent_t &/*event*/,
+                              QueryState_t /*state*/) {}
+
+    /** @brief connect is going to be retried after connect timeout
+     */
+    virtual void connectRetry(const QueryEvent_t &/*event*/) {}
+
+    /** @brief query timed out in event.state
+     */
+    virtual void timeout(const QueryEvent_t &/*event*/) {}
+
+    /** @brief query failed (machine fails all unfinished queries at once)
+     *  @param message error message of the exception being thrown
+     */
+    virtual void failed(const QueryEvent_t &/*event*/,
+                        const std::string &/*message*/) {}
+};//class
+
+}//namespace
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Sorting, filtering and grouping of decoded matches by attribute columns
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file resultkernels.h
+
+#ifndef __SPHINX_RESULTKERNELS_H__
+#define __SPHINX_RESULTKERNELS_H__
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+struct Response_t;
+
+/** @brief Numeric attribute of matches in one contiguous array
+ *
+ *  Values are kept as order preserving 64bit keys (floats are mapped so
+ *  that the keys compare as the floats do), kernels below compare and
+ *  sort them without looking at entries or value types again. Besides
+ *  attributes of a response the column can hold scores computed by the
+ *  application, one per entry.
+ */
+class Column_t
+{
+public:
+    Column_t() : floating(false) {}
+
+    /** @brief column of attribute (or "@id", "@weight") of entries
+     *  @throws ValueTypeError_t when some entry lacks the attribute or
+     *          it is not an integer, bigint or float
+     */
+    Column_t(const Response_t &response, const std::string &name);
+
+    //! @brief column of integer values
+    explicit Column_t(const std::vector<uint64_t> &values);
+
+    //! @brief column of integer values
+    explicit Column_t(const std::vector<uint32_t> &values);
+
+    //! @brief column of float values
+    explicit Column_t(const std::vector<float> &values);
+
+    size_t size() const { return keys.size(); }
+
+    //! @brief whether the column holds floats
+    bool isFloat() const { return floating; }
+
+    //! @brief integer value of row (float columns truncate)
+    uint64_t getUInt(size_t row) const;
+
+    //! @brief float value of row
+    float getFloat(size_t row) const;
+
+    //! @brief order preserving keys of the rows
+    const std::vector<uint64_t> &getKeys() const { return keys; }
+
+    //! @brief key of float value
+    static uint64_t floatKey(float value);
+
+private:
+    std::vector<uint64_t> keys;
+    bool floating;
+};//class
+
+//! @brief one key of sortRows() and topRows()
+struct SortKey_t
+{
+    SortKey_t(const Column_t &column, bool descending = false)
+        : column(&column), descending(descending)
+    {}
+
+    const Column_t *column;
+    bool descending;
+};
+
+typedef std::vector<SortKey_t> SortKeys_t;
+
+/** @brief Rows of a group found by groupRows()
+ */
+struct Group_t
+{
+    //! @brief first row of the group (read group value from it)
+    uint32_t firstRow;
+    //! @brief count of rows in the group
+    uint32_t count;
+    //! @brief sum of the summed column over rows of the group
+    double sum;
+};
+
+/* Kernels work on row numbers (indexes to Response_t::entry and to the
+ * columns), rows themselves are never copied or moved. Output row
+ * vectors may be the input ones.
+ */
+
+//! @brief fills rows by 0 .. count - 1
+void selectAllRows(size_t count, std::vector<uint32_t> &rows);
+
+/** @brief stable sort of rows by keys, the first key is the most
+ *         significant one
+ *
+ *  LSD radix sort of the keys, byte passes in which all keys agree are
+ *  skipped.
+ */
+void sortRows(const SortKeys_t &keys, std::vector<uint32_t> &rows);
+
+/** @brief count best rows by keys in order, stable as sortRows()
+ *
+ *  Keeps a heap of count rows, so only rows better than the worst kept
+ *  one cost more than a compare.
+ */
+void topRows(const SortKeys_t &keys, size_t count,
+             const std::vector<uint32_t> &rows, std::vector<uint32_t> &top);
+
+/** @brief keeps rows with values of integer column in range
+ *  @param exclude keep rows outside the range instead
+ *  @throws ValueTypeError_t when the column holds floats
+ */
+void filterRange(const Column_t &column, uint64_t minValue, uint64_t maxValue,
+                 bool exclude, const std::vector<uint32_t> &rows,
+                 std::vector<uint32_t> &kept);
+
+/** @brief keeps rows with values of float column in range
+ *  @param exclude keep rows outside the range instead
+ *  @throws ValueTypeError_t when the column holds integers
+ */
+void filterFloatRange(const Column_t &column, float minValue, float maxValue,
+                      bool exclude, const std::vector<uint32_t> &rows,
+                      std::vector<uint32_t> &kept);
+
+/** @brief groups rows by value of column, counts them and sums column
+ *         sum over each group
+ *  @param sum summed column, 0 counts only
+ *  @param groups output parameter - groups in order of their first rows
+ */
+void groupRows(const Column_t &column, const Column_t *sum,
+               const std::vector<uint32_t> &rows,
+               std::vector<Group_t> &groups);
+
+}//namespace
+
+#endif
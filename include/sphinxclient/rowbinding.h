@@ -0,0 +1,266 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Binding of match attributes to members of user structs
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file rowbinding.h
+
+#ifndef __SPHINX_ROWBINDING_H__
+#define __SPHINX_ROWBINDING_H__
+
+#include <string>
+#include <vector>
+#include <list>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+/** @brief Type of struct member bound to attribute
+  *
+  * Integer attributes bind to uint32_t or uint64_t, bigint to uint64_t,
+  * float to float, string to std::string, MVA to std::vector<uint32_t>
+  * (MVA64 to std::vector<uint64_t>, MVA to it too).
+  */
+enum BoundType_t { BOUND_UINT32, BOUND_UINT64, BOUND_FLOAT, BOUND_STRING,
+                   BOUND_UINT32_ARRAY, BOUND_UINT64_ARRAY };
+
+/** @brief Type independent part of RowBinding_t used by the decoder
+  */
+class RowBindingBase_t
+{
+public:
+    /** @brief stores decoded value into bound member of row
+      * @param row the row
+      * @param member pointer to the member pointer
+      * @param value pointer to value of the bound type
+      */
+    typedef void (*Store_t)(void *row, const void *member, const void *value);
+
+    //! @brief one bound member
+    struct Field_t
+    {
+        std::string name;
+        BoundType_t type;
+        Store_t store;
+        const void *member;
+    };
+
+    //! @brief bound attributes in binding order
+    const std::vector<Field_t> &getFields() const { return fields; }
+
+    //! @brief document id member (store is 0 when not bound)
+    const Field_t &getDocumentId() const { return documentId; }
+
+    //! @brief weight member (store is 0 when not bound)
+    const Field_t &getWeight() const { return weight; }
+
+protected:
+    RowBindingBase_t()
+    {
+        documentId.store = weight.store = 0;
+        documentId.member = weight.member = 0;
+    }
+
+    template<class Row_t, class T>
+    static void storeMember(void *row, const void *member, const void *value)
+    {
+        static_cast<Row_t *>(row)->*(*static_cast<T Row_t::* const *>(member))
+            = *static_cast<const T *>(value);
+    }
+
+    std::vector<Field_t> fields;
+    Field_t documentId;
+    Field_t weight;
+
+private:
+    RowBindingBase_t(const RowBindingBase_t &);
+    RowBindingBase_t &operator=(const RowBindingBase_t &);
+};//class
+
+/** @brief Maps attribute names to members of Row_t
+  *
+  * Rows are decoded straight into members, without ResponseEntry_t maps
+  * and Value_t conversions. The binding is checked against the schema
+  * once per response: missing attribute or type that doesn't fit the
+  * member throws ValueTypeError_t. Attributes not bound are stepped
+  * over. Build the binding once and reuse it, it can't be copied.
+  *
+  * @code
+  * struct Hit_t { uint64_t id; uint32_t gid; std::string name; };
+  * Sphinx::RowBinding_t<Hit_t> binding;
+  * binding.bindDocumentId(&Hit_t::id);
+  * SPHINX_BIND_ATTRIBUTE(binding, Hit_t, gid);
+  * SPHINX_BIND_ATTRIBUTE(binding, Hit_t, name);
+  * client.query("text", config, binding, hits, response);
+  * @endcode
+  */
+template<class Row_t>
+class RowBinding_t : public RowBindingBase_t
+{
+public:
+    RowBinding_t() {}
+
+    RowBinding_t &bind(const std::string &name, uint32_t Row_t::*member)
+    {
+        return add(name, BOUND_UINT32, member, uint32s);
+    }
+
+    RowBinding_t &bind(const std::string &name, uint64_t Row_t::*member)
+    {
+        return add(name, BOUND_UINT64, member, uint64s);
+    }
+
+    RowBinding_t &bind(const std::string &name, float Row_t::*member)
+    {
+        return add(name, BOUND_FLOAT, member, floats);
+    }
+
+    RowBinding_t &bind(const std::string &name, std::string Row_t::*member)
+    {
+        return add(name, BOUND_STRING, member, strings);
+    }
+
+    RowBinding_t &bind(const std::string &name,
+                       std::vector<uint32_t> Row_t::*member)
+    {
+        return add(name, BOUND_UINT32_ARRAY, member, uint32Arrays);
+    }
+
+    RowBinding_t &bind(const std::string &name,
+                       std::vector<uint64_t> Row_t::*member)
+    {
+        return add(name, BOUND_UINT64_ARRAY, member, uint64Arrays);
+    }
+
+    //! @brief binds document id of matches
+    RowBinding_t &bindDocumentId(uint64_t Row_t::*member)
+    {
+        uint64s.push_back(member);
+        documentId.type = BOUND_UINT64;
+        documentId.store = storeMember<Row_t, uint64_t>;
+        documentId.member = &uint64s.back();
+        return *this;
+    }
+
+    //! @brief binds weight of matches
+    RowBinding_t &bindWeight(uint32_t Row_t::*member)
+    {
+        uint32s.push_back(member);
+        weight.type = BOUND_UINT32;
+        weight.store = storeMember<Row_t, uint32_t>;
+        weight.member = &uint32s.back();
+        return *this;
+    }
+
+private:
+    template<class T>
+    RowBinding_t &add(const std::string &name, BoundType_t type,
+                      T Row_t::*member, std::list<T Row_t::*> &members)
+    {
+        // list keeps member pointers in place for the fields
+        members.push_back(member);
+        Field_t field;
+        field.name = name;
+        field.type = type;
+        field.store = storeMember<Row_t, T>;
+        field.member = &members.back();
+        fields.push_back(field);
+        return *this;
+    }
+
+    std::list<uint32_t Row_t::*> uint32s;
+    std::list<uint64_t Row_t::*> uint64s;
+    std::list<float Row_t::*> floats;
+    std::list<std::string Row_t::*> strings;
+    std::list<std::vector<uint32_t> Row_t::*> uint32Arrays;
+    std::list<std::vector<uint64_t> Row_t::*> uint64Arrays;
+};//class
+
+/** @brief binds attribute to the struct member of the same name
+  */
+#define SPHINX_BIND_ATTRIBUTE(binding, Row, member) \
+    (binding).bind(#member, &Row::member)
+
+/** @brief Destination of bound rows
+  */
+class RowSink_t
+{
+public:
+    RowSink_t(const RowBindingBase_t &binding) : binding(binding) {}
+
+    virtual ~RowSink_t() {}
+
+    /** @brief makes room for count rows
+      * @return first row, the others follow by getStride() bytes
+      */
+    virtual void *resize(size_t count) = 0;
+
+    //! @brief distance of rows (bytes)
+    virtual size_t getStride() const = 0;
+
+    //! @brief binding of the rows
+    const RowBindingBase_t &getBinding() const { return binding; }
+
+private:
+    const RowBindingBase_t &binding;
+};//class
+
+/** @brief Rows decoded into std::vector, rows it holds are reused
+  */
+template<class Row_t>
+class RowVector_t : public RowSink_t
+{
+public:
+    RowVector_t(const RowBinding_t<Row_t> &binding, std::vector<Row_t> &rows)
+        : RowSink_t(binding), rows(rows)
+    {}
+
+    virtual void *resize(size_t count)
+    {
+        rows.resize(count);
+        return count ? &rows[0] : 0;
+    }
+
+    virtual size_t getStride() const { return sizeof(Row_t); }
+
+private:
+    std::vector<Row_t> &rows;
+};//class
+
+}//namespace
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * SphinxClient header file - sampled slow query log
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file slowlog.h
+
+#ifndef __SPHINXSLOWLOG_H__
+#define __SPHINXSLOWLOG_H__
+
+#include <sphinxclient/sphinxclient.h>
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+class RecordReader_t;
+
+/** @brief Why the call was logged (SlowQueryRecord_t::flags)
+ */
+enum SlowQueryFlag_t {
+    SLOWLOG_SLOW     = 1,   //!< @brief call exceeded the threshold
+    SLOWLOG_SAMPLED  = 2    //!< @brief call was chosen by sample rate
+};
+
+/** @brief Slow query log configuration
+ */
+struct SlowQueryLogConfig_t
+{
+    SlowQueryLogConfig_t(const std::string &path = "");
+
+    /// log file, rotated files get suffix .1, .2, ...
+    std::string path;
+    /// log calls taking longer (ms), 0 disables threshold
+    uint32_t thresholdMs;
+    /// log every n-th call on average, 0 disables sampling
+    uint32_t sampleEvery;
+    /// rotate when the log file would exceed this size (bytes)
+    uint64_t maxFileSize;
+    /// number of rotated files kept
+    uint32_t maxFiles;
+    /// capacity of the ring buffer (records), rounded up to power of two
+    uint32_t queueSize;
+};//struct
+
+/** @brief One logged call
+ */
+struct SlowQueryRecord_t
+{
+    /// wall clock time the call finished (microseconds since epoch)
+    uint64_t timestamp;
+    /// SlowQueryFlag_t bits
+    uint32_t flags;
+    /// duration of the whole call (microseconds)
+    uint32_t elapsed;
+    /// searchd endpoint (host:port or unix://path)
+    std::string endpoint;
+    /// per-stage timings of the slowest request of the call
+    QueryStats_t stats;
+    /// query text (empty for multi-queries)
+    std::string query;
+    /// SearchConfig_t summary (query count for multi-queries)
+    std::string config;
+    /// serialized requests as sent to searchd (header included)
+    std::vector<std::string> requests;
+};//struct
+
+/** @brief Sampled slow query log
+ *
+ *  Register by Client_t::setSlowQueryLog(), one log can be shared by
+ *  clients in many threads. Client call only decides whether to log
+ *  and serializes the record into a lock-free ring buffer, background
+ *  thread drains the buffer into a rotating binary file. When the
+ *  buffer is full the record is dropped (see getDropped()). Search
+ *  calls are considered when they complete without exception.
+ *
+ *  File starts with magic "SPHXSLOW" and uint32_t format version,
+ *  followed by records, each prefixed by uint32_t length. Numbers are
+ *  in network byte order, see SlowQueryLogReader_t.
+ */
+class SlowQueryLog_t
+{
+public:
+    /** @brief opens log file and starts writer thread
+     *
+     *  Existing log file is rotated first.
+     *
+     *  @throws ClientUsageError_t when the file can't be opened
+     */
+    SlowQueryLog_t(const SlowQueryLogConfig_t &config);
+
+    //! @brief writes pending records and stops writer thread
+    ~SlowQueryLog_t();
+
+    //! @brief blocks until the records queued so far are written
+    void flush();
+
+    //! @brief number of records written to file
+    uint64_t getWritten() const;
+
+    //! @brief number of records dropped on full buffer
+    uint64_t getDropped() const;
+
+private:
+    SlowQueryLog_t(const SlowQueryLog_t &);
+    SlowQueryLog_t &operator=(const SlowQueryLog_t &);
+
+    friend class Client_t;
+
+    /** @brief decides whether to log the call
+     *  @param elapsed duration of the call (microseconds)
+     *  @return SlowQueryFlag_t bits, 0 when not to be logged
+     */
+    uint32_t select(uint32_t elapsed) const;
+
+    /** @brief serializes record and queues it for writing
+     */
+    void submit(const SlowQueryRecord_t &record);
+
+    struct PrivateData_t;
+    PrivateData_t *d;
+};//class
+
+/** @brief Reads records of slow query log file
+ */
+class SlowQueryLogReader_t
+{
+public:
+    /** @brief opens log file
+     *  @throws ClientUsageError_t when file can't be opened or is not
+     *          a slow query log
+     */
+    SlowQueryLogReader_t(const std::string &path);
+    ~SlowQueryLogReader_t();
+
+    /** @brief reads next record
+     *  @return false at the end of file (or on truncated record)
+     */
+    bool next(SlowQueryRecord_t &record);
+
+private:
+    SlowQueryLogReader_t(const SlowQueryLogReader_t &);
+    SlowQueryLogReader_t &operator=(const SlowQueryLogReader_t &);
+
+    RecordReader_t *reader;
+};//class
+
+}//namespace
+
+#endif
@@ -43,11 +43,17 @@
 
 #include <sphinxclient/sphinxclientquery.h>
 #include <sphinxclient/value.h>
+#include <sphinxclient/arena.h>
 #include <sphinxclient/globals_public.h>
+#include <sphinxclient/observer.h>
+#include <sphinxclient/rowbinding.h>
+#include <sphinxclient/documentidset.h>
+#include <sphinxclient/resultkernels.h>
 
 #include <sstream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <list>
 #include <map>
 #include <stdint.h>
@@ -64,6 +70,9 @@ namespace Sphinx
 class Query_t;
 class Client_t;
 class Filter_t;
+class SlowQueryLog_t;
+class RequestCapture_t;
+struct CapturedCall_t;
 
 //------------------------------------------------------------------------------
 #define DEFAULT_CONNECT_RETRIES 1
@@ -250,6 +259,40 @@ struct GeoAnchorPoint_t {
     float lattitude, longitude;
 };
 
+/** @brief Enum filter values shared between search configs
+ *
+ *  Values are serialized into the protocol format once, when the object
+ *  is constructed. Filters added by SearchConfig_t::addEnumFilter() from
+ *  this object (and all copies of such configs) reference the serialized
+ *  values without copying them. Useful for large id/permission filters
+ *  attached to many queries. The object is immutable; copying it is
+ *  cheap and thread safe.
+ */
+
+class SharedEnumFilter_t
+{
+    /// shared payload (hidden from interface, ABI stability)
+    struct PrivateData_t;
+    /// pointer to the payload handle
+    PrivateData_t *d;
+
+    friend struct SearchConfig_t;
+public:
+    /// serialize 64bit values
+    explicit SharedEnumFilter_t(const Int64Array_t &values);
+    /// serialize 32bit values
+    explicit SharedEnumFilter_t(const IntArray_t &values);
+
+    SharedEnumFilter_t(const SharedEnumFilter_t &from);
+    SharedEnumFilter_t &operator=(const SharedEnumFilter_t &from);
+    ~SharedEnumFilter_t();
+
+    /// get count of values
+    size_t size() const;
+    /// get copy of values (decoded)
+    Int64Array_t getValues() const;
+};
+
 /** @brief Search query configuration object
  *
  *  holds information about sorting, grouping and filtering results
@@ -295,6 +338,13 @@ struct SearchConfig_t
       */
     void addEnumFilter(const std::string &attrName, const IntArray_t &values,
                   bool excludeFlag=false);
+    /** @brief Adds enumeration filter with shared values to search config
+      *
+      * Values are not copied, filter references already serialized values.
+      * @param excludeFlag invert filter (use all values except enumerated)
+      */
+    void addEnumFilter(const std::string &attrName,
+                  const SharedEnumFilter_t &values, bool excludeFlag=false);
     /** @brief Adds float range attribute filter to search config
       * 
       * @param excludeFlag invert filter (use values outside spcified range)
@@ -364,6 +414,18 @@ struct SearchConfig_t
     bool getFilter(int index, std::string &attrname,
             bool &exclude, Int64Array_t &values) const;
 
+    /** @brief Rewrite filters into canonical, compact form
+     *
+     * Sorts and deduplicates enum values, turns enums of contiguous values
+     * into ranges, joins exclude filters on the same attribute, drops
+     * redundant and duplicate filters and orders filters by attribute name.
+     * The result is equivalent (also for multi-value attributes), but
+     * shorter and cheaper for searchd to evaluate. Equal filter sets end
+     * up in the same order, so MultiQueryOpt_t groups such queries together.
+     * Filter indexes (getFilter()) change.
+     */
+    void normalizeFilters();
+
     /** Get number of set filters. */
     unsigned getFilterCount() const;
 
@@ -452,6 +514,19 @@ struct SearchConfig_t
      */
     void setSelectClause(const std::string &selectClause);
 
+    /**
+     * Decode only listed attributes of matches, the others are stepped
+     * over and left out of ResponseEntry_t::attribute (document id and
+     * weight are decoded always). Empty list (default) decodes all.
+     *
+     * @param attributes names of attributes to decode
+     * @param narrowSelect when select clause is "*", replace it by the
+     *        listed names so searchd does not send the others (they
+     *        must be attributes of the searched indexes then)
+     */
+    void setProjection(const std::vector<std::string> &attributes,
+                       bool narrowSelect = false);
+
 
     /// Get current paging offset
     uint32_t getPagingOffset() const;
@@ -508,6 +583,9 @@ struct SearchConfig_t
     /// Get select clause.
     const std::string &getSelectClause() const;
 
+    /// Get names of attributes to decode (empty for all).
+    const std::vector<std::string> &getProjection() const;
+
     /// Type of attribute overrides return struct.
     typedef std::map<
         std::string,
@@ -542,6 +620,16 @@ struct ResponseEntry_t
 
     ResponseEntry_t()
         : documentId(0), groupId(0), timestamp(0), weight(0) {}
+
+    //! @brief exchanges content with another entry, no copying involved
+    void swap(ResponseEntry_t &other)
+    {
+        std::swap(documentId, other.documentId);
+        std::swap(groupId, other.groupId);
+        std::swap(timestamp, other.timestamp);
+        std::swap(weight, other.weight);
+        attribute.swap(other.attribute);
+    }
 };//struct
 
 /** @brief Searched word statistics returned by searchd
@@ -557,6 +645,110 @@ struct WordStatistics_t
 
 typedef std::vector<std::pair<std::string, uint32_t> > AttributeTypes_t;
 
+/** @brief Fields and attributes of a search response
+  *
+  * Schemas are interned in a process-wide cache keyed by the schema
+  * bytes of the response, so responses of the same shape share one
+  * immutable instance holding the names once. Rows are decoded by a
+  * plan compiled when the schema was seen first.
+  *
+  * @see Response_t::schema
+  */
+class Schema_t
+{
+public:
+    //! @brief findAttribute() result for unknown name
+    static const size_t NO_ATTRIBUTE = size_t(-1);
+
+    //! @brief list of searched fields
+    const std::vector<std::string> &getFields() const { return fields; }
+
+    //! @brief list of attributes and their types in wire order
+    const AttributeTypes_t &getAttributes() const { return attributes; }
+
+    /** @brief looks attribute up by name in constant time
+      * @return index into getAttributes() (the first one of duplicate
+      *         names, as in ResponseEntry_t::attribute) or NO_ATTRIBUTE
+      */
+    size_t findAttribute(const std::string &name) const;
+
+private:
+    friend class SchemaPtr_t;
+    friend class SchemaCache_t;
+    struct PrivateData_t;
+
+    Schema_t();
+    ~Schema_t();
+    Schema_t(const Schema_t &);
+    Schema_t &operator=(const Schema_t &);
+
+    std::vector<std::string> fields;
+    AttributeTypes_t attributes;
+    /// perfect hash of attribute names, seed makes it collision free
+    uint32_t seed;
+    /// hash slots holding attribute index + 1, 0 for empty
+    std::vector<uint32_t> slots;
+    PrivateData_t *d;
+    /// references held by SchemaPtr_t (atomic)
+    int refs;
+};//class
+
+/** @brief Shared reference to immutable Schema_t
+  *
+  * Copies are cheap (atomic reference count), the schema lives until
+  * the cache and the last reference drop it.
+  */
+class SchemaPtr_t
+{
+public:
+    SchemaPtr_t() : schema(0) {}
+
+    SchemaPtr_t(const SchemaPtr_t &from);
+
+    SchemaPtr_t &operator=(const SchemaPtr_t &from);
+
+    ~SchemaPtr_t();
+
+    const Schema_t *operator->() const { return schema; }
+    const Schema_t &operator*() const { return *schema; }
+
+    //! @brief referenced schema, 0 when none
+    const Schema_t *get() const { return schema; }
+
+    void swap(SchemaPtr_t &other) { std::swap(schema, other.schema); }
+
+private:
+    friend class SchemaCache_t;
+
+    explicit SchemaPtr_t(Schema_t *schema);
+
+    Schema_t *schema;
+};//class
+
+/** @brief Execution statistics of one search call
+  *
+  * Times are in microseconds since the request was handed to the
+  * query machine, zero means the state was not reached. Responses
+  * received in one multi-query request share the timestamps and
+  * byte counts of that request, only parseTime is per response.
+  */
+struct QueryStats_t
+{
+    uint32_t connectTime;   //!< @brief connection established
+    uint32_t versionTime;   //!< @brief server protocol version read
+    uint32_t requestTime;   //!< @brief request written
+    uint32_t headerTime;    //!< @brief response header read
+    uint32_t responseTime;  //!< @brief response body read
+    uint32_t parseTime;     //!< @brief time spent decoding the response
+
+    uint64_t bytesSent;     //!< @brief bytes written to the socket
+    uint64_t bytesReceived; //!< @brief bytes read from the socket
+    uint32_t syscalls;      //!< @brief connect, getsockopt, send and recv calls
+    uint32_t connectRetries; //!< @brief connect attempts after timeout
+
+    QueryStats_t();
+};//struct
+
 /** @brief Search query result data
   *
   * @see SphinxClient_t::query
@@ -564,12 +756,21 @@ typedef std::vector<std::pair<std::string, uint32_t> > AttributeTypes_t;
 
 struct Response_t
 {
+    //! @brief memory holding decoded attribute values when useArena is set,
+    //!        declared first so it outlives the entries
+    Arena_t arena;
+
     //! @brief list of searched fields
     std::vector<std::string> field;
 
     //! @brief list of returned attributes and their types
     AttributeTypes_t attribute;
 
+    /** @brief interned schema the field and attribute lists were
+     *         copied from, shared with other responses of the same shape
+     */
+    SchemaPtr_t schema;
+
     //! @brief list of matches found and returned by the searchd
     std::vector<ResponseEntry_t> entry;
 
@@ -584,7 +785,34 @@ struct Response_t
 
     SearchCommandVersion_t commandVersion; //!< @brief search command version
 
+    /** @brief decode attribute values into the arena (default false)
+     *
+     *  Saves one heap allocation per attribute value, all values are
+     *  released at once by clear() or destructor. Values copied out of
+     *  the entries are allocated on the heap as usual, but entries must
+     *  not be swapped into another response.
+     */
+    bool useArena;
+
+    /** @brief statistics of the call that produced this response,
+     *         filled by Client_t::query, kept by clear()
+     */
+    QueryStats_t stats;
+
+    Response_t();
+
     void clear();
+
+    /** @brief exchanges content with another response (arena included),
+     *         no copying involved
+     *
+     *  Use it to move responses, Client_t::query decodes into the
+     *  given response in place and keeps the memory it already holds
+     *  (entries, their attribute nodes and the arena) for the next
+     *  call. With useArena set a reused response decodes without heap
+     *  allocations once it has grown to the size of the results.
+     */
+    void swap(Response_t &other);
 };//struct
 
 /** @brief keywords request result data for one word query */
@@ -608,6 +836,8 @@ protected:
     SearchCommandVersion_t commandVersion;
     Query_t queries;
     int queryCount;
+    /// attributes to decode of each query
+    std::vector<std::vector<std::string> > projections;
 
 public:
     /** @brief Constructor of multiquery
@@ -634,6 +864,8 @@ public:
 
     int getQueryCount() const; //!< @brief returns query count
     const Query_t &getQueries() const; //!< @brief returns concatenated queries
+    //! @brief returns attributes to decode of query i
+    const std::vector<std::string> &getProjection(int i) const;
     //! @brief returns command version
     SearchCommandVersion_t getCommandVersion() const;
 };//class
@@ -667,6 +899,19 @@ public:
      * @return the query
      */
     const Query_t &getQuery() const {return serializedQuery;}
+    /* @brief estimated cost of matching stage, paid once per group of
+     *        queries with the same hash sent in one multiquery
+     * @return cost in abstract units
+     */
+    unsigned long getMatchCost() const {return matchCost;}
+    /* @brief estimated cost of sorting/grouping stage, paid by each query
+     * @return cost in abstract units
+     */
+    unsigned long getSortCost() const {return sortCost;}
+    /* @brief attributes to decode from response of the query
+     * @see SearchConfig_t::setProjection
+     */
+    const std::vector<std::string> &getProjection() const {return projection;}
 
 private:
     /// serialized query object
@@ -676,6 +921,12 @@ private:
     std::string hash;
     /// sequence number (starting from 0.)
     int inputSeqNo;
+    /// estimated cost of matching stage
+    unsigned long matchCost;
+    /// estimated cost of sorting stage
+    unsigned long sortCost;
+    /// attributes to decode
+    std::vector<std::string> projection;
 };
 
 
@@ -696,6 +947,13 @@ private:
   * method optimise() do that. If calling optimise is ommited,
   * multiquery is sent in traditional manner as one big multiquery.
   * 
+  * When connection budget is set, optimise() also balances the groups
+  * over the given number of connections: oversized groups are split
+  * into several parallel multiqueries and tiny groups are merged
+  * together, so that the most expensive connection finishes as soon as
+  * possible. Cost of a query is estimated from maxMatches and filter
+  * sizes.
+  *
   * Query groups are then sent in Clinent_t::query() to sphinx searchd
   * simultaneously by passing them to QueryMachine_t. After collecting
   * replies from server responses are parsed and ordered as they came
@@ -720,6 +978,19 @@ public:
      */
     void optimise();
 
+    /** @brief sets maximal count of connections used by optimised query
+     *
+     * Zero (default) means one connection per query group. Budget is
+     * limited by maximal count of parallel connections of QueryMachine_t.
+     * Takes effect at next call of optimise().
+     *
+     * @param budget maximal count of parallel connections
+     */
+    void setConnectionBudget(size_t budget);
+
+    //! @brief returns connection budget
+    size_t getConnectionBudget() const;
+
     /** @brief adds a query to multi-query
       *
       * Adds a query to multi-query and checks command version against
@@ -746,6 +1017,11 @@ protected:
     /// groupQuery specification
     /// indexes of first queries within group queries in sortedQueries
     std::vector<int> groupQueries;
+    /// maximal count of connections, 0 = one per query group
+    size_t connectionBudget;
+
+    //! @brief balances query groups over connection budget
+    void planGroups();
 
     //! @brief resets query data and multi-query command version
     void initQuery(SearchCommandVersion_t commandVersion);
@@ -852,12 +1128,59 @@ public:
                const SearchConfig_t &queryAttr,
                Response_t &response);
 
+    /** @brief send a search query, decode matches into user rows
+      *
+      * Matches are decoded straight into bound members of rows, the
+      * response gets everything else (schema, totals, word statistics,
+      * stats) and no entries. Rows already in the vector are reused.
+      *
+      * @param query list of words to search for
+      * @param queryAttr query configuration
+      * @param binding attributes bound to members of Row_t
+      * @param rows output parameter - one row per match
+      * @param response output parameter - response without entries
+      * @throws ValueTypeError_t when binding doesn't fit the response
+      * @throws SphinxClientError_t on any communication or parsing error
+      * @see RowBinding_t
+      */
+    template<class Row_t>
+    void query(const std::string& query,
+               const SearchConfig_t &queryAttr,
+               const RowBinding_t<Row_t> &binding,
+               std::vector<Row_t> &rows,
+               Response_t &response)
+    {
+        RowVector_t<Row_t> sink(binding, rows);
+        search(query, queryAttr, response, &sink);
+    }
+
+    /** @brief send a search query, decode document ids of matches only
+      *
+      * Attributes and weights are stepped over, the response gets
+      * everything else (schema, totals, word statistics, stats) and no
+      * entries. Memory of ids is reused.
+      *
+      * @param query list of words to search for
+      * @param queryAttr query configuration
+      * @param ids output parameter - ids of the matches
+      * @param response output parameter - response without entries
+      * @throws SphinxClientError_t on any communication or parsing error
+      * @see DocumentIdSet_t
+      */
+    void query(const std::string& query,
+               const SearchConfig_t &queryAttr,
+               DocumentIdSet_t &ids,
+               Response_t &response);
+
     /** @brief send a search multi-query to the searchd
       *
       * Sends a search multi-query to the sphinx searchd and fills the response
       * structure vector. On exception the content of the response is undefined,
       * any previous structure content is invalidated anyway.
       *
+      * The vector is resized to the query count, responses it already
+      * holds are decoded over and their memory is reused.
+      *
       * @param query initialized MultiQuery_t object witg queries added
       * @param response output parameter - response structure
       * @throws SphinxClientError_t on any communication or parsing error
@@ -874,6 +1197,7 @@ public:
       * Multiquery divides queries into similar multiquery-efficient groups. These
       * groups are sent simoultanously in parrallel connections to searchd.
       * @see QueryMachine_t
+      * Responses are reused as with MultiQuery_t.
       *
       * @param query initialized MultiQueryOpt_t object witg queries added
       * @param response output parameter - response structure
@@ -910,9 +1234,92 @@ public:
         const std::string &query,
         bool getWordStatistics = false);
 
+    /** @brief registers observer of query machine events
+      *
+      * Observer is not owned, it must outlive the calls it observes.
+      *
+      * @param observer observer or null to unregister
+      * @see QueryObserver_t
+      */
+    void setObserver(QueryObserver_t *observer) { this->observer = observer; }
+
+    /** @brief registers slow query log for search calls
+      *
+      * Log is not owned, it must outlive the calls it logs.
+      *
+      * @param slowLog log or null to unregister
+      * @see SlowQueryLog_t
+      */
+    void setSlowQueryLog(SlowQueryLog_t *slowLog) { this->slowLog = slowLog; }
+
+    /** @brief registers capture of calls for replay
+      *
+      * Capture is not owned, it must outlive the calls it captures.
+      *
+      * @param capture capture or null to unregister
+      * @see RequestCapture_t
+      */
+    void setCapture(RequestCapture_t *capture) { this->capture = capture; }
+
+    /** @brief sets number of threads decoding multi-query responses
+      *
+      * Sub-responses of a multi-query (or of one group of optimised
+      * multi-query) are decoded in parallel on a process-wide pool
+      * shared by all clients, the calling thread included. Small
+      * responses are always decoded serially, more threads than CPUs
+      * only add overhead.
+      *
+      * @param threads decoding threads, 0 or 1 decodes serially
+      *        (default)
+      */
+    void setParseThreads(size_t threads) { parseThreads = threads; }
+
 protected:
+    /** @brief sends a search query, decodes matches into response
+      *        entries or into rows of sink when given
+      */
+    void search(const std::string &query, const SearchConfig_t &queryAttr,
+                Response_t &response, RowSink_t *rows);
+
+    /** @brief queues completed search call to slow query log
+      * @param flags SlowQueryFlag_t bits chosen by the log
+      * @param elapsed duration of the call (microseconds)
+      * @param stats timings of the slowest request
+      * @param query query text (empty for multi-queries)
+      * @param config configuration summary
+      * @param requests serialized requests sent
+      */
+    void logSlowQuery(uint32_t flags, uint32_t elapsed,
+                      const QueryStats_t &stats, const std::string &query,
+                      const std::string &config,
+                      const std::vector<const Query_t *> &requests);
+
+    /** @brief queues completed call to capture
+      * @param call request bodies of the call
+      * @param command searchd command
+      * @param version command version
+      * @param elapsed duration of the call (microseconds)
+      */
+    void captureCall(CapturedCall_t &call, unsigned short command,
+                     unsigned short version, uint32_t elapsed);
+
     // -------- connection settings -----------------
     ConnectionConfig_t connection;
+
+    /// endpoint index in metrics registry
+    size_t metricsEndpoint;
+
+    /// observer of query machine events (not owned)
+    QueryObserver_t *observer;
+
+    /// slow query log (not owned)
+    SlowQueryLog_t *slowLog;
+
+    /// capture of calls for replay (not owned)
+    RequestCapture_t *capture;
+
+    /// threads decoding multi-query responses
+    size_t parseThreads;
 };//class
 
 
@@ -58,8 +58,17 @@ struct Query_t
     unsigned int dataSize;
     bool error;
     bool convertEndian;
+    /// data buffer is allocated by this query (false for read views)
+    bool ownsData;
 
     Query_t(unsigned int size=1024);
+    /** @brief read view over bytes start .. end of source buffer
+      *
+      * The buffer is borrowed, it must outlive the view and not change
+      * meanwhile. Views read with their own position, so several
+      * threads can read parts of one buffer; they are not written to.
+      */
+    Query_t(const Query_t &source, unsigned int start, unsigned int end);
     ~Query_t();
 
     Query_t &operator << (unsigned short);
@@ -75,12 +84,38 @@ struct Query_t
     Query_t &operator >> (unsigned short &);
     Query_t &operator >> (std::string &);
 
+    /** @brief reads count values at once (MVA runs, id arrays)
+      *
+      * Bounds are checked once, nothing is read when data is short.
+      * Byte order conversion goes thru SIMD kernels where available.
+      */
+    Query_t &read(uint32_t *values, unsigned int count);
+    Query_t &read(uint64_t *values, unsigned int count);
+
     Query_t &operator = (const Query_t &);
     Query_t(const Query_t &source);
 
     bool operator ! () const { return error; }
 
     void doubleSizeBuffer();
+    /** @brief makes sure the buffer can hold another length bytes
+      *        without reallocation
+      * @throws ClientUsageError_t when the size exceeds unsigned int
+      */
+    void reserve(unsigned int length);
+    /** @brief appends raw bytes (no endian conversion)
+      * @param buffer bytes to append
+      * @param length count of bytes
+      */
+    Query_t &append(const void *buffer, unsigned int length);
+    /** @brief appends count values at once (filter values, id arrays)
+      *
+      * Buffer grows once, byte order conversion goes thru SIMD kernels
+      * where available.
+      * @throws ClientUsageError_t when the size exceeds unsigned int
+      */
+    Query_t &appendArray(const uint32_t *values, unsigned int count);
+    Query_t &appendArray(const uint64_t *values, unsigned int count);
     void clear();
     unsigned int getLength() const { return dataEndPtr-dataStartPtr; }
 
@@ -41,6 +41,7 @@
 #define __SPHINXVALUE_H__
 
 #include <vector>
+#include <stddef.h>
 #include <sphinxclient/error.h>
 #include <stdint.h>
 
@@ -59,6 +60,7 @@ enum ValueType_t {
 };
 
 class ValueBase_t;
+class Arena_t;
 
 /** @brief Generic value type of sphinx attribute
  *
@@ -86,6 +88,28 @@ public:
     //! @brief initializes Value_t as string type
     Value_t(const std::string &v);
 
+    /** @brief initializers placing the value into an arena
+     *
+     *  Value data are allocated from given arena (or from the heap when
+     *  arena is 0) and must be destroyed before the arena is cleared.
+     *  Copies of such a value are always allocated on the heap.
+     */
+    Value_t(uint32_t v, Arena_t *arena);
+    Value_t(float v, Arena_t *arena);
+    Value_t(uint64_t v, Arena_t *arena);
+    Value_t(const std::string &v, Arena_t *arena);
+    //! @brief initializes Value_t as vector type, takes over content of v
+    Value_t(std::vector<Value_t> &v, Arena_t *arena);
+
+    /** @brief initializes Value_t as vector type from contiguous values
+     *
+     *  Values are kept in one array (allocated from arena when given),
+     *  see getUInt32Array(). Elements of the std::vector<Value_t> view
+     *  are created on its first access.
+     */
+    Value_t(const uint32_t *values, size_t count, Arena_t *arena);
+    Value_t(const uint64_t *values, size_t count, Arena_t *arena);
+
     ~Value_t(){ clear(); }
 
     //! @brief copy constructor, that performs deep copy of *value pointer
@@ -93,6 +117,9 @@ public:
     //! @brief assignment, that performs deep copy of *value pointer
     Value_t & operator = (const Value_t&);
 
+    //! @brief exchanges content with another value, no copying involved
+    void swap(Value_t &v) { ValueBase_t *tmp = value; value = v.value; v.value = tmp; }
+
     /** @brief check if contains a valid value.
      */
     inline bool isValid() const { return value; }
@@ -105,6 +132,20 @@ public:
      */
     ValueType_t getValueType() const;
 
+    /** @brief contiguous values of vector created from uint32_t array
+     *
+     *  MVA attributes of search responses are created this way.
+     *
+     *  @param count set to the number of values
+     *  @return values, 0 when the value doesn't hold uint32_t array
+     */
+    const uint32_t *getUInt32Array(size_t &count) const;
+
+    /** @brief contiguous values of vector created from uint64_t array
+     *  @see getUInt32Array()
+     */
+    const uint64_t *getUInt64Array(size_t &count) const;
+
     /** @brief overloaded implicit conversion operator to uint32_t
      *
      *  Returns value as uint32_t. If the current value type is other than
@@ -0,0 +1,153 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Sphinx::Arena_t function definitions - chunk list allocator
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <sphinxclient/arena.h>
+
+#include <new>
+#include <algorithm>
+#include <stdlib.h>
+
+/// alignment of all allocations (enough for any fundamental type)
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(x) (((x) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+struct Sphinx::Arena_t::Chunk_t
+{
+    /// next (older) chunk
+    Chunk_t *next;
+    /// usable size of the chunk (without header)
+    size_t size;
+
+    /// start of usable memory
+    char *begin() {
+        return reinterpret_cast<char *>(this) + ARENA_ROUND(sizeof(Chunk_t));
+    }
+};
+
+Sphinx::Arena_t::Arena_t(size_t chunkSize)
+    : chunks(0), ptr(0), end(0), chunkSize(chunkSize)
+{}
+
+Sphinx::Arena_t::Arena_t(const Arena_t &from)
+    : chunks(0), ptr(0), end(0), chunkSize(from.chunkSize)
+{}
+
+Sphinx::Arena_t &Sphinx::Arena_t::operator=(const Arena_t &)
+{
+    // memory is owned by this object, nothing to copy
+    return *this;
+}
+
+Sphinx::Arena_t::~Arena_t()
+{
+    while (chunks) {
+        Chunk_t *next = chunks->next;
+        free(chunks);
+        chunks = next;
+    }
+}
+
+void Sphinx::Arena_t::addChunk(size_t size)
+{
+    if (size < chunkSize) size = chunkSize;
+
+    void *mem = malloc(ARENA_ROUND(sizeof(Chunk_t)) + size);
+    if (!mem) throw std::bad_alloc();
+
+    Chunk_t *chunk = static_cast<Chunk_t *>(mem);
+    chunk->size = size;
+    chunk->next = chunks;
+    chunks = chunk;
+
+    ptr = chunk->begin();
+    end = ptr + size;
+}
+
+void *Sphinx::Arena_t::alloc(size_t size)
+{
+    size = ARENA_ROUND(size);
+    if (size > (size_t)(end - ptr))
+        addChunk(size);
+
+    void *result = ptr;
+    ptr += size;
+    return result;
+}
+
+void Sphinx::Arena_t::clear()
+{
+    if (!chunks) return;
+
+    if (chunks->next) {
+        // replace all chunks by one big enough for all of them
+        size_t total = 0;
+        while (chunks) {
+            Chunk_t *next = chunks->next;
+            total += chunks->size;
+            free(chunks);
+            chunks = next;
+        }
+        ptr = end = 0;
+        try {
+            addChunk(total);
+        } catch (const std::bad_alloc &) {
+            // next alloc() gets a chunk as usual
+        }
+        return;
+    }
+
+    // rewind the only one
+    ptr = chunks->begin();
+    end = ptr + chunks->size;
+}
+
+void Sphinx::Arena_t::swap(Arena_t &other)
+{
+    std::swap(chunks, other.chunks);
+    std::swap(ptr, other.ptr);
+    std::swap(end, other.end);
+    std::swap(chunkSize, other.chunkSize);
+}
+
+size_t Sphinx::Arena_t::getChunkCount() const
+{
+    size_t count = 0;
+    for (Chunk_t *chunk = chunks; chunk; chunk = chunk->next)
+        ++count;
+    return count;
+}
@@ -0,0 +1,215 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Bulk decoding of network byte order arrays
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include "bulkdecode.h"
+#include "cpudispatch.h"
+
+#include <string.h>
+#include <arpa/inet.h>
+#include <bits/byteswap.h>
+
+// byte shuffles assume little endian host
+#if defined(SPHINX_DISPATCH_X86) && __BYTE_ORDER == __LITTLE_ENDIAN
+#define SPHINX_BULK_X86
+#endif
+
+namespace {
+
+// byte swap is its own inverse, the same kernels encode and decode,
+// neither pointer needs to be aligned
+typedef void (*Swap_t)(unsigned char *, const unsigned char *, size_t);
+
+void swap32Scalar(unsigned char *dst, const unsigned char *src, size_t count)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t value;
+        memcpy(&value, src + 4 * i, sizeof(value));
+        value = __bswap_32(value);
+        memcpy(dst + 4 * i, &value, sizeof(value));
+    }
+#else
+    memmove(dst, src, count * sizeof(uint32_t));
+#endif
+}//konec fce
+
+void swap64Scalar(unsigned char *dst, const unsigned char *src, size_t count)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value;
+        memcpy(&value, src + 8 * i, sizeof(value));
+        value = __bswap_64(value);
+        memcpy(dst + 8 * i, &value, sizeof(value));
+    }
+#else
+    memmove(dst, src, count * sizeof(uint64_t));
+#endif
+}//konec fce
+
+#ifdef SPHINX_BULK_X86
+
+__attribute__((target("ssse3")))
+void swap32Ssse3(unsigned char *dst, const unsigned char *src, size_t count)
+{
+    const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+                                      4, 5, 6, 7, 0, 1, 2, 3);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+        _mm_storeu_si128((__m128i *)(dst + 4 * i), _mm_shuffle_epi8(v, mask));
+    }
+    swap32Scalar(dst + 4 * i, src + 4 * i, count - i);
+}//konec fce
+
+__attribute__((target("ssse3")))
+void swap64Ssse3(unsigned char *dst, const unsigned char *src, size_t count)
+{
+    const __m128i mask = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15,
+                                      0, 1, 2, 3, 4, 5, 6, 7);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + 8 * i));
+        _mm_storeu_si128((__m128i *)(dst + 8 * i), _mm_shuffle_epi8(v, mask));
+    }
+    swap64Scalar(dst + 8 * i, src + 8 * i, count - i);
+}//konec fce
+
+__attribute__((target("avx2")))
+void swap32Avx2(unsigned char *dst, const unsigned char *src, size_t count)
+{
+    // vpshufb shuffles within 128bit lanes, same mask in both
+    const __m256i mask = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + 4 * i + 32));
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i),
+                            _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i + 32),
+                            _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i),
+                            _mm256_shuffle_epi8(a, mask));
+    }
+    swap32Scalar(dst + 4 * i, src + 4 * i, count - i);
+}//konec fce
+
+__attribute__((target("avx2")))
+void swap64Avx2(unsigned char *dst, const unsigned char *src, size_t count)
+{
+    const __m256i mask = _mm256_set_epi8(
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + 8 * i));
+        _mm256_storeu_si256((__m256i *)(dst + 8 * i),
+                            _mm256_shuffle_epi8(a, mask));
+    }
+    swap64Scalar(dst + 8 * i, src + 8 * i, count - i);
+}//konec fce
+
+#endif
+
+/// one implementation of the kernels
+struct Implementation_t
+{
+    const char *name;
+    Swap_t swap32;
+    Swap_t swap64;
+};
+
+const Implementation_t implementations[] = {
+#ifdef SPHINX_BULK_X86
+    {"avx2", swap32Avx2, swap64Avx2},
+    {"ssse3", swap32Ssse3, swap64Ssse3},
+#endif
+    {"scalar", swap32Scalar, swap64Scalar}
+};
+
+const size_t implementationCount
+    = sizeof(implementations) / sizeof(implementations[0]);
+
+/// implementation in use
+Sphinx::CpuDispatch_t<Implementation_t> dispatch
+    = {implementations, implementationCount, 0};
+
+}//namespace
+
+void Sphinx::decodeNetwork32(uint32_t *dst, const unsigned char *src,
+                             size_t count)
+{
+    dispatch.select().swap32(reinterpret_cast<unsigned char *>(dst), src,
+                             count);
+}//konec fce
+
+void Sphinx::decodeNetwork64(uint64_t *dst, const unsigned char *src,
+                             size_t count)
+{
+    dispatch.select().swap64(reinterpret_cast<unsigned char *>(dst), src,
+                             count);
+}//konec fce
+
+void Sphinx::encodeNetwork32(unsigned char *dst, const uint32_t *src,
+                             size_t count)
+{
+    dispatch.select().swap32(dst, reinterpret_cast<const unsigned char *>(src),
+                             count);
+}//konec fce
+
+void Sphinx::encodeNetwork64(unsigned char *dst, const uint64_t *src,
+                             size_t count)
+{
+    dispatch.select().swap64(dst, reinterpret_cast<const unsigned char *>(src),
+                             count);
+}//konec fce
+
+const char *Sphinx::getBulkDecodeImplementation()
+{
+    return dispatch.select().name;
+}//konec fce
+
+bool Sphinx::setBulkDecodeImplementation(const char *name)
+{
+    return dispatch.force(name);
+}//konec fce
@@ -0,0 +1,83 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Bulk decoding and encoding of network byte order arrays (MVA values,
+ * filter values) with SSSE3/AVX2 kernels selected at runtime
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file bulkdecode.h
+
+#ifndef __BULKDECODE_H__
+#define __BULKDECODE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+/** @brief copies count big endian 32bit values into host order array
+ *
+ *  Source needn't be aligned. Implementation (scalar, SSSE3 or AVX2)
+ *  is chosen by CPU features on the first call.
+ */
+void decodeNetwork32(uint32_t *dst, const unsigned char *src, size_t count);
+
+/** @brief copies count big endian 64bit values into host order array
+ */
+void decodeNetwork64(uint64_t *dst, const unsigned char *src, size_t count);
+
+/** @brief copies count host order 32bit values as big endian
+ *
+ *  Destination needn't be aligned, same kernels as decodeNetwork32().
+ */
+void encodeNetwork32(unsigned char *dst, const uint32_t *src, size_t count);
+
+/** @brief copies count host order 64bit values as big endian
+ */
+void encodeNetwork64(unsigned char *dst, const uint64_t *src, size_t count);
+
+/** @brief name of the implementation in use ("scalar", "ssse3", "avx2")
+ */
+const char *getBulkDecodeImplementation();
+
+/** @brief forces implementation (tests and benchmarks)
+ *  @param name implementation name, 0 selects the best one again
+ *  @return false when the implementation is unknown or the CPU lacks it
+ */
+bool setBulkDecodeImplementation(const char *name);
+
+}//namespace
+
+#endif
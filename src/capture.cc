@@ -0,0 +1,152 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Capture of client calls for replay
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <sphinxclient/capture.h>
+#include <sphinxclient/error.h>
+#include "recordfile.h"
+
+namespace {
+
+const Sphinx::RecordFormat_t CAPTURE_FORMAT = {
+    "SPHXCAPT", 1, "capture file"
+};
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+Sphinx::CaptureConfig_t::CaptureConfig_t(const std::string &path)
+    : path(path), maxFileSize(uint64_t(1) << 30), maxFiles(4),
+      queueSize(16384)
+{}
+
+Sphinx::CapturedCall_t::CapturedCall_t()
+    : timestamp(0), elapsed(0), command(0), version(0)
+{}
+
+void Sphinx::CapturedCall_t::addRequest(const Query_t &body,
+                                        uint32_t queryCount)
+{
+    requests.push_back(CapturedRequest_t());
+    requests.back().queryCount = queryCount;
+    requests.back().body.assign(
+        reinterpret_cast<const char *>(body.data + body.dataStartPtr),
+        body.getLength());
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::RequestCapture_t::RequestCapture_t(const CaptureConfig_t &config)
+    : writer(new RecordWriter_t(CAPTURE_FORMAT, config.path,
+                                config.maxFileSize, config.maxFiles,
+                                config.queueSize))
+{}//konstruktor
+
+Sphinx::RequestCapture_t::~RequestCapture_t()
+{
+    delete writer;
+}//destruktor
+
+void Sphinx::RequestCapture_t::submit(const CapturedCall_t &call)
+{
+    Query_t data;
+    data.convertEndian = true;
+    data << call.timestamp << call.elapsed
+         << (unsigned short) call.command << (unsigned short) call.version
+         << uint32_t(call.requests.size());
+    for (size_t i = 0; i < call.requests.size(); ++i)
+        data << call.requests[i].queryCount << call.requests[i].body;
+
+    writer->submit(data);
+}//konec fce
+
+void Sphinx::RequestCapture_t::flush()
+{
+    writer->flush();
+}//konec fce
+
+uint64_t Sphinx::RequestCapture_t::getWritten() const
+{
+    return writer->getWritten();
+}//konec fce
+
+uint64_t Sphinx::RequestCapture_t::getDropped() const
+{
+    return writer->getDropped();
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::RequestCaptureReader_t::RequestCaptureReader_t(const std::string &path)
+    : reader(new RecordReader_t(CAPTURE_FORMAT, path))
+{}//konstruktor
+
+Sphinx::RequestCaptureReader_t::~RequestCaptureReader_t()
+{
+    delete reader;
+}//destruktor
+
+bool Sphinx::RequestCaptureReader_t::next(CapturedCall_t &call)
+{
+    Query_t data;
+    if (!reader->next(data)) return false;
+
+    unsigned short command, version;
+    uint32_t requestCount;
+    if (!(readField(data, call.timestamp)
+          && readField(data, call.elapsed)
+          && readField(data, command)
+          && readField(data, version)
+          && readField(data, requestCount)))
+    {
+        return false;
+    }
+    call.command = command;
+    call.version = version;
+
+    if (requestCount > data.getLength()) return false;
+    call.requests.resize(requestCount);
+    for (uint32_t i = 0; i < requestCount; ++i) {
+        if (!(readField(data, call.requests[i].queryCount)
+              && readField(data, call.requests[i].body)))
+        {
+            return false;
+        }
+    }
+    return true;
+}//konec fce
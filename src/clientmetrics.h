@@ -0,0 +1,124 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Recording side of the library-wide metrics registry
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file clientmetrics.h
+
+#ifndef __CLIENTMETRICS_H__
+#define __CLIENTMETRICS_H__
+
+#include <string>
+#include <stdint.h>
+
+#include "timer.h"
+
+namespace Sphinx
+{
+
+/** @brief Commands counted by metrics registry
+ */
+enum MetricsCommand_t {
+    METRICS_SEARCH         = 0,
+    METRICS_UPDATE         = 1,
+    METRICS_KEYWORDS       = 2,
+    METRICS_COMMAND_COUNT  = 3
+};
+
+namespace Metrics
+{
+
+/** @brief finds or registers endpoint label
+ *
+ *  Registered endpoints are never released, when the registry is full
+ *  the shared "other" endpoint is returned.
+ *
+ *  @param endpoint host:port or unix://path
+ *  @return endpoint index for CallMetrics_t
+ */
+size_t registerEndpoint(const std::string &endpoint);
+
+/** @brief counts connect retry after connect timeout
+ */
+void connectRetry();
+
+/** @brief counts timeout of query machine
+ *  @param state QueryState_t of timed out query
+ */
+void timeout(int state);
+
+}//namespace
+
+/** @brief Records metrics of one Client_t call
+ *
+ *  Counts request and in-flight call on construction, latency and
+ *  response size on destruction. Call failed() from catch handler of
+ *  the call to count the exception being handled.
+ */
+class CallMetrics_t
+{
+public:
+    CallMetrics_t(MetricsCommand_t command, size_t endpoint);
+    ~CallMetrics_t();
+
+    /** @brief counts currently handled exception by its class
+     */
+    void failed();
+
+    /** @brief adds bytes to the response size
+     */
+    void addResponseSize(uint64_t bytes) { responseSize += bytes; }
+
+    /** @brief time since construction (microseconds)
+     */
+    uint32_t getElapsed()
+    {
+        ferTimerStop(&timer);
+        return ferTimerElapsedInUs(&timer);
+    }
+
+private:
+    CallMetrics_t(const CallMetrics_t &);
+    CallMetrics_t &operator=(const CallMetrics_t &);
+
+    MetricsCommand_t command;
+    size_t endpoint;
+    uint64_t responseSize;
+    fer_timer_t timer;
+};
+
+}//namespace
+
+#endif
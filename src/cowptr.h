@@ -0,0 +1,120 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Reference counted copy-on-write pointer used for sharing
+ * configuration data between copies.
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file cowptr.h
+
+#ifndef __SPHINX_COWPTR_H__
+#define __SPHINX_COWPTR_H__
+
+namespace Sphinx
+{
+
+/** @brief Copy-on-write pointer
+ *
+ * Copies of the pointer share one instance of T. Read access goes thru
+ * operator->, write access thru detach(), which makes private copy of T
+ * when it is shared. Reference counting is atomic, so copies can be
+ * used from different threads; one CowPtr_t object itself isn't thread
+ * safe.
+ */
+template <class T>
+class CowPtr_t
+{
+    /// shared block - data and reference count
+    struct Shared_t {
+        Shared_t() : data(), refs(1) {}
+        Shared_t(const T &data) : data(data), refs(1) {}
+
+        T data;
+        int refs;
+    };
+
+public:
+    CowPtr_t() : p(new Shared_t()) {}
+
+    explicit CowPtr_t(const T &data) : p(new Shared_t(data)) {}
+
+    CowPtr_t(const CowPtr_t &from) : p(from.p) {
+        __sync_add_and_fetch(&p->refs, 1);
+    }
+
+    CowPtr_t &operator=(const CowPtr_t &from) {
+        if (p != from.p) {
+            __sync_add_and_fetch(&from.p->refs, 1);
+            release();
+            p = from.p;
+        }
+        return *this;
+    }
+
+    ~CowPtr_t() { release(); }
+
+    //! @brief read access to shared data
+    const T *operator->() const { return &p->data; }
+    //! @brief read access to shared data
+    const T &operator*() const { return p->data; }
+
+    /** @brief write access, makes private copy of shared data
+     *  @return data owned by this pointer only
+     */
+    T &detach() {
+        // only the owner can increase the count of sole owned block
+        if (p->refs > 1) {
+            Shared_t *copy = new Shared_t(p->data);
+            release();
+            p = copy;
+        }
+        return p->data;
+    }
+
+    //! @brief whether the data is shared with another pointer
+    bool isShared() const { return p->refs > 1; }
+
+private:
+    void release() {
+        if (__sync_sub_and_fetch(&p->refs, 1) == 0)
+            delete p;
+    }
+
+    Shared_t *p;
+};
+
+}//namespace
+
+#endif
+
@@ -0,0 +1,129 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Runtime selection of kernels compiled for x86 targets
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file cpudispatch.h
+
+#ifndef __CPUDISPATCH_H__
+#define __CPUDISPATCH_H__
+
+#include <stddef.h>
+#include <string.h>
+
+// x86 kernels are compiled for their own target (function attribute)
+// and selected by cpuid, the rest of the library keeps the baseline
+// instruction set
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) \
+    && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SPHINX_DISPATCH_X86
+#include <immintrin.h>
+#endif
+
+namespace Sphinx
+{
+
+/** @brief whether the CPU runs kernels compiled for named target
+ *
+ *  Targets other than the known x86 ones (e.g. "scalar") need nothing.
+ */
+inline bool cpuSupports(const char *target)
+{
+#ifdef SPHINX_DISPATCH_X86
+    __builtin_cpu_init();
+    if (!strcmp(target, "avx2")) return __builtin_cpu_supports("avx2");
+    if (!strcmp(target, "sse4.1")) return __builtin_cpu_supports("sse4.1");
+    if (!strcmp(target, "ssse3")) return __builtin_cpu_supports("ssse3");
+#endif
+    return true;
+}//konec fce
+
+/** @brief chooses one of the implementations of a kernel set
+ *
+ *  Implementation_t holds the name of its target and the kernels,
+ *  table lists them best first and ends with the portable one. It is
+ *  an aggregate so that a namespace scope instance is initialized
+ *  statically, before any constructor could call the kernels.
+ */
+template <typename Implementation_t>
+struct CpuDispatch_t
+{
+    //! @brief implementation in use, the best supported one by default
+    const Implementation_t &select()
+    {
+        const Implementation_t *implementation = current;
+        if (implementation) return *implementation;
+
+        implementation = &implementations[count - 1];
+        for (size_t i = 0; i < count; ++i) {
+            if (cpuSupports(implementations[i].name)) {
+                implementation = &implementations[i];
+                break;
+            }
+        }
+        __sync_synchronize();
+        current = implementation;
+        return *implementation;
+    }
+
+    /** @brief forces named implementation, 0 restores the default
+     *  @return false when unknown or unsupported by the CPU
+     */
+    bool force(const char *name)
+    {
+        if (!name) {
+            current = 0;
+            select();
+            return true;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (!strcmp(implementations[i].name, name)) {
+                if (!cpuSupports(name)) return false;
+                current = &implementations[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const Implementation_t *implementations;
+    size_t count;
+    /// chosen on first call (racing threads pick the same one)
+    const Implementation_t *volatile current;
+};
+
+}//namespace
+
+#endif
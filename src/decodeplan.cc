@@ -0,0 +1,575 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Row decoder compiled from the attribute schema of a response
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include "decodeplan.h"
+#include <sphinxclient/error.h>
+#include <sphinxclient/globals.h>
+
+#include <algorithm>
+#include <string.h>
+#include <arpa/inet.h>
+#include <endian.h>
+#include <byteswap.h>
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    #define decode_ntoh64(x) bswap_64(x)
+#else
+    #define decode_ntoh64(x) (x)
+#endif
+
+namespace {
+
+/// loads 32 bit word at read position, bounds are checked by caller
+inline uint32_t load32(Sphinx::Query_t &data)
+{
+    uint32_t value;
+    memcpy(&value, data.data + data.dataStartPtr, sizeof(value));
+    data.dataStartPtr += sizeof(value);
+    return data.convertEndian ? ntohl(value) : value;
+}//konec fce
+
+/// loads 64 bit word at read position, bounds are checked by caller
+inline uint64_t load64(Sphinx::Query_t &data)
+{
+    uint64_t value;
+    memcpy(&value, data.data + data.dataStartPtr, sizeof(value));
+    data.dataStartPtr += sizeof(value);
+    return data.convertEndian ? decode_ntoh64(value) : value;
+}//konec fce
+
+void decodeUInt32(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                  Sphinx::Value_t &value)
+{
+    Sphinx::Value_t(load32(data), scratch.arena).swap(value);
+}//konec fce
+
+void decodeUInt64(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                  Sphinx::Value_t &value)
+{
+    Sphinx::Value_t(load64(data), scratch.arena).swap(value);
+}//konec fce
+
+void decodeFloat(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                 Sphinx::Value_t &value)
+{
+    uint32_t word = load32(data);
+    float floatValue;
+    memcpy(&floatValue, &word, sizeof(floatValue));
+    Sphinx::Value_t(floatValue, scratch.arena).swap(value);
+}//konec fce
+
+void decodeString(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                  Sphinx::Value_t &value)
+{
+    if (!(data >> scratch.text))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - string exceeds data length.");
+    Sphinx::Value_t(scratch.text, scratch.arena).swap(value);
+}//konec fce
+
+/** @brief decodes run of count MVA values at once into contiguous value
+ *  @param scratch decoding buffer reused for the whole response
+ */
+template<class T>
+void decodeMultiValues(Sphinx::Query_t &data, uint32_t count,
+                       std::vector<T> &buffer, Sphinx::Arena_t *arena,
+                       Sphinx::Value_t &value)
+{
+    if (count > data.getLength() / sizeof(T))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - MVA exceeds data length.");
+
+    if (buffer.size() < count) buffer.resize(count);
+    data.read(count ? &buffer[0] : 0, count);
+
+    Sphinx::Value_t(count ? &buffer[0] : 0, count, arena).swap(value);
+}//konec fce
+
+void decodeMulti32(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                   Sphinx::Value_t &value)
+{
+    uint32_t count;
+    if (!(data >> count))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - MVA exceeds data length.");
+    decodeMultiValues(data, count, scratch.mva32, scratch.arena, value);
+}//konec fce
+
+void decodeMulti64(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                   Sphinx::Value_t &value)
+{
+    uint32_t count;
+    if (!(data >> count))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - MVA exceeds data length.");
+    // the count is 32 bit word count instead of value count
+    decodeMultiValues(data, count >> 1, scratch.mva64, scratch.arena, value);
+}//konec fce
+
+void skip32(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &,
+            Sphinx::Value_t &)
+{
+    data.dataStartPtr += sizeof(uint32_t);
+}//konec fce
+
+void skip64(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &,
+            Sphinx::Value_t &)
+{
+    data.dataStartPtr += sizeof(uint64_t);
+}//konec fce
+
+/// steps over count items of size, the count precedes them
+template<unsigned int size, unsigned int countShift>
+void skipCounted(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &,
+                 Sphinx::Value_t &)
+{
+    uint32_t count;
+    if (!(data >> count) || (count >> countShift) > data.getLength() / size)
+        throw Sphinx::MessageError_t(
+                "Error parsing response - match exceeds data length.");
+    data.dataStartPtr += (count >> countShift) * size;
+}//konec fce
+
+/** @brief picks decoder stepping over attribute of type left out by
+ *         projection
+ */
+Sphinx::AttributeDecoder_t attributeSkipper(uint32_t type)
+{
+    switch (type) {
+        case Sphinx::SPH_ATTR_BIGINT:
+            return skip64;
+        case Sphinx::SPH_ATTR_MULTI:
+        case Sphinx::SPH_ATTR_MULTI_FLAG:
+            return skipCounted<sizeof(uint32_t), 0>;
+        case Sphinx::SPH_ATTR_MULTI64:
+            // the count is 32 bit word count instead of value count
+            return skipCounted<sizeof(uint64_t), 1>;
+        case Sphinx::SPH_ATTR_STRING:
+            return skipCounted<1, 0>;
+        default:
+            return skip32;
+    }//switch
+}//konec fce
+
+/** @brief picks decoder for attribute type
+ *  @param size set to the byte size of fixed width type, else 0
+ */
+Sphinx::AttributeDecoder_t attributeDecoder(uint32_t type, unsigned int &size)
+{
+    switch (type) {
+        case Sphinx::SPH_ATTR_FLOAT:
+            size = sizeof(uint32_t);
+            return decodeFloat;
+        case Sphinx::SPH_ATTR_BIGINT:
+            size = sizeof(uint64_t);
+            return decodeUInt64;
+        case Sphinx::SPH_ATTR_MULTI:
+        case Sphinx::SPH_ATTR_MULTI_FLAG:
+            size = 0;
+            return decodeMulti32;
+        case Sphinx::SPH_ATTR_MULTI64:
+            size = 0;
+            return decodeMulti64;
+        case Sphinx::SPH_ATTR_STRING:
+            size = 0;
+            return decodeString;
+        default:
+            size = sizeof(uint32_t);
+            return decodeUInt32;
+    }//switch
+}//konec fce
+
+/** @brief item size of variable width type as counted in data
+ */
+void variableItem(uint32_t type, unsigned int &itemSize,
+                  unsigned int &countShift)
+{
+    switch (type) {
+        case Sphinx::SPH_ATTR_MULTI:
+        case Sphinx::SPH_ATTR_MULTI_FLAG:
+            itemSize = sizeof(uint32_t);
+            countShift = 0;
+            break;
+        case Sphinx::SPH_ATTR_MULTI64:
+            // the count is 32 bit word count instead of value count
+            itemSize = sizeof(uint64_t);
+            countShift = 1;
+            break;
+        default:
+            itemSize = 1;
+            countShift = 0;
+            break;
+    }//switch
+}//konec fce
+
+/// value passed to skippers, they never touch it
+Sphinx::Value_t unusedValue;
+
+void rowUInt32(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &, void *row,
+               const Sphinx::RowPlan_t::Step_t &step)
+{
+    uint32_t value = load32(data);
+    uint64_t wide = value;
+    for (size_t i = 0; i < step.fields.size(); ++i) {
+        const Sphinx::RowBindingBase_t::Field_t &field = *step.fields[i];
+        field.store(row, field.member, field.type == Sphinx::BOUND_UINT32
+                                       ? static_cast<const void *>(&value)
+                                       : static_cast<const void *>(&wide));
+    }
+}//konec fce
+
+void rowUInt64(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &, void *row,
+               const Sphinx::RowPlan_t::Step_t &step)
+{
+    uint64_t value = load64(data);
+    for (size_t i = 0; i < step.fields.size(); ++i)
+        step.fields[i]->store(row, step.fields[i]->member, &value);
+}//konec fce
+
+void rowFloat(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &, void *row,
+              const Sphinx::RowPlan_t::Step_t &step)
+{
+    uint32_t word = load32(data);
+    float value;
+    memcpy(&value, &word, sizeof(value));
+    for (size_t i = 0; i < step.fields.size(); ++i)
+        step.fields[i]->store(row, step.fields[i]->member, &value);
+}//konec fce
+
+void rowString(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+               void *row, const Sphinx::RowPlan_t::Step_t &step)
+{
+    if (!(data >> scratch.text))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - string exceeds data length.");
+    for (size_t i = 0; i < step.fields.size(); ++i)
+        step.fields[i]->store(row, step.fields[i]->member, &scratch.text);
+}//konec fce
+
+/// reads count values of MVA run into buffer of exactly that size
+template<class T>
+void readMultiValues(Sphinx::Query_t &data, uint32_t count,
+                     std::vector<T> &buffer)
+{
+    if (count > data.getLength() / sizeof(T))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - MVA exceeds data length.");
+    buffer.resize(count);
+    data.read(count ? &buffer[0] : 0, count);
+}//konec fce
+
+void rowMulti32(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                void *row, const Sphinx::RowPlan_t::Step_t &step)
+{
+    uint32_t count;
+    if (!(data >> count))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - MVA exceeds data length.");
+    readMultiValues(data, count, scratch.mva32);
+    for (size_t i = 0; i < step.fields.size(); ++i) {
+        const Sphinx::RowBindingBase_t::Field_t &field = *step.fields[i];
+        if (field.type == Sphinx::BOUND_UINT32_ARRAY) {
+            field.store(row, field.member, &scratch.mva32);
+        } else {
+            scratch.mva64.assign(scratch.mva32.begin(), scratch.mva32.end());
+            field.store(row, field.member, &scratch.mva64);
+        }
+    }
+}//konec fce
+
+void rowMulti64(Sphinx::Query_t &data, Sphinx::DecodeScratch_t &scratch,
+                void *row, const Sphinx::RowPlan_t::Step_t &step)
+{
+    uint32_t count;
+    if (!(data >> count))
+        throw Sphinx::MessageError_t(
+                "Error parsing response - MVA exceeds data length.");
+    // the count is 32 bit word count instead of value count
+    readMultiValues(data, count >> 1, scratch.mva64);
+    for (size_t i = 0; i < step.fields.size(); ++i)
+        step.fields[i]->store(row, step.fields[i]->member, &scratch.mva64);
+}//konec fce
+
+/** @brief picks row decoder of attribute type for bound member type
+ *  @return 0 when the member type doesn't fit
+ */
+Sphinx::RowPlan_t::RowDecoder_t rowDecoder(uint32_t type,
+                                           Sphinx::BoundType_t bound)
+{
+    switch (type) {
+        case Sphinx::SPH_ATTR_FLOAT:
+            return bound == Sphinx::BOUND_FLOAT ? rowFloat : 0;
+        case Sphinx::SPH_ATTR_BIGINT:
+            return bound == Sphinx::BOUND_UINT64 ? rowUInt64 : 0;
+        case Sphinx::SPH_ATTR_MULTI:
+        case Sphinx::SPH_ATTR_MULTI_FLAG:
+            return bound == Sphinx::BOUND_UINT32_ARRAY
+                   || bound == Sphinx::BOUND_UINT64_ARRAY ? rowMulti32 : 0;
+        case Sphinx::SPH_ATTR_MULTI64:
+            return bound == Sphinx::BOUND_UINT64_ARRAY ? rowMulti64 : 0;
+        case Sphinx::SPH_ATTR_STRING:
+            return bound == Sphinx::BOUND_STRING ? rowString : 0;
+        default:
+            return bound == Sphinx::BOUND_UINT32
+                   || bound == Sphinx::BOUND_UINT64 ? rowUInt32 : 0;
+    }//switch
+}//konec fce
+
+/// orders attribute indexes by name, equal names by position
+struct ByName_t
+{
+    ByName_t(const Sphinx::AttributeTypes_t &attributes)
+        : attributes(attributes)
+    {}
+
+    bool operator()(size_t a, size_t b) const
+    {
+        int cmp = attributes[a].first.compare(attributes[b].first);
+        return cmp < 0 || (cmp == 0 && a < b);
+    }
+
+    const Sphinx::AttributeTypes_t &attributes;
+};
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+Sphinx::DecodePlan_t::DecodePlan_t(const AttributeTypes_t &attributes,
+                                   bool use64bitId,
+                                   const std::vector<std::string> *projection)
+    : attributes(attributes), use64bitId(use64bitId),
+      headBytes((use64bitId ? sizeof(uint64_t) : sizeof(uint32_t))
+                + sizeof(uint32_t)),
+      minRowSize(headBytes), fixedWidth(true)
+{
+    // steps in wire order, fixed width runs get their size on first step
+    steps.resize(attributes.size());
+    std::vector<bool> decoded(attributes.size(), true);
+    bool inHead = true;
+    size_t runStart = 0;
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        unsigned int size;
+        steps[i].decode = attributeDecoder(attributes[i].second, size);
+        steps[i].runBytes = 0;
+        steps[i].itemSize = 0;
+        steps[i].countShift = 0;
+        minRowSize += size ? size : sizeof(uint32_t);
+
+        if (projection && !projection->empty()
+            && std::find(projection->begin(), projection->end(),
+                         attributes[i].first) == projection->end())
+        {
+            // left out, stepped over without materializing
+            steps[i].decode = attributeSkipper(attributes[i].second);
+            decoded[i] = false;
+        }
+
+        if (!size) {
+            variableItem(attributes[i].second, steps[i].itemSize,
+                         steps[i].countShift);
+            fixedWidth = false;
+            inHead = false;
+            runStart = i + 1;
+        } else if (inHead) {
+            headBytes += size;
+        } else {
+            steps[runStart].runBytes += size;
+        }
+    }
+
+    // map nodes are created in name order, the first of equal names wins
+    // (as map insert would do)
+    std::vector<size_t> order;
+    for (size_t i = 0; i < attributes.size(); ++i)
+        if (decoded[i]) order.push_back(i);
+    std::sort(order.begin(), order.end(), ByName_t(attributes));
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i && attributes[order[i]].first == attributes[order[i - 1]].first)
+            continue;
+        nameOrder.push_back(order[i]);
+        nodes.push_back(std::make_pair(attributes[order[i]].first,
+                                       Value_t()));
+    }
+}//konstruktor
+
+void Sphinx::DecodePlan_t::decodeRow(Query_t &data, DecodeScratch_t &scratch,
+                                     ResponseEntry_t &entry) const
+{
+    if (data.getLength() < headBytes)
+        throw MessageError_t(
+                "Error parsing response - match exceeds data length.");
+
+    entry.documentId = use64bitId ? load64(data) : load32(data);
+    entry.weight = load32(data);
+    entry.groupId = entry.timestamp = 0;
+
+    // values of duplicate names are decoded into the spare value
+    Value_t spare;
+    scratch.slots.assign(steps.size(), &spare);
+    for (;;) {
+        std::map<std::string, Value_t>::iterator hint = entry.attribute.end();
+        for (size_t i = 0; i < nameOrder.size(); ++i) {
+            hint = entry.attribute.insert(hint, nodes[i]);
+            scratch.slots[nameOrder[i]] = &hint->second;
+            ++hint;
+        }
+        // reused entry may hold attributes left out by this projection
+        if (entry.attribute.size() == nodes.size()) break;
+        entry.attribute.clear();
+    }
+
+    for (size_t i = 0; i < steps.size(); ++i) {
+        if (steps[i].runBytes && data.getLength() < steps[i].runBytes)
+            throw MessageError_t(
+                    "Error parsing response - match exceeds data length.");
+        steps[i].decode(data, scratch, *scratch.slots[i]);
+    }
+}//konec fce
+
+void Sphinx::DecodePlan_t::skipRows(Query_t &data, uint32_t count) const
+{
+    if (fixedWidth) {
+        if (count > data.getLength() / minRowSize)
+            throw MessageError_t(
+                    "Error parsing response - match exceeds data length.");
+        data.dataStartPtr += count * minRowSize;
+        return;
+    }
+
+    for (uint32_t row = 0; row < count; ++row) {
+        if (data.getLength() < headBytes)
+            throw MessageError_t(
+                    "Error parsing response - match exceeds data length.");
+        data.dataStartPtr += headBytes;
+
+        for (size_t i = 0; i < steps.size(); ++i) {
+            if (steps[i].runBytes) {
+                if (data.getLength() < steps[i].runBytes)
+                    throw MessageError_t("Error parsing response - "
+                                         "match exceeds data length.");
+                data.dataStartPtr += steps[i].runBytes;
+            }
+            if (!steps[i].itemSize) continue;
+
+            uint32_t items;
+            if (!(data >> items)) items = ~0U;
+            items >>= steps[i].countShift;
+            if (items > data.getLength() / steps[i].itemSize)
+                throw MessageError_t(
+                        "Error parsing response - match exceeds data length.");
+            data.dataStartPtr += items * steps[i].itemSize;
+        }
+    }
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::RowPlan_t::RowPlan_t(const Schema_t &schema, bool use64bitId,
+                             const RowBindingBase_t &binding)
+    : binding(binding), use64bitId(use64bitId),
+      headBytes((use64bitId ? sizeof(uint64_t) : sizeof(uint32_t))
+                + sizeof(uint32_t))
+{
+    const AttributeTypes_t &attributes = schema.getAttributes();
+    steps.resize(attributes.size());
+
+    // members go to the step of their attribute
+    const std::vector<RowBindingBase_t::Field_t> &fields
+        = binding.getFields();
+    for (size_t i = 0; i < fields.size(); ++i) {
+        size_t index = schema.findAttribute(fields[i].name);
+        if (index == Schema_t::NO_ATTRIBUTE)
+            throw ValueTypeError_t("Bound attribute " + fields[i].name
+                                   + " is not in response.");
+        if (!rowDecoder(attributes[index].second, fields[i].type))
+            throw ValueTypeError_t("Attribute " + fields[i].name
+                                   + " does not fit type of bound member.");
+        steps[index].fields.push_back(&fields[i]);
+    }
+
+    // fixed width runs get their size on first step
+    bool inHead = true;
+    size_t runStart = 0;
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        unsigned int size;
+        attributeDecoder(attributes[i].second, size);
+        Step_t &step = steps[i];
+        step.skip = attributeSkipper(attributes[i].second);
+        step.decode = step.fields.empty()
+            ? 0 : rowDecoder(attributes[i].second, step.fields[0]->type);
+        step.runBytes = 0;
+
+        if (!size) {
+            inHead = false;
+            runStart = i + 1;
+        } else if (inHead) {
+            headBytes += size;
+        } else {
+            steps[runStart].runBytes += size;
+        }
+    }
+}//konstruktor
+
+void Sphinx::RowPlan_t::decodeRows(Query_t &data, DecodeScratch_t &scratch,
+                                   uint32_t count, RowSink_t &sink) const
+{
+    unsigned char *row = static_cast<unsigned char *>(sink.resize(count));
+    size_t stride = sink.getStride();
+    const RowBindingBase_t::Field_t &documentId = binding.getDocumentId();
+    const RowBindingBase_t::Field_t &weight = binding.getWeight();
+
+    for (uint32_t r = 0; r < count; ++r, row += stride) {
+        if (data.getLength() < headBytes)
+            throw MessageError_t(
+                    "Error parsing response - match exceeds data length.");
+        uint64_t id = use64bitId ? load64(data) : load32(data);
+        uint32_t weightValue = load32(data);
+        if (documentId.store) documentId.store(row, documentId.member, &id);
+        if (weight.store) weight.store(row, weight.member, &weightValue);
+
+        for (size_t i = 0; i < steps.size(); ++i) {
+            const Step_t &step = steps[i];
+            if (step.runBytes && data.getLength() < step.runBytes)
+                throw MessageError_t(
+                        "Error parsing response - match exceeds data length.");
+            if (step.decode) step.decode(data, scratch, row, step);
+            else step.skip(data, scratch, unusedValue);
+        }
+    }
+}//konec fce
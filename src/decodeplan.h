@@ -0,0 +1,199 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Row decoder compiled from the attribute schema of a response
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file decodeplan.h
+
+#ifndef __DECODEPLAN_H__
+#define __DECODEPLAN_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/sphinxclientquery.h>
+#include <sphinxclient/rowbinding.h>
+
+namespace Sphinx
+{
+
+class Arena_t;
+
+/** @brief Buffers reused while decoding rows of one response
+ */
+struct DecodeScratch_t
+{
+    DecodeScratch_t(Arena_t *arena) : arena(arena) {}
+
+    /// values are placed into this arena (0 for heap)
+    Arena_t *arena;
+    std::vector<uint32_t> mva32;
+    std::vector<uint64_t> mva64;
+    std::string text;
+    /// attribute values of the row in wire order
+    std::vector<Value_t *> slots;
+};//struct
+
+/** @brief Decodes one attribute value
+ *
+ *  Fixed width decoders read from the pointer without bounds check
+ *  (the whole run was checked by the plan), variable width decoders
+ *  check their own data.
+ */
+typedef void (*AttributeDecoder_t)(Query_t &data, DecodeScratch_t &scratch,
+                                   Value_t &value);
+
+/** @brief Attribute schema compiled into a sequence of decode steps
+ *
+ *  Built once per response from AttributeTypes_t. Consecutive fixed
+ *  width attributes (together with document id and weight leading
+ *  the row) form runs with single bounds check, type dispatch is done
+ *  when the plan is built and rows only call the step decoders.
+ */
+class DecodePlan_t
+{
+public:
+    /** @brief compiles the schema
+     *  @param attributes attribute names and SPH_ATTR_* types
+     *  @param use64bitId document ids are 64 bit
+     *  @param projection names of attributes to decode, others are
+     *         stepped over and left out of entries (0 or empty for all)
+     */
+    DecodePlan_t(const AttributeTypes_t &attributes, bool use64bitId,
+                 const std::vector<std::string> *projection = 0);
+
+    /** @brief decodes one match into entry
+     *
+     *  Attribute map of reused entry is kept when it holds the same
+     *  names, values are decoded over.
+     *
+     *  @throws MessageError_t when the row exceeds data
+     */
+    void decodeRow(Query_t &data, DecodeScratch_t &scratch,
+                   ResponseEntry_t &entry) const;
+
+    /** @brief skips count matches without decoding them
+     *
+     *  Used to find sub-response boundaries, rows of fixed width
+     *  schema are skipped at once.
+     *
+     *  @throws MessageError_t when the rows exceed data
+     */
+    void skipRows(Query_t &data, uint32_t count) const;
+
+    //! @brief minimal size of a row (bytes)
+    unsigned int getMinRowSize() const { return minRowSize; }
+
+private:
+    struct Step_t
+    {
+        AttributeDecoder_t decode;
+        /// bytes of the fixed width run starting by this step, else 0
+        unsigned int runBytes;
+        /// bytes per counted item of variable width step, else 0
+        unsigned int itemSize;
+        /// count in data is shifted by this to get item count
+        unsigned int countShift;
+    };
+
+    const AttributeTypes_t &attributes;
+    bool use64bitId;
+    /// bytes of id, weight and fixed width attributes that follow them
+    unsigned int headBytes;
+    unsigned int minRowSize;
+    /// all attributes have fixed width (rows are minRowSize long)
+    bool fixedWidth;
+    /// decode steps in wire order
+    std::vector<Step_t> steps;
+    /// decoded attribute indexes in name order, duplicate names left out
+    std::vector<size_t> nameOrder;
+    /// empty map nodes of entry attributes, in name order
+    std::vector<std::map<std::string, Value_t>::value_type> nodes;
+};//class
+
+/** @brief Attribute schema compiled against a row binding
+ *
+ *  Decodes matches straight into bound members of user rows, attributes
+ *  not bound are stepped over. Types are checked when the plan is
+ *  built, so rows only call the step decoders.
+ */
+class RowPlan_t
+{
+public:
+    /** @brief compiles the schema for binding
+     *  @throws ValueTypeError_t when bound attribute is missing or its
+     *          type doesn't fit the member
+     */
+    RowPlan_t(const Schema_t &schema, bool use64bitId,
+              const RowBindingBase_t &binding);
+
+    /** @brief decodes count matches into rows of sink
+     *  @throws MessageError_t when the rows exceed data
+     */
+    void decodeRows(Query_t &data, DecodeScratch_t &scratch, uint32_t count,
+                    RowSink_t &sink) const;
+
+    struct Step_t;
+
+    //! @brief decodes one attribute into bound members of row
+    typedef void (*RowDecoder_t)(Query_t &data, DecodeScratch_t &scratch,
+                                 void *row, const Step_t &step);
+
+    struct Step_t
+    {
+        RowDecoder_t decode;
+        /// decoder stepping over attribute that is not bound
+        AttributeDecoder_t skip;
+        /// bytes of the fixed width run starting by this step, else 0
+        unsigned int runBytes;
+        /// members bound to the attribute
+        std::vector<const RowBindingBase_t::Field_t *> fields;
+    };
+
+private:
+    const RowBindingBase_t &binding;
+    bool use64bitId;
+    /// bytes of id, weight and fixed width attributes that follow them
+    unsigned int headBytes;
+    /// decode steps in wire order
+    std::vector<Step_t> steps;
+};//class
+
+}//namespace
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Sorted sets of document ids
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <sphinxclient/documentidset.h>
+#include <sphinxclient/sphinxclient.h>
+#include "idsetkernels.h"
+
+#include <algorithm>
+
+namespace {
+
+typedef size_t (*Operation_t)(const uint64_t *, size_t, const uint64_t *,
+                              size_t, uint64_t *);
+
+const uint64_t *first(const std::vector<uint64_t> &ids)
+{
+    return ids.empty() ? 0 : &ids[0];
+}//konec fce
+
+/** @brief runs set operation of a and b into result
+ *  @param bound most ids the result can get
+ */
+void apply(Operation_t operation, const std::vector<uint64_t> &a,
+           const std::vector<uint64_t> &b, size_t bound,
+           std::vector<uint64_t> &result)
+{
+    // kernels need output apart from the operands
+    std::vector<uint64_t> fresh;
+    std::vector<uint64_t> &out = (&result == &a || &result == &b)
+        ? fresh : result;
+    out.resize(bound);
+    uint64_t *target = bound ? &out[0] : 0;
+    out.resize(operation(first(a), a.size(), first(b), b.size(), target));
+    if (&out != &result) result.swap(out);
+}//konec fce
+
+}//namespace
+
+Sphinx::DocumentIdSet_t::DocumentIdSet_t(const std::vector<uint64_t> &ids)
+    : ids(ids)
+{
+    normalize();
+}//konstruktor
+
+void Sphinx::DocumentIdSet_t::assign(const std::vector<uint64_t> &ids)
+{
+    this->ids.assign(ids.begin(), ids.end());
+    normalize();
+}//konec fce
+
+void Sphinx::DocumentIdSet_t::adopt(std::vector<uint64_t> &ids)
+{
+    this->ids.swap(ids);
+    normalize();
+}//konec fce
+
+void Sphinx::DocumentIdSet_t::normalize()
+{
+    // sorted input (sets, matches sorted by id) is only checked
+    for (size_t i = 1; i < ids.size(); ++i) {
+        if (ids[i - 1] >= ids[i]) {
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            break;
+        }
+    }
+}//konec fce
+
+bool Sphinx::DocumentIdSet_t::contains(uint64_t id) const
+{
+    return std::binary_search(ids.begin(), ids.end(), id);
+}//konec fce
+
+Sphinx::SharedEnumFilter_t Sphinx::DocumentIdSet_t::getFilter() const
+{
+    return SharedEnumFilter_t(ids);
+}//konec fce
+
+void Sphinx::DocumentIdSet_t::intersect(const DocumentIdSet_t &a,
+                                        const DocumentIdSet_t &b,
+                                        DocumentIdSet_t &result)
+{
+    apply(intersectIds, a.ids, b.ids, std::min(a.size(), b.size()),
+          result.ids);
+}//konec fce
+
+void Sphinx::DocumentIdSet_t::unite(const DocumentIdSet_t &a,
+                                    const DocumentIdSet_t &b,
+                                    DocumentIdSet_t &result)
+{
+    apply(uniteIds, a.ids, b.ids, a.size() + b.size(), result.ids);
+}//konec fce
+
+void Sphinx::DocumentIdSet_t::subtract(const DocumentIdSet_t &a,
+                                       const DocumentIdSet_t &b,
+                                       DocumentIdSet_t &result)
+{
+    apply(subtractIds, a.ids, b.ids, a.size(), result.ids);
+}//konec fce
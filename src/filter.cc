@@ -38,6 +38,11 @@
 
 
 #include <filter.h>
+#include "bulkdecode.h"
+
+#include <algorithm>
+#include <map>
+#include <string.h>
 
 
 Sphinx::Filter_t::Filter_t()
@@ -54,8 +59,8 @@ namespace Sphinx {
 }
 
 Sphinx::RangeFilter_t::RangeFilter_t(
-        const std::string &attrName, uint32_t minValue,
-        uint32_t maxValue, bool excludeFlag)
+        const std::string &attrName, uint64_t minValue,
+        uint64_t maxValue, bool excludeFlag)
     : minValue(minValue), maxValue(maxValue)
 {
     this->attrName = attrName;
@@ -83,37 +88,118 @@ Sphinx::Filter_t * Sphinx::RangeFilter_t::clone() const
     return new Sphinx::RangeFilter_t(*this);
 }
 
+Sphinx::EnumFilterPayload_t::EnumFilterPayload_t()
+    : count(0), values(sizeof(uint64_t)), digest(0), sorted(true)
+{
+    values.convertEndian = true;
+}
+
+template <class Array_t>
+static bool isSorted(const Array_t &array)
+{
+    for (size_t i = 1; i < array.size(); ++i)
+        if (!(array[i - 1] < array[i])) return false;
+    return true;
+}
+
+static void serializeValues(const Sphinx::Int64Array_t &array,
+                            Sphinx::Query_t &values, bool &sorted)
+{
+    sorted = isSorted(array);
+    values.clear();
+    if (!array.empty()) values.appendArray(&array[0], array.size());
+}
+
+static void serializeValues(const Sphinx::IntArray_t &array,
+                            Sphinx::Query_t &values, bool &sorted)
+{
+    sorted = isSorted(array);
+    values.clear();
+    values.reserve(array.size() * sizeof(uint64_t));
+
+    // widen by blocks, each block is appended at once
+    uint64_t block[256];
+    for (size_t i = 0; i < array.size(); ) {
+        size_t count = 0;
+        for (; count < 256 && i < array.size(); ++count, ++i)
+            block[count] = array[i];
+        values.appendArray(block, count);
+    }
+}
+
+static uint64_t fnv1a(const unsigned char *data, unsigned int length)
+{
+    // fnv-1a over 64-bit words, values are always whole words
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned int i = 0; i + sizeof(uint64_t) <= length;
+         i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void Sphinx::EnumFilterPayload_t::assign(const Int64Array_t &array)
+{
+    serializeValues(array, values, sorted);
+    count = array.size();
+    digest = fnv1a(values.data, values.getLength());
+}
+
+void Sphinx::EnumFilterPayload_t::assign(const IntArray_t &array)
+{
+    serializeValues(array, values, sorted);
+    count = array.size();
+    digest = fnv1a(values.data, values.getLength());
+}
+
+Sphinx::Int64Array_t Sphinx::EnumFilterPayload_t::getValues() const
+{
+    Int64Array_t result;
+    result.resize(count);
+    if (count) {
+        decodeNetwork64(&result[0], values.data + values.dataStartPtr,
+                        count);
+    }
+    return result;
+}
+
 Sphinx::EnumFilter_t::EnumFilter_t(
         const std::string &attrName, const Int64Array_t &values,
         bool excludeFlag)
-    : values(values)
 {
-        this->attrName = attrName;
-        this->excludeFlag = excludeFlag;
+    payload.detach().assign(values);
+    this->attrName = attrName;
+    this->excludeFlag = excludeFlag;
 }
 
 Sphinx::EnumFilter_t::EnumFilter_t(
-        const std::string &attrName, const IntArray_t &nvalues,
+        const std::string &attrName, const IntArray_t &values,
         bool excludeFlag)
 {
-    values.clear();
-    for(IntArray_t::const_iterator valI = nvalues.begin() ; valI!=nvalues.end();
-        ++valI)
-    {
-        values.push_back(*valI);
-    }//for
+    payload.detach().assign(values);
+    this->attrName = attrName;
+    this->excludeFlag = excludeFlag;
+}
 
+Sphinx::EnumFilter_t::EnumFilter_t(
+        const std::string &attrName,
+        const CowPtr_t<EnumFilterPayload_t> &payload,
+        bool excludeFlag)
+    : payload(payload)
+{
     this->attrName = attrName;
     this->excludeFlag = excludeFlag;
 }
 
 std::ostream & Sphinx::EnumFilter_t::print(std::ostream &o) const
 {
-    for (Int64Array_t::const_iterator i = values.begin();
-        i != values.end(); i++)
-    {
-        o << *i << ";";
-    }
+    // digest identifies values, no need to print them all
+    o << payload->count << "#" << std::hex << payload->digest << std::dec
+      << ";";
     return o;
 }
 
@@ -121,12 +207,8 @@ void Sphinx::EnumFilter_t::dumpToBuff(Sphinx::Query_t &data) const
 {
     data << attrName;
     data << (uint32_t) SPH_FILTER_VALUES;
-    data << (uint32_t) values.size();
-    for (Sphinx::Int64Array_t::const_iterator val = values.begin();
-         val != values.end(); val++)
-    {
-        data << (uint64_t)(*val);
-    }
+    data << (uint32_t) payload->count;
+    data << payload->values;
     data << (uint32_t) excludeFlag;
 };
 
@@ -165,4 +247,293 @@ Sphinx::Filter_t * Sphinx::FloatRangeFilter_t::clone() const
     return new Sphinx::FloatRangeFilter_t(*this);
 }
 
+//------------------------------------------------------------------------------
+// filter normalization
+//------------------------------------------------------------------------------
+
+namespace {
+
+typedef std::vector<Sphinx::Filter_t *> Filters_t;
+
+/** @brief key ordering integer filter values as searchd compares them
+  *
+  * Attributes are compared as signed 64bit integers, only document id
+  * is unsigned. Flipping the sign bit maps signed order onto unsigned,
+  * applying it again gives the value back.
+  */
+inline uint64_t valueKey(const std::string &attrName, uint64_t value)
+{
+    return attrName == "@id" ? value : value ^ (uint64_t(1) << 63);
+}
+
+/** @brief float values are ordered as they are
+  */
+inline float valueKey(const std::string &, float value)
+{
+    return value;
+}
+
+
+/** @brief get i-th value of serialized enum payload
+  */
+uint64_t payloadValue(const Sphinx::EnumFilterPayload_t &payload, uint32_t i)
+{
+    const unsigned char *bytes = payload.values.data
+        + payload.values.dataStartPtr + i * sizeof(uint64_t);
+    uint64_t value = 0;
+    for (unsigned j = 0; j < sizeof(uint64_t); ++j)
+        value = (value << 8) | bytes[j];
+    return value;
+}
+
+/** @brief canonical order of filters
+  */
+struct FilterLess_t {
+    bool operator()(const Sphinx::Filter_t *lhs,
+                    const Sphinx::Filter_t *rhs) const
+    {
+        if (lhs->attrName != rhs->attrName)
+            return lhs->attrName < rhs->attrName;
+        if (lhs->getType() != rhs->getType())
+            return lhs->getType() < rhs->getType();
+        if (lhs->excludeFlag != rhs->excludeFlag)
+            return lhs->excludeFlag < rhs->excludeFlag;
+
+        switch (lhs->getType()) {
+            case Sphinx::SPH_FILTER_RANGE: {
+                const Sphinx::RangeFilter_t *l
+                    = static_cast<const Sphinx::RangeFilter_t *>(lhs);
+                const Sphinx::RangeFilter_t *r
+                    = static_cast<const Sphinx::RangeFilter_t *>(rhs);
+                uint64_t lMin = valueKey(l->attrName, l->minValue);
+                uint64_t rMin = valueKey(r->attrName, r->minValue);
+                if (lMin != rMin) return lMin < rMin;
+                return valueKey(l->attrName, l->maxValue)
+                    < valueKey(r->attrName, r->maxValue);
+            }
+            case Sphinx::SPH_FILTER_FLOATRANGE: {
+                const Sphinx::FloatRangeFilter_t *l
+                    = static_cast<const Sphinx::FloatRangeFilter_t *>(lhs);
+                const Sphinx::FloatRangeFilter_t *r
+                    = static_cast<const Sphinx::FloatRangeFilter_t *>(rhs);
+                if (l->minValue != r->minValue)
+                    return l->minValue < r->minValue;
+                return l->maxValue < r->maxValue;
+            }
+            case Sphinx::SPH_FILTER_VALUES: {
+                const Sphinx::EnumFilterPayload_t &l
+                    = *static_cast<const Sphinx::EnumFilter_t *>(lhs)->payload;
+                const Sphinx::EnumFilterPayload_t &r
+                    = *static_cast<const Sphinx::EnumFilter_t *>(rhs)->payload;
+                if (l.count != r.count)
+                    return l.count < r.count;
+                // big endian bytes compare as the values do
+                return memcmp(l.values.data + l.values.dataStartPtr,
+                              r.values.data + r.values.dataStartPtr,
+                              l.values.getLength()) < 0;
+            }
+        }
+        return false;
+    }
+};
+
+/** @brief whether both filters are in the same group (attribute, type and
+  *        exclude flag)
+  */
+bool sameGroup(const Sphinx::Filter_t *lhs, const Sphinx::Filter_t *rhs)
+{
+    return lhs->attrName == rhs->attrName
+        && lhs->getType() == rhs->getType()
+        && lhs->excludeFlag == rhs->excludeFlag;
+}
+
+/** @brief sort values and remove duplicates
+  */
+void sortUnique(Sphinx::Int64Array_t &values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+/** @brief whether range of lhs is inside range of rhs (same attribute)
+  */
+template <class Range_t>
+bool isInside(const Range_t *lhs, const Range_t *rhs)
+{
+    const std::string &name = lhs->attrName;
+    return valueKey(name, lhs->minValue) >= valueKey(name, rhs->minValue)
+        && valueKey(name, lhs->maxValue) <= valueKey(name, rhs->maxValue);
+}
+
+/** @brief whether next range (starting not before current) overlaps
+  *        or is adjacent to current range
+  */
+bool touches(const Sphinx::RangeFilter_t *current,
+             const Sphinx::RangeFilter_t *next)
+{
+    uint64_t currentMax = valueKey(current->attrName, current->maxValue);
+    uint64_t nextMin = valueKey(next->attrName, next->minValue);
+    return currentMax >= nextMin || currentMax + 1 == nextMin;
+}
+
+/** @brief float ranges are never adjacent, only overlapping ones touch
+  */
+bool touches(const Sphinx::FloatRangeFilter_t *current,
+             const Sphinx::FloatRangeFilter_t *next)
+{
+    return current->maxValue >= next->minValue;
+}
 
+/** @brief join exclude ranges and drop wider include ranges within group
+  *        of filters [begin, end) of the same range type, sorted
+  * @param out output filters, dropped ones are deleted
+  */
+template <class Range_t>
+void mergeRanges(Filters_t::const_iterator begin, Filters_t::const_iterator end,
+                 Filters_t &out)
+{
+    if ((*begin)->excludeFlag) {
+        // NOT in A and NOT in B == NOT in (A or B)
+        Range_t *current = static_cast<Range_t *>(*begin);
+        for (Filters_t::const_iterator i = begin + 1; i != end; ++i) {
+            Range_t *next = static_cast<Range_t *>(*i);
+            if (touches(current, next)) {
+                if (valueKey(next->attrName, next->maxValue)
+                    > valueKey(current->attrName, current->maxValue))
+                {
+                    current->maxValue = next->maxValue;
+                }
+                delete next;
+            } else {
+                out.push_back(current);
+                current = next;
+            }
+        }
+        out.push_back(current);
+    } else {
+        // (in A) and (in B) == in A, when A is inside B
+        std::vector<bool> wider(end - begin, false);
+        for (Filters_t::const_iterator i = begin; i != end; ++i) {
+            for (Filters_t::const_iterator j = begin; j != end; ++j) {
+                if (i != j && isInside(static_cast<Range_t *>(*j),
+                                       static_cast<Range_t *>(*i)))
+                {
+                    wider[i - begin] = true;
+                    break;
+                }
+            }
+        }
+        for (Filters_t::const_iterator i = begin; i != end; ++i) {
+            if (wider[i - begin]) delete *i;
+            else out.push_back(*i);
+        }
+    }
+}
+
+}//namespace
+
+void Sphinx::normalizeFilters(std::vector<Filter_t *> &filters)
+{
+    Filters_t work;
+    work.reserve(filters.size());
+
+    // count exclude enums per attribute - these are going to be joined
+    std::map<std::string, unsigned> excludeEnums;
+    for (Filters_t::const_iterator i = filters.begin(); i != filters.end(); ++i)
+        if ((*i)->getType() == SPH_FILTER_VALUES && (*i)->excludeFlag)
+            ++excludeEnums[(*i)->attrName];
+
+    // sort enum values, join exclude enums
+    std::map<std::string, Int64Array_t> excludedValues;
+    for (Filters_t::const_iterator i = filters.begin(); i != filters.end(); ++i)
+    {
+        if ((*i)->getType() != SPH_FILTER_VALUES) {
+            work.push_back(*i);
+            continue;
+        }
+
+        EnumFilter_t *filter = static_cast<EnumFilter_t *>(*i);
+        if (filter->excludeFlag && excludeEnums[filter->attrName] > 1) {
+            // NOT in A and NOT in B == NOT in (A or B)
+            Int64Array_t values = filter->getValues();
+            Int64Array_t &joined = excludedValues[filter->attrName];
+            joined.insert(joined.end(), values.begin(), values.end());
+            delete filter;
+            continue;
+        }
+
+        if (!filter->payload->sorted) {
+            Int64Array_t values = filter->getValues();
+            sortUnique(values);
+            CowPtr_t<EnumFilterPayload_t> payload;
+            payload.detach().assign(values);
+            filter->payload = payload;
+        }
+        work.push_back(filter);
+    }
+    for (std::map<std::string, Int64Array_t>::iterator i
+            = excludedValues.begin(); i != excludedValues.end(); ++i)
+    {
+        sortUnique(i->second);
+        work.push_back(new EnumFilter_t(i->first, i->second, true));
+    }
+
+    // enums of contiguous values become ranges
+    for (Filters_t::iterator i = work.begin(); i != work.end(); ++i) {
+        if ((*i)->getType() != SPH_FILTER_VALUES) continue;
+
+        EnumFilter_t *filter = static_cast<EnumFilter_t *>(*i);
+        const EnumFilterPayload_t &payload = *filter->payload;
+        if (payload.count < 2) continue;
+
+        // distinct values are contiguous when their keys span count values
+        const std::string &name = filter->attrName;
+        uint64_t first = valueKey(name, payloadValue(payload, 0));
+        uint64_t last = first;
+        for (uint32_t v = 1; v < payload.count; ++v) {
+            uint64_t key = valueKey(name, payloadValue(payload, v));
+            first = std::min(first, key);
+            last = std::max(last, key);
+        }
+        if (last - first != payload.count - 1) continue;
+
+        *i = new RangeFilter_t(name, valueKey(name, first),
+                               valueKey(name, last), filter->excludeFlag);
+        delete filter;
+    }
+
+    // canonical order, drop duplicates
+    std::sort(work.begin(), work.end(), FilterLess_t());
+    Filters_t unique;
+    unique.reserve(work.size());
+    for (Filters_t::const_iterator i = work.begin(); i != work.end(); ++i) {
+        if (!unique.empty() && !FilterLess_t()(unique.back(), *i)) {
+            delete *i;
+        } else {
+            unique.push_back(*i);
+        }
+    }
+
+    // merge ranges within groups
+    filters.clear();
+    for (Filters_t::const_iterator begin = unique.begin();
+            begin != unique.end(); )
+    {
+        Filters_t::const_iterator end = begin + 1;
+        while (end != unique.end() && sameGroup(*begin, *end))
+            ++end;
+
+        switch ((*begin)->getType()) {
+            case SPH_FILTER_RANGE:
+                mergeRanges<RangeFilter_t>(begin, end, filters);
+                break;
+            case SPH_FILTER_FLOATRANGE:
+                mergeRanges<FloatRangeFilter_t>(begin, end, filters);
+                break;
+            default:
+                filters.insert(filters.end(), begin, end);
+                break;
+        }
+        begin = end;
+    }
+}
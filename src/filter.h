@@ -47,6 +47,8 @@
 #include <string>
 #include <vector>
 
+#include "cowptr.h"
+
 namespace Sphinx
 {
 
@@ -88,6 +90,12 @@ struct Filter_t
       */
     virtual Filter_t * clone() const = 0;
 
+    /// get filter type as sent to searchd
+    virtual FilterType_t getType() const = 0;
+
+    /// count of values searchd has to test (used for cost estimates)
+    virtual size_t getValueCount() const { return 1; }
+
     virtual ~Filter_t() {};
 
     std::string attrName;
@@ -101,16 +109,46 @@ struct Filter_t
   */
 struct RangeFilter_t : public Filter_t
 {
-    RangeFilter_t(const std::string &attrName, uint32_t minValue,
-                  uint32_t maxValue, bool excludeFlag=false);
+    RangeFilter_t(const std::string &attrName, uint64_t minValue,
+                  uint64_t maxValue, bool excludeFlag=false);
     void dumpToBuff(Sphinx::Query_t &data) const;
     virtual std::ostream & print(std::ostream &o) const;
     virtual Filter_t * clone() const;
+    virtual FilterType_t getType() const { return SPH_FILTER_RANGE; }
 
     uint64_t minValue;
     uint64_t maxValue;
 };
 
+/** @brief Serialized values of enum filter
+  *
+  * Values are stored as they are sent to searchd (64bit, network byte
+  * order), so serializing the filter is a single memcpy. Payload is
+  * immutable once built and it is shared by all filters (and their
+  * clones) made from the same SharedEnumFilter_t.
+  */
+struct EnumFilterPayload_t {
+    EnumFilterPayload_t();
+
+    /// serialize values
+    void assign(const Int64Array_t &values);
+    /// serialize values
+    void assign(const IntArray_t &values);
+
+    /// decode serialized values
+    Int64Array_t getValues() const;
+
+    /// count of values
+    uint32_t count;
+    /// serialized values
+    Query_t values;
+    /// FNV-1a hash of serialized values, identifies the payload in
+    /// query hashes
+    uint64_t digest;
+    /// values are sorted ascending and unique
+    bool sorted;
+};
+
 /** @brief Attribute enum filter
   *
   * Enum filter provides filtering search result based on enumerated
@@ -123,11 +161,20 @@ struct EnumFilter_t : public Filter_t {
                  bool excludeFlag = false);
     EnumFilter_t(const std::string &attrName, const IntArray_t &values,
                  bool excludeFlag = false);
+    EnumFilter_t(const std::string &attrName,
+                 const CowPtr_t<EnumFilterPayload_t> &payload,
+                 bool excludeFlag = false);
     void dumpToBuff(Sphinx::Query_t &data) const;
     virtual std::ostream & print(std::ostream &o) const;
     virtual Filter_t * clone() const;
+    virtual FilterType_t getType() const { return SPH_FILTER_VALUES; }
+    virtual size_t getValueCount() const { return payload->count; }
+
+    /// get copy of filter values
+    Int64Array_t getValues() const { return payload->getValues(); }
 
-    Int64Array_t values;
+    /// shared serialized values
+    CowPtr_t<EnumFilterPayload_t> payload;
 };
 
 /** @brief Attribute float range filter
@@ -142,11 +189,30 @@ struct FloatRangeFilter_t : public Filter_t {
     void dumpToBuff(Sphinx::Query_t &data) const;
     virtual std::ostream & print(std::ostream &o) const;
     virtual Filter_t * clone() const;
+    virtual FilterType_t getType() const { return SPH_FILTER_FLOATRANGE; }
 
     float minValue;
     float maxValue;
 };
 
+/** @brief Rewrite filters into canonical, compact form
+  *
+  * Filters are ANDed by searchd, so they can be merged and reordered.
+  * Only rewrites valid for multi-value attributes too are done:
+  * - enum values are sorted and deduplicated,
+  * - exclude enums on the same attribute are joined,
+  * - enums of contiguous values become range filters,
+  * - overlapping or adjacent exclude ranges on the same attribute are
+  *   joined,
+  * - include ranges containing another include range on the same
+  *   attribute are dropped (the narrower one implies them),
+  * - duplicate filters are dropped,
+  * - filters are sorted by attribute name, type, exclude flag and values.
+  *
+  * @param filters filters to rewrite, dropped filters are deleted
+  */
+void normalizeFilters(std::vector<Filter_t *> &filters);
+
 }//namespace
 
 #endif
@@ -0,0 +1,358 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Merge kernels over sorted document id arrays
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include "idsetkernels.h"
+#include "cpudispatch.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+/// galloping wins when one array is this many times longer
+const size_t GALLOP_RATIO = 32;
+
+/// kernel merging two sorted arrays into out, returns count written
+typedef size_t (*Merge_t)(const uint64_t *, size_t, const uint64_t *, size_t,
+                          uint64_t *);
+
+/** @brief index of first id not less than value in ids[from .. count),
+ *         probes 1, 2, 4 ... ids ahead and bisects the last step
+ */
+size_t gallop(const uint64_t *ids, size_t from, size_t count, uint64_t value)
+{
+    if (from >= count || ids[from] >= value) return from;
+    size_t low = from;
+    size_t step = 1;
+    while (low + step < count && ids[low + step] < value) {
+        low += step;
+        step <<= 1;
+    }
+    size_t high = std::min(low + step, count);
+    return std::lower_bound(ids + low + 1, ids + high, value) - ids;
+}//konec fce
+
+/// copies ids[from .. to) into out at count, returns new count
+inline size_t copyRun(const uint64_t *ids, size_t from, size_t to,
+                      uint64_t *out, size_t count)
+{
+    if (to > from) memcpy(out + count, ids + from, (to - from) * sizeof(*ids));
+    return count + (to - from);
+}//konec fce
+
+/// intersection of short a with long b
+size_t intersectGallop(const uint64_t *a, size_t aCount,
+                       const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    size_t count = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < aCount; ++i) {
+        j = gallop(b, j, bCount, a[i]);
+        if (j == bCount) break;
+        if (b[j] == a[i]) out[count++] = b[j++];
+    }
+    return count;
+}//konec fce
+
+/// intersection of the rest of a and b by scalar merge
+size_t intersectTail(const uint64_t *a, size_t i, size_t aCount,
+                     const uint64_t *b, size_t j, size_t bCount,
+                     uint64_t *out, size_t count)
+{
+    while (i < aCount && j < bCount) {
+        uint64_t x = a[i];
+        uint64_t y = b[j];
+        out[count] = x;
+        count += x == y;
+        i += x <= y;
+        j += y <= x;
+    }
+    return count;
+}//konec fce
+
+/** @brief difference of the rest of a and b by scalar merge
+ *  @param matched bits of a[i], a[i + 1] ... already found in b
+ */
+size_t subtractTail(const uint64_t *a, size_t i, size_t aCount,
+                    const uint64_t *b, size_t j, size_t bCount,
+                    uint64_t *out, size_t count, unsigned int matched)
+{
+    for (; i < aCount; ++i, matched >>= 1) {
+        if (matched & 1) continue;
+        while (j < bCount && b[j] < a[i]) ++j;
+        if (j < bCount && b[j] == a[i]) ++j;
+        else out[count++] = a[i];
+    }
+    return count;
+}//konec fce
+
+size_t intersectScalar(const uint64_t *a, size_t aCount,
+                       const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    return intersectTail(a, 0, aCount, b, 0, bCount, out, 0);
+}//konec fce
+
+size_t subtractScalar(const uint64_t *a, size_t aCount,
+                      const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    return subtractTail(a, 0, aCount, b, 0, bCount, out, 0, 0);
+}//konec fce
+
+/// writes a[i + bit] for each bit set in mask
+inline size_t emitMatched(const uint64_t *a, size_t i, unsigned int mask,
+                          uint64_t *out, size_t count)
+{
+    while (mask) {
+        out[count++] = a[i + __builtin_ctz(mask)];
+        mask &= mask - 1;
+    }
+    return count;
+}//konec fce
+
+#ifdef SPHINX_DISPATCH_X86
+
+// block kernels compare every id of a block of a with every id of a
+// block of b (rotating the b block), then advance the block(s) with the
+// smaller last id; ids are distinct, so each id of a matches at most once
+
+/// bits of a[i], a[i + 1] matching any of b[j], b[j + 1]
+__attribute__((target("sse4.1")))
+inline unsigned int matchSse41(const uint64_t *a, const uint64_t *b)
+{
+    __m128i va = _mm_loadu_si128((const __m128i *)a);
+    __m128i vb = _mm_loadu_si128((const __m128i *)b);
+    __m128i eq = _mm_or_si128(
+            _mm_cmpeq_epi64(va, vb),
+            _mm_cmpeq_epi64(va, _mm_shuffle_epi32(vb, 0x4e)));
+    return _mm_movemask_pd(_mm_castsi128_pd(eq));
+}//konec fce
+
+__attribute__((target("sse4.1")))
+size_t intersectSse41(const uint64_t *a, size_t aCount,
+                      const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    size_t i = 0, j = 0, count = 0;
+    while (i + 2 <= aCount && j + 2 <= bCount) {
+        count = emitMatched(a, i, matchSse41(a + i, b + j), out, count);
+        uint64_t aLast = a[i + 1];
+        uint64_t bLast = b[j + 1];
+        i += aLast <= bLast ? 2 : 0;
+        j += bLast <= aLast ? 2 : 0;
+    }
+    return intersectTail(a, i, aCount, b, j, bCount, out, count);
+}//konec fce
+
+__attribute__((target("sse4.1")))
+size_t subtractSse41(const uint64_t *a, size_t aCount,
+                     const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    size_t i = 0, j = 0, count = 0;
+    unsigned int matched = 0;
+    while (i + 2 <= aCount && j + 2 <= bCount) {
+        matched |= matchSse41(a + i, b + j);
+        uint64_t aLast = a[i + 1];
+        uint64_t bLast = b[j + 1];
+        if (aLast <= bLast) {
+            count = emitMatched(a, i, ~matched & 3, out, count);
+            matched = 0;
+            i += 2;
+        }
+        if (bLast <= aLast) j += 2;
+    }
+    return subtractTail(a, i, aCount, b, j, bCount, out, count, matched);
+}//konec fce
+
+/// bits of a[i .. i + 3] matching any of b[j .. j + 3]
+__attribute__((target("avx2")))
+inline unsigned int matchAvx2(const uint64_t *a, const uint64_t *b)
+{
+    __m256i va = _mm256_loadu_si256((const __m256i *)a);
+    __m256i vb = _mm256_loadu_si256((const __m256i *)b);
+    __m256i eq = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi64(va, vb),
+                _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, 0x39))),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, 0x4e)),
+                _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, 0x93))));
+    return _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+}//konec fce
+
+__attribute__((target("avx2")))
+size_t intersectAvx2(const uint64_t *a, size_t aCount,
+                     const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    size_t i = 0, j = 0, count = 0;
+    while (i + 4 <= aCount && j + 4 <= bCount) {
+        count = emitMatched(a, i, matchAvx2(a + i, b + j), out, count);
+        uint64_t aLast = a[i + 3];
+        uint64_t bLast = b[j + 3];
+        i += aLast <= bLast ? 4 : 0;
+        j += bLast <= aLast ? 4 : 0;
+    }
+    return intersectTail(a, i, aCount, b, j, bCount, out, count);
+}//konec fce
+
+__attribute__((target("avx2")))
+size_t subtractAvx2(const uint64_t *a, size_t aCount,
+                    const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    size_t i = 0, j = 0, count = 0;
+    unsigned int matched = 0;
+    while (i + 4 <= aCount && j + 4 <= bCount) {
+        matched |= matchAvx2(a + i, b + j);
+        uint64_t aLast = a[i + 3];
+        uint64_t bLast = b[j + 3];
+        if (aLast <= bLast) {
+            count = emitMatched(a, i, ~matched & 15, out, count);
+            matched = 0;
+            i += 4;
+        }
+        if (bLast <= aLast) j += 4;
+    }
+    return subtractTail(a, i, aCount, b, j, bCount, out, count, matched);
+}//konec fce
+
+#endif
+
+/// one implementation of the kernels
+struct Implementation_t
+{
+    const char *name;
+    Merge_t intersect;
+    Merge_t subtract;
+};
+
+const Implementation_t implementations[] = {
+#ifdef SPHINX_DISPATCH_X86
+    {"avx2", intersectAvx2, subtractAvx2},
+    {"sse4.1", intersectSse41, subtractSse41},
+#endif
+    {"scalar", intersectScalar, subtractScalar}
+};
+
+const size_t implementationCount
+    = sizeof(implementations) / sizeof(implementations[0]);
+
+/// implementation in use
+Sphinx::CpuDispatch_t<Implementation_t> dispatch
+    = {implementations, implementationCount, 0};
+
+}//namespace
+
+size_t Sphinx::intersectIds(const uint64_t *a, size_t aCount,
+                            const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    if (aCount > bCount) {
+        std::swap(a, b);
+        std::swap(aCount, bCount);
+    }
+    if (aCount * GALLOP_RATIO < bCount)
+        return intersectGallop(a, aCount, b, bCount, out);
+    return dispatch.select().intersect(a, aCount, b, bCount, out);
+}//konec fce
+
+size_t Sphinx::uniteIds(const uint64_t *a, size_t aCount,
+                        const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    if (aCount < bCount) {
+        std::swap(a, b);
+        std::swap(aCount, bCount);
+    }
+    size_t count = 0;
+    size_t i = 0;
+    if (bCount * GALLOP_RATIO < aCount) {
+        // runs of a between ids of short b are copied whole
+        for (size_t j = 0; j < bCount; ++j) {
+            size_t end = gallop(a, i, aCount, b[j]);
+            count = copyRun(a, i, end, out, count);
+            i = end;
+            if (i == aCount || a[i] != b[j]) out[count++] = b[j];
+        }
+        return copyRun(a, i, aCount, out, count);
+    }
+
+    size_t j = 0;
+    while (i < aCount && j < bCount) {
+        uint64_t x = a[i];
+        uint64_t y = b[j];
+        out[count++] = x < y ? x : y;
+        i += x <= y;
+        j += y <= x;
+    }
+    count = copyRun(a, i, aCount, out, count);
+    return copyRun(b, j, bCount, out, count);
+}//konec fce
+
+size_t Sphinx::subtractIds(const uint64_t *a, size_t aCount,
+                           const uint64_t *b, size_t bCount, uint64_t *out)
+{
+    if (aCount * GALLOP_RATIO < bCount) {
+        size_t count = 0;
+        size_t j = 0;
+        for (size_t i = 0; i < aCount; ++i) {
+            j = gallop(b, j, bCount, a[i]);
+            if (j < bCount && b[j] == a[i]) ++j;
+            else out[count++] = a[i];
+        }
+        return count;
+    }
+    if (bCount * GALLOP_RATIO < aCount) {
+        // runs of a between ids of short b are copied whole
+        size_t count = 0;
+        size_t i = 0;
+        for (size_t j = 0; j < bCount; ++j) {
+            size_t end = gallop(a, i, aCount, b[j]);
+            count = copyRun(a, i, end, out, count);
+            i = end;
+            if (i < aCount && a[i] == b[j]) ++i;
+        }
+        return copyRun(a, i, aCount, out, count);
+    }
+    return dispatch.select().subtract(a, aCount, b, bCount, out);
+}//konec fce
+
+const char *Sphinx::getIdSetImplementation()
+{
+    return dispatch.select().name;
+}//konec fce
+
+bool Sphinx::setIdSetImplementation(const char *name)
+{
+    return dispatch.force(name);
+}//konec fce
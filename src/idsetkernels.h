@@ -0,0 +1,85 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Merge kernels over sorted document id arrays
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file idsetkernels.h
+
+#ifndef __IDSETKERNELS_H__
+#define __IDSETKERNELS_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+/** @brief writes ids in both sorted arrays a and b into out
+ *
+ *  Arrays hold distinct ids in ascending order, out must have room for
+ *  the smaller of them and must not overlap them. Implementation
+ *  (scalar, SSE4.1 or AVX2 block compare) is chosen by CPU features on
+ *  the first call, much smaller array is galloped through the other.
+ *
+ *  @return count of ids written
+ */
+size_t intersectIds(const uint64_t *a, size_t aCount,
+                    const uint64_t *b, size_t bCount, uint64_t *out);
+
+/** @brief writes ids in a or b into out (room for aCount + bCount)
+ *  @return count of ids written
+ */
+size_t uniteIds(const uint64_t *a, size_t aCount,
+                const uint64_t *b, size_t bCount, uint64_t *out);
+
+/** @brief writes ids in a and not in b into out (room for aCount)
+ *  @return count of ids written
+ */
+size_t subtractIds(const uint64_t *a, size_t aCount,
+                   const uint64_t *b, size_t bCount, uint64_t *out);
+
+/** @brief name of the implementation in use ("scalar", "sse4.1", "avx2")
+ */
+const char *getIdSetImplementation();
+
+/** @brief forces implementation (tests and benchmarks)
+ *  @param name implementation name, 0 selects the best one again
+ *  @return false when the implementation is unknown or the CPU lacks it
+ */
+bool setIdSetImplementation(const char *name);
+
+}//namespace
+
+#endif
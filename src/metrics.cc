@@ -0,0 +1,403 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Library-wide metrics registry - shards shared by threads (assigned
+ * round robin) updated by atomic adds, summed on export
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <sphinxclient/metrics.h>
+#include <sphinxclient/error.h>
+#include <sphinxclient/observer.h>
+
+#include <sstream>
+#include <string.h>
+#include <stdlib.h>
+
+#include "clientmetrics.h"
+#include "probes.h"
+
+namespace {
+
+/// number of shards, threads are assigned round robin
+const size_t SHARD_COUNT = 8;
+
+/// max number of endpoints, the last one is shared by the rest
+const size_t MAX_ENDPOINTS = 16;
+
+/// histogram bucket i counts values up to 2^i, the last one the rest
+const size_t HISTOGRAM_BUCKETS = 24;
+
+/// exception classes from error.h (most derived first)
+enum ErrorClass_t {
+    ERROR_SERVER = 0,
+    ERROR_MESSAGE,
+    ERROR_CONNECTION,
+    ERROR_VALUE_TYPE,
+    ERROR_CLIENT_USAGE,
+    ERROR_OTHER,
+    ERROR_WARNING,
+    ERROR_UNKNOWN,
+    ERROR_CLASS_COUNT
+};
+
+const char *errorClassNames[ERROR_CLASS_COUNT] = {
+    "ServerError_t", "MessageError_t", "ConnectionError_t",
+    "ValueTypeError_t", "ClientUsageError_t", "Error_t", "Warning_t",
+    "unknown"
+};
+
+const char *commandNames[Sphinx::METRICS_COMMAND_COUNT] = {
+    "search", "update", "keywords"
+};
+
+/// labels of QueryState_t, in the order of the enum
+const size_t STATE_COUNT = Sphinx::QS_WAIT_RETRY_CONNECT + 1;
+const char *stateNames[STATE_COUNT] = {
+    "connect", "read_version", "write_version", "write_request",
+    "read_response_header", "read_response", "finished", "failed",
+    "retry_connect"
+};
+
+struct Histogram_t
+{
+    uint64_t buckets[HISTOGRAM_BUCKETS + 1];
+    uint64_t sum;
+};
+
+typedef Histogram_t EndpointHistograms_t[MAX_ENDPOINTS];
+
+/// counters updated by one group of threads, own cache lines
+struct Shard_t
+{
+    uint64_t requests[Sphinx::METRICS_COMMAND_COUNT];
+    int64_t inFlight[Sphinx::METRICS_COMMAND_COUNT];
+    uint64_t errors[Sphinx::METRICS_COMMAND_COUNT][ERROR_CLASS_COUNT];
+    uint64_t connectRetries;
+    uint64_t timeouts[STATE_COUNT];
+    EndpointHistograms_t duration;
+    EndpointHistograms_t responseSize;
+} __attribute__((aligned(64)));
+
+Shard_t shards[SHARD_COUNT];
+
+/// registered endpoint labels, slots are filled once and never freed
+char *endpoints[MAX_ENDPOINTS];
+
+/// shard of the calling thread
+__thread Shard_t *threadShard = 0;
+size_t nextShard = 0;
+
+Shard_t &shard()
+{
+    if (!threadShard) {
+        size_t i = __sync_fetch_and_add(&nextShard, 1);
+        threadShard = &shards[i % SHARD_COUNT];
+    }
+    return *threadShard;
+}//konec fce
+
+template <typename Value_t>
+inline void add(Value_t &counter, Value_t value)
+{
+    __sync_fetch_and_add(&counter, value);
+}//konec fce
+
+void record(Histogram_t &histogram, uint64_t value)
+{
+    // smallest i with value <= 2^i
+    size_t bucket = 0;
+    while (bucket < HISTOGRAM_BUCKETS && (uint64_t(1) << bucket) < value)
+        ++bucket;
+    add(histogram.buckets[bucket], uint64_t(1));
+    add(histogram.sum, value);
+}//konec fce
+
+/// reads counter so that the compiler cannot cache it
+template <typename Value_t>
+inline Value_t load(const Value_t &counter)
+{
+    return *static_cast<const volatile Value_t *>(&counter);
+}//konec fce
+
+/// builds and emits samples
+class Exporter_t
+{
+public:
+    Exporter_t(Sphinx::MetricsCallback_t callback, void *data)
+        : callback(callback), data(data)
+    {}
+
+    void family(const char *name, const char *help, Sphinx::MetricType_t type)
+    {
+        sample.family = name;
+        sample.help = help;
+        sample.type = type;
+    }
+
+    void emit(const std::string &labels, int64_t value,
+              const char *suffix = "")
+    {
+        sample.name = std::string(sample.family) + suffix;
+        sample.labels = labels;
+        sample.value = value;
+        callback(sample, data);
+    }
+
+    void emitHistogram(const std::string &labels,
+                       EndpointHistograms_t Shard_t::*field,
+                       size_t endpoint)
+    {
+        uint64_t count = 0, sum = 0;
+        for (size_t b = 0; b <= HISTOGRAM_BUCKETS; ++b) {
+            for (size_t s = 0; s < SHARD_COUNT; ++s)
+                count += load((shards[s].*field)[endpoint].buckets[b]);
+            std::ostringstream le;
+            le << labels << ",le=\"";
+            if (b < HISTOGRAM_BUCKETS) le << (uint64_t(1) << b);
+            else le << "+Inf";
+            le << "\"";
+            emit(le.str(), count, "_bucket");
+        }
+        for (size_t s = 0; s < SHARD_COUNT; ++s)
+            sum += load((shards[s].*field)[endpoint].sum);
+        emit(labels, sum, "_sum");
+        emit(labels, count, "_count");
+    }
+
+private:
+    Sphinx::MetricsCallback_t callback;
+    void *data;
+    Sphinx::MetricSample_t sample;
+};
+
+std::string endpointLabel(size_t endpoint)
+{
+    // escape as Prometheus label value
+    std::string label("endpoint=\"");
+    for (const char *c = endpoints[endpoint]; *c; ++c) {
+        if (*c == '"' || *c == '\\') label += '\\';
+        label += *c;
+    }
+    return label + "\"";
+}//konec fce
+
+/// state of text export
+struct TextExport_t
+{
+    TextExport_t() : family(0) {}
+
+    std::ostringstream out;
+    const char *family;
+};
+
+void appendText(const Sphinx::MetricSample_t &sample, void *data)
+{
+    static const char *typeNames[] = {"counter", "gauge", "histogram"};
+    TextExport_t &text = *static_cast<TextExport_t *>(data);
+
+    // header before first sample of family
+    if (sample.family != text.family) {
+        text.family = sample.family;
+        text.out << "# HELP " << sample.family << " " << sample.help << "\n"
+                 << "# TYPE " << sample.family << " "
+                 << typeNames[sample.type] << "\n";
+    }
+    text.out << sample.name;
+    if (!sample.labels.empty()) text.out << "{" << sample.labels << "}";
+    text.out << " " << sample.value << "\n";
+}//konec fce
+
+}//namespace
+
+//--------------------------- recording ---------------------------------------
+
+size_t Sphinx::Metrics::registerEndpoint(const std::string &endpoint)
+{
+    // append-only set, slot is claimed by compare and swap
+    for (size_t i = 0; i < MAX_ENDPOINTS - 1; ++i) {
+        char *name = endpoints[i];
+        if (!name) {
+            char *mine = strdup(endpoint.c_str());
+            name = __sync_val_compare_and_swap(&endpoints[i], (char *)0, mine);
+            if (!name) return i;
+            free(mine);
+        }
+        if (endpoint == name) return i;
+    }
+
+    // registry full
+    if (!endpoints[MAX_ENDPOINTS - 1]) {
+        char *other = strdup("other");
+        if (__sync_val_compare_and_swap(&endpoints[MAX_ENDPOINTS - 1],
+                                        (char *)0, other))
+        {
+            free(other);
+        }
+    }
+    return MAX_ENDPOINTS - 1;
+}//konec fce
+
+void Sphinx::Metrics::connectRetry()
+{
+    add(shard().connectRetries, uint64_t(1));
+}//konec fce
+
+void Sphinx::Metrics::timeout(int state)
+{
+    if (state >= 0 && size_t(state) < STATE_COUNT)
+        add(shard().timeouts[state], uint64_t(1));
+}//konec fce
+
+Sphinx::CallMetrics_t::CallMetrics_t(MetricsCommand_t command,
+                                     size_t endpoint)
+    : command(command), endpoint(endpoint), responseSize(0)
+{
+    Shard_t &s = shard();
+    add(s.requests[command], uint64_t(1));
+    add(s.inFlight[command], int64_t(1));
+    ferTimerStart(&timer);
+}//konstruktor
+
+Sphinx::CallMetrics_t::~CallMetrics_t()
+{
+    ferTimerStop(&timer);
+    Shard_t &s = shard();
+    add(s.inFlight[command], int64_t(-1));
+    record(s.duration[endpoint], ferTimerElapsedInUs(&timer));
+    if (responseSize) record(s.responseSize[endpoint], responseSize);
+}//destruktor
+
+void Sphinx::CallMetrics_t::failed()
+{
+    // classify exception being handled
+    ErrorClass_t errorClass;
+    try {
+        throw;
+    } catch (const ServerError_t &) {
+        errorClass = ERROR_SERVER;
+    } catch (const MessageError_t &) {
+        errorClass = ERROR_MESSAGE;
+    } catch (const ConnectionError_t &) {
+        errorClass = ERROR_CONNECTION;
+    } catch (const ValueTypeError_t &) {
+        errorClass = ERROR_VALUE_TYPE;
+    } catch (const ClientUsageError_t &) {
+        errorClass = ERROR_CLIENT_USAGE;
+    } catch (const Error_t &) {
+        errorClass = ERROR_OTHER;
+    } catch (const Warning_t &) {
+        errorClass = ERROR_WARNING;
+    } catch (...) {
+        errorClass = ERROR_UNKNOWN;
+    }
+    SPHINX_PROBE2(call__error, int(command), errorClassNames[errorClass]);
+    add(shard().errors[command][errorClass], uint64_t(1));
+}//konec fce
+
+//--------------------------- export ------------------------------------------
+
+void Sphinx::exportMetrics(MetricsCallback_t callback, void *data)
+{
+    Exporter_t exporter(callback, data);
+
+    exporter.family("sphinxclient_requests_total",
+                    "Client calls per command.", METRIC_COUNTER);
+    for (size_t c = 0; c < METRICS_COMMAND_COUNT; ++c) {
+        uint64_t value = 0;
+        for (size_t s = 0; s < SHARD_COUNT; ++s)
+            value += load(shards[s].requests[c]);
+        exporter.emit(std::string("command=\"") + commandNames[c] + "\"",
+                      value);
+    }
+
+    exporter.family("sphinxclient_requests_in_flight",
+                    "Client calls in progress per command.", METRIC_GAUGE);
+    for (size_t c = 0; c < METRICS_COMMAND_COUNT; ++c) {
+        int64_t value = 0;
+        for (size_t s = 0; s < SHARD_COUNT; ++s)
+            value += load(shards[s].inFlight[c]);
+        exporter.emit(std::string("command=\"") + commandNames[c] + "\"",
+                      value);
+    }
+
+    exporter.family("sphinxclient_errors_total",
+                    "Failed client calls per command and exception class.",
+                    METRIC_COUNTER);
+    for (size_t c = 0; c < METRICS_COMMAND_COUNT; ++c) {
+        for (size_t e = 0; e < ERROR_CLASS_COUNT; ++e) {
+            uint64_t value = 0;
+            for (size_t s = 0; s < SHARD_COUNT; ++s)
+                value += load(shards[s].errors[c][e]);
+            exporter.emit(std::string("command=\"") + commandNames[c]
+                          + "\",class=\"" + errorClassNames[e] + "\"", value);
+        }
+    }
+
+    exporter.family("sphinxclient_connect_retries_total",
+                    "Connect attempts repeated after connect timeout.",
+                    METRIC_COUNTER);
+    uint64_t retries = 0;
+    for (size_t s = 0; s < SHARD_COUNT; ++s)
+        retries += load(shards[s].connectRetries);
+    exporter.emit("", retries);
+
+    exporter.family("sphinxclient_timeouts_total",
+                    "Query timeouts per query machine state.",
+                    METRIC_COUNTER);
+    for (size_t t = 0; t < STATE_COUNT; ++t) {
+        uint64_t value = 0;
+        for (size_t s = 0; s < SHARD_COUNT; ++s)
+            value += load(shards[s].timeouts[t]);
+        exporter.emit(std::string("state=\"") + stateNames[t] + "\"", value);
+    }
+
+    exporter.family("sphinxclient_request_duration_microseconds",
+                    "Client call latency per endpoint.", METRIC_HISTOGRAM);
+    for (size_t e = 0; e < MAX_ENDPOINTS && load(endpoints[e]); ++e)
+        exporter.emitHistogram(endpointLabel(e), &Shard_t::duration, e);
+
+    exporter.family("sphinxclient_response_size_bytes",
+                    "Size of searchd responses per endpoint.",
+                    METRIC_HISTOGRAM);
+    for (size_t e = 0; e < MAX_ENDPOINTS && load(endpoints[e]); ++e)
+        exporter.emitHistogram(endpointLabel(e), &Shard_t::responseSize, e);
+}//konec fce
+
+std::string Sphinx::exportMetricsText()
+{
+    TextExport_t text;
+    exportMetrics(appendText, &text);
+    return text.out.str();
+}//konec fce
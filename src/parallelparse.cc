@@ -0,0 +1,264 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Parallel decoding of multi-query responses
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include "parallelparse.h"
+#include <sphinxclient/error.h>
+#include "timer.h"
+
+#include <list>
+#include <algorithm>
+#include <pthread.h>
+
+void parseResponseVersion(Sphinx::Query_t &, Sphinx::SearchCommandVersion_t,
+                          Sphinx::Response_t &,
+                          const std::vector<std::string> *,
+                          Sphinx::RowSink_t *);
+void skipResponseVersion(Sphinx::Query_t &, Sphinx::SearchCommandVersion_t);
+
+namespace {
+
+/// pool never grows beyond this
+const size_t MAX_POOL_THREADS = 32;
+
+/// smaller multi-query responses are not worth handing to the pool
+const unsigned int MIN_PARALLEL_BYTES = 32768;
+
+/// one ParsePool_t::run() call
+struct Job_t
+{
+    Sphinx::ParsePool_t::Task_t task;
+    void *context;
+    size_t count;
+    /// next index to take
+    size_t next;
+    /// indexes being decoded right now
+    size_t running;
+};
+
+pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+/// signalled when a job is queued
+pthread_cond_t poolWork = PTHREAD_COND_INITIALIZER;
+/// signalled when a task of some job finishes
+pthread_cond_t poolDone = PTHREAD_COND_INITIALIZER;
+/// jobs with indexes left to take
+std::list<Job_t *> poolJobs;
+/// started pool threads
+pthread_t poolThreadIds[MAX_POOL_THREADS];
+size_t poolThreads = 0;
+/// set when the library is being unloaded (or the process exits)
+bool poolStopping = false;
+
+/** @brief takes next index of job and runs it, poolMutex is held
+ *  @return false when the job has nothing left to take
+ */
+bool runNext(Job_t *job)
+{
+    if (job->next >= job->count) return false;
+    size_t index = job->next++;
+    if (job->next == job->count) poolJobs.remove(job);
+    ++job->running;
+
+    pthread_mutex_unlock(&poolMutex);
+    job->task(job->context, index);
+    pthread_mutex_lock(&poolMutex);
+
+    if (!--job->running && job->next == job->count)
+        pthread_cond_broadcast(&poolDone);
+    return true;
+}//konec fce
+
+void *poolThread(void *)
+{
+    pthread_mutex_lock(&poolMutex);
+    for (;;) {
+        while (poolJobs.empty() && !poolStopping)
+            pthread_cond_wait(&poolWork, &poolMutex);
+        // callers finish their jobs themselves
+        if (poolStopping) break;
+        runNext(poolJobs.front());
+    }
+    pthread_mutex_unlock(&poolMutex);
+    return 0;
+}//konec fce
+
+/// starts pool threads up to count, poolMutex is held
+void growPool(size_t count)
+{
+    count = std::min(count, MAX_POOL_THREADS);
+    while (poolThreads < count && !poolStopping) {
+        // calling thread decodes anyway, run with what we have
+        if (pthread_create(&poolThreadIds[poolThreads], 0, poolThread, 0))
+            break;
+        ++poolThreads;
+    }
+}//konec fce
+
+/** @brief Stops and joins pool threads
+ *
+ *  Its static instance is destroyed when the library is unloaded or the
+ *  process exits, so no pool thread outlives the code it runs.
+ */
+struct PoolStopper_t
+{
+    ~PoolStopper_t()
+    {
+        pthread_mutex_lock(&poolMutex);
+        poolStopping = true;
+        pthread_cond_broadcast(&poolWork);
+        size_t count = poolThreads;
+        pthread_mutex_unlock(&poolMutex);
+
+        // threads finish the task at hand first
+        for (size_t i = 0; i < count; ++i)
+            pthread_join(poolThreadIds[i], 0);
+    }
+};
+
+/// destroyed before poolJobs (constructed after it)
+PoolStopper_t poolStopper;
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+void Sphinx::ParsePool_t::run(Task_t task, void *context, size_t count,
+                              size_t threads)
+{
+    if (!count) return;
+    Job_t job = {task, context, count, 0, 0};
+
+    pthread_mutex_lock(&poolMutex);
+    if (threads > 1 && count > 1) {
+        growPool(threads - 1);
+        poolJobs.push_back(&job);
+        pthread_cond_broadcast(&poolWork);
+    }
+    while (runNext(&job)) {}
+    // pool threads may still decode the last indexes
+    while (job.running) pthread_cond_wait(&poolDone, &poolMutex);
+    pthread_mutex_unlock(&poolMutex);
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::ResponseParser_t::ResponseParser_t(Query_t &data, size_t count,
+                                           SearchCommandVersion_t version,
+                                           const QueryStats_t &stats,
+                                           size_t threads,
+                                           Response_t *const *targets,
+                                           const std::vector<std::string>
+                                               *const *projections)
+    : data(data), version(version), stats(stats), targets(targets),
+      projections(projections), current(0)
+{
+    if (threads < 2 || count < 2 || data.getLength() < MIN_PARALLEL_BYTES)
+        return;
+
+    // skip-scan boundaries, sub-responses from a broken one on are
+    // left to serial parsing
+    unsigned int start = data.dataStartPtr;
+    slots.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        slots[i].start = data.dataStartPtr;
+        try {
+            skipResponseVersion(data, version);
+        } catch (...) {
+            slots.resize(i);
+            break;
+        }
+        slots[i].end = data.dataStartPtr;
+    }
+    data.dataStartPtr = start;
+
+    ParsePool_t::run(decodeTask, this, slots.size(), threads);
+}//konstruktor
+
+void Sphinx::ResponseParser_t::decodeTask(void *context, size_t index)
+{
+    ResponseParser_t &parser = *static_cast<ResponseParser_t *>(context);
+    Slot_t &slot = parser.slots[index];
+
+    // read position of its own, the data are shared
+    Query_t view(parser.data, slot.start, slot.end);
+    try {
+        parseResponseStats(view, parser.version,
+                           *parser.targets[index], parser.stats,
+                           parser.getProjection(index));
+        // parse must end where skip-scan did
+        slot.decoded = !view.getLength();
+    } catch (...) {
+        slot.decoded = false;
+    }
+}//konec fce
+
+void Sphinx::ResponseParser_t::next()
+{
+    size_t index = current++;
+    if (index < slots.size()) {
+        Slot_t &slot = slots[index];
+        if (slot.decoded) {
+            data.dataStartPtr = slot.end;
+            return;
+        }
+        data.dataStartPtr = slot.start;
+    }
+    parseResponseStats(data, version, *targets[index], stats,
+                       getProjection(index));
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+void Sphinx::parseResponseStats(Query_t &data, SearchCommandVersion_t version,
+                                Response_t &response,
+                                const QueryStats_t &stats,
+                                const std::vector<std::string> *projection,
+                                RowSink_t *rows)
+{
+    fer_timer_t timer;
+    response.stats = stats;
+    ferTimerStart(&timer);
+    try {
+        parseResponseVersion(data, version, response, projection, rows);
+    } catch (const Warning_t &) {
+        ferTimerStop(&timer);
+        response.stats.parseTime = ferTimerElapsedInUs(&timer);
+        throw;
+    }
+    ferTimerStop(&timer);
+    response.stats.parseTime = ferTimerElapsedInUs(&timer);
+}//konec fce
@@ -0,0 +1,163 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Parallel decoding of multi-query responses
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file parallelparse.h
+
+#ifndef __PARALLELPARSE_H__
+#define __PARALLELPARSE_H__
+
+#include <vector>
+#include <stddef.h>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/sphinxclientquery.h>
+
+namespace Sphinx
+{
+
+/** @brief Process-wide pool of threads decoding responses
+ *
+ *  Threads are started on demand and live until the library is
+ *  unloaded or the process exits, then they are stopped and joined.
+ *  Calls from many client threads share the pool, the calling thread
+ *  decodes too, so the call completes even when all pool threads are
+ *  busy with other calls.
+ */
+class ParsePool_t
+{
+public:
+    /// task decoding item index, must not throw
+    typedef void (*Task_t)(void *context, size_t index);
+
+    /** @brief runs task for indexes 0 .. count - 1 and waits for them
+     *
+     *  Idle threads take the next undone index, so uneven tasks
+     *  balance themselves.
+     *
+     *  @param threads threads wanted (calling thread included), pool
+     *         grows up to this count
+     */
+    static void run(Task_t task, void *context, size_t count,
+                    size_t threads);
+};//class
+
+/** @brief Parses sub-responses of a multi-query one by one
+ *
+ *  With more threads the constructor finds boundaries of the
+ *  sub-responses by skip-scan and decodes them on ParsePool_t ahead,
+ *  each straight into its target response (reusing its memory and
+ *  arena) and reading the shared data in place. next() then only
+ *  steps over them in order. Sub-responses that fail to decode
+ *  (searchd warning or error) are parsed again by next() on the
+ *  calling thread, so the caller sees the same results and exceptions
+ *  as with serial parsing.
+ */
+class ResponseParser_t
+{
+public:
+    /** @brief decodes sub-responses ahead when it pays off
+     *  @param data concatenated sub-responses (read position at first)
+     *  @param count number of sub-responses in data
+     *  @param version command version of the responses
+     *  @param stats stats of the call attached to each response
+     *  @param threads decoding threads (calling thread included),
+     *         1 parses serially in next()
+     *  @param targets output response of each sub-response, decoded
+     *         over (see parseResponseVersion())
+     *  @param projections attributes to decode for each sub-response
+     *         (see SearchConfig_t::setProjection), 0 decodes all
+     */
+    ResponseParser_t(Query_t &data, size_t count,
+                     SearchCommandVersion_t version,
+                     const QueryStats_t &stats, size_t threads,
+                     Response_t *const *targets,
+                     const std::vector<std::string> *const *projections = 0);
+
+    /** @brief parses next sub-response into its target (unless it was
+     *         decoded ahead)
+     *  @throws as parseResponseVersion()
+     */
+    void next();
+
+private:
+    ResponseParser_t(const ResponseParser_t &);
+    ResponseParser_t &operator=(const ResponseParser_t &);
+
+    struct Slot_t
+    {
+        Slot_t() : start(0), end(0), decoded(false) {}
+
+        /// boundaries of the sub-response in data
+        unsigned int start;
+        unsigned int end;
+        /// target holds the sub-response decoded ahead
+        bool decoded;
+    };
+
+    static void decodeTask(void *context, size_t index);
+
+    //! @brief projection of sub-response index
+    const std::vector<std::string> *getProjection(size_t index) const
+    {
+        return projections ? projections[index] : 0;
+    }
+
+    Query_t &data;
+    SearchCommandVersion_t version;
+    const QueryStats_t &stats;
+    Response_t *const *targets;
+    const std::vector<std::string> *const *projections;
+    /// sub-responses with known boundaries
+    std::vector<Slot_t> slots;
+    /// index of the next sub-response
+    size_t current;
+};//class
+
+/** @brief parses one response, attaches stats of the call and the
+ *         time spent parsing (also when searchd returned warning)
+ *  @param projection attributes to decode, 0 or empty for all
+ *  @param rows destination of matches decoded into bound rows instead
+ *         of response entries, 0 for entries
+ */
+void parseResponseStats(Query_t &data, SearchCommandVersion_t version,
+                        Response_t &response, const QueryStats_t &stats,
+                        const std::vector<std::string> *projection = 0,
+                        RowSink_t *rows = 0);
+
+}//namespace
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * USDT probes of the query path (./configure --enable-usdt)
+ *
+ * Provider is "sphinxclient", probes (arguments):
+ *   connect__start     (host, port)
+ *   connect__issued    (socket)
+ *   connect__done      (query, socket, status)
+ *   state__change      (query, old state, new state)
+ *   response__header   (query, status, version, length)
+ *   parse__start       (command version, bytes left)
+ *   parse__done        (command version, matches)
+ *   machine__error     (error code, message)
+ *   call__error        (command, exception class)
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file probes.h
+
+#ifndef __SPHINXPROBES_H__
+#define __SPHINXPROBES_H__
+
+#ifdef HAVE_USDT
+
+// probe site is a nop until a tracer attaches
+#include <sys/sdt.h>
+
+#define SPHINX_PROBE1(name, a) \
+    DTRACE_PROBE1(sphinxclient, name, a)
+#define SPHINX_PROBE2(name, a, b) \
+    DTRACE_PROBE2(sphinxclient, name, a, b)
+#define SPHINX_PROBE3(name, a, b, c) \
+    DTRACE_PROBE3(sphinxclient, name, a, b, c)
+#define SPHINX_PROBE4(name, a, b, c, d) \
+    DTRACE_PROBE4(sphinxclient, name, a, b, c, d)
+
+#else
+
+#define SPHINX_PROBE1(name, a) do {} while (0)
+#define SPHINX_PROBE2(name, a, b) do {} while (0)
+#define SPHINX_PROBE3(name, a, b, c) do {} while (0)
+#define SPHINX_PROBE4(name, a, b, c, d) do {} while (0)
+
+#endif
+
+#endif
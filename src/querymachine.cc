@@ -60,6 +60,7 @@
 
 #include "timer.h"
 #include "querymachine.h"
+#include "clientmetrics.h"
 
 #define INT32_MAX      (2147483647)
 
@@ -87,15 +88,38 @@ void Sphinx::QueryMachine_t::addQuery(const Query_t &query)
         cconfig.getConnectRetriesCount(), cconfig.getConnectRetryWait());
     */
     timeouts.push_back(cconfig.getConnectTimeout());
+    stats.push_back(QueryStats_t());
+    timers.push_back(fer_timer_t());
+    ferTimerStart(&timers.back());
+
+    if (observer) observer->started(makeEvent(qs.size() - 1));
 
     // connect
-    int socket_d = setupConnection(cconfig, ai, aip);
+    int socket_d;
+    try {
+        socket_d = setupConnection(cconfig, ai, aip);
+    } catch (const Error_t &e) {
+        if (observer) notifyFailed(e.errMsg);
+        throw;
+    }
+    stats.back().syscalls++;
 
     // set state and input poll structure
     fdes.addQuery(socket_d, POLLOUT);
 }
 
-void Sphinx::QueryMachine_t::launch()
+void Sphinx::QueryMachine_t::launch(QueryCompletion_t *completion)
+{
+    try {
+        run(completion);
+    } catch (const Error_t &e) {
+        SPHINX_PROBE2(machine__error, int(e.errCode), e.errMsg.c_str());
+        if (observer) notifyFailed(e.errMsg);
+        throw;
+    }
+}
+
+void Sphinx::QueryMachine_t::run(QueryCompletion_t *completion)
 {
     _fer_timer_t timer;
 
@@ -146,6 +170,13 @@ void Sphinx::QueryMachine_t::launch()
                     }
                 }
             }
+
+            // hand finished responses over while others are in flight
+            if (completion) {
+                for (size_t i = 0; i < completed.size(); i++)
+                    completion->completed(completed[i]);
+            }
+            completed.clear();
         } else if (ret == 0) {
             // timeout exceeded - no revents occured
             for (size_t i = 0; i < qs.size(); i++) {
@@ -155,10 +186,14 @@ void Sphinx::QueryMachine_t::launch()
                     // timeout exceeded or is going to be exceeded
                         case QS_WAIT_WR_CONNECT :
                         {
+                            Metrics::timeout(qs[i]);
+                            if (observer) observer->timeout(makeEvent(i));
                             if (connectRetries[i] > 0) {
+                                if (observer)
+                                    observer->connectRetry(makeEvent(i));
                                 //printf("%lu. query: connect timeout exceeded, waiting\n", i+1);
                                 // set query to special waiting state
-                                qs[i] = QS_WAIT_RETRY_CONNECT;
+                                setState(i, QS_WAIT_RETRY_CONNECT);
                                 // add retry wait interval to wait for
                                 setRetryWaitTimeout(i);
                                 // close current socket
@@ -182,7 +217,9 @@ void Sphinx::QueryMachine_t::launch()
                         case QS_FINISHED :
                         case QS_FAILED :
                         {
-                        std::ostringstream o;
+                            Metrics::timeout(qs[i]);
+                            if (observer) observer->timeout(makeEvent(i));
+                            std::ostringstream o;
                             o << i+1 << ". query, ";
                             throw ConnectionError_t(o.str() +
                                 "error at state: " + getQueryStateString(i));
@@ -194,9 +231,12 @@ void Sphinx::QueryMachine_t::launch()
                             // wait timer (between connect retries) expired
                             // setup connection
                             int socket_d = setupConnection(cconfig, ai, aip);
+                            stats[i].syscalls++;
+                            stats[i].connectRetries++;
+                            Metrics::connectRetry();
 
                             // set state, timeout and input poll structure
-                            qs[i] = QS_WAIT_WR_CONNECT;
+                            setState(i, QS_WAIT_WR_CONNECT);
                             setConnectTimeout(i);
                             fdes.addQuery(socket_d, POLLOUT,i);
                             break;
@@ -266,8 +306,12 @@ int Sphinx::QueryMachine_t::setupConnection(
     const Sphinx::ConnectionConfig_t &cconfig,
     struct addrinfo *&ai, struct addrinfo *&aip)
 {
+    SPHINX_PROBE2(connect__start, cconfig.getHost().c_str(),
+                  int(cconfig.getPort()));
     if (cconfig.isDomainSocketUsed()) {
-        return setupLocalConnection(cconfig);
+        int socket_d = setupLocalConnection(cconfig);
+        SPHINX_PROBE1(connect__issued, socket_d);
+        return socket_d;
     }
 
     int socket_d = -1;
@@ -335,6 +379,7 @@ int Sphinx::QueryMachine_t::setupConnection(
         // immediate non-blocking success 
         //printf("immediate non-blocking success for socket %d", socket_d);
     }//if connect < 0
+    SPHINX_PROBE1(connect__issued, socket_d);
     return socket_d;
 }
 
@@ -409,20 +454,23 @@ void Sphinx::QueryMachine_t::handleWrite(nfds_t f)
             socklen_t len = sizeof(int);
             int status;
 
+            stats[q].syscalls++;
             if (::getsockopt(fdes.fds[f].fd, SOL_SOCKET, SO_ERROR,
                              &status, &len))
             {
                 throw Sphinx::ConnectionError_t(
                     strError("Cannot get socket info"));
             }
+            SPHINX_PROBE3(connect__done, q, fdes.fds[f].fd, status);
             if (status)
             {
                 throw Sphinx::ConnectionError_t(
                     strError("Cannot connect socket", status));
             }
+            stats[q].connectTime = elapsedUs(q);
 
             // prepare for reading server version
-            qs[q] = QS_WAIT_RD_VERSION;
+            setState(q, QS_WAIT_RD_VERSION);
             bytesToRead[q] = 4;
             // we want read - wait for socket readable
             fdes.fds[f].events = 0x0 | POLLIN;
@@ -433,15 +481,18 @@ void Sphinx::QueryMachine_t::handleWrite(nfds_t f)
         case QS_WAIT_WR_VERSION :
         {
             // socket writable, write version
+            unsigned int written = bytesWritten[q];
+            stats[q].syscalls++;
             int ret = versions[q].writeOnWritable(fdes.fds[f].fd, bytesWritten[q],
                                             "write_version");
+            stats[q].bytesSent += bytesWritten[q] - written;
 
             if (ret == 0) {
                 // all written, now send query
                 // query already prepared at queries[q], just send
 
                 // set status
-                qs[q] = QS_WAIT_WR_REQUEST;
+                setState(q, QS_WAIT_WR_REQUEST);
                 // reset and set pollfd - wait for writable
                 fdes.fds[f].events = 0x0 | POLLOUT;
                 // reset bytes to write
@@ -459,12 +510,16 @@ void Sphinx::QueryMachine_t::handleWrite(nfds_t f)
         case QS_WAIT_WR_REQUEST :
         {
             // socket, writable, write request
+            unsigned int written = bytesWritten[q];
+            stats[q].syscalls++;
             int ret = queries[q].writeOnWritable(fdes.fds[f].fd, bytesWritten[q],
                                                 "write_request");
+            stats[q].bytesSent += bytesWritten[q] - written;
 
             if (ret == 0) {
+                stats[q].requestTime = elapsedUs(q);
                 // all written, now read response header
-                qs[q] = QS_WAIT_RD_RESPONSE_HEADER;
+                setState(q, QS_WAIT_RD_RESPONSE_HEADER);
                 // pollfds
                 fdes.fds[f].events = 0x0 | POLLIN;
                 // set expected header length
@@ -514,9 +569,13 @@ void Sphinx::QueryMachine_t::handleRead(nfds_t f)
         case QS_WAIT_RD_VERSION :
         {
             // read version
+            int pending = bytesToRead[q];
+            stats[q].syscalls++;
             int ret = versions[q].readOnReadable(fdes.fds[f].fd, bytesToRead[q],
                                                  "read_version");
+            stats[q].bytesReceived += pending - bytesToRead[q];
             if (ret == 0) {
+                stats[q].versionTime = elapsedUs(q);
                 // all read, process version
                 uint32_t version = 0;
                 versions[q] >> version;
@@ -529,7 +588,7 @@ void Sphinx::QueryMachine_t::handleRead(nfds_t f)
                 versions[q].clear();
                 versions[q] << (uint32_t) 1;
                 // set state
-                qs[q] = QS_WAIT_WR_VERSION;
+                setState(q, QS_WAIT_WR_VERSION);
                 // reset and set pollfd - wait for writable
                 fdes.fds[f].events = 0x0 | POLLOUT;
                 // reset bytes to write
@@ -546,10 +605,14 @@ void Sphinx::QueryMachine_t::handleRead(nfds_t f)
         }
         case QS_WAIT_RD_RESPONSE_HEADER :
         {
+            int pending = bytesToRead[q];
+            stats[q].syscalls++;
             int ret = responses[q].readOnReadable(fdes.fds[f].fd, bytesToRead[q],
                                                 "read_response_header");
+            stats[q].bytesReceived += pending - bytesToRead[q];
             // read response header
             if (ret == 0) {
+                stats[q].headerTime = elapsedUs(q);
                 // all read, process header
                 uint32_t length;
                 
@@ -571,6 +634,8 @@ void Sphinx::QueryMachine_t::handleRead(nfds_t f)
                 {
                     throw Sphinx::ServerError_t("Unable to read response length.");
                 }//if
+                SPHINX_PROBE4(response__header, q, int(responseStatuses[q]),
+                              int(responseVersions[q]), length);
             
                 // debug
                 /*printf("length=%d, status=%u, buffLength=%d\n", length,
@@ -578,7 +643,7 @@ void Sphinx::QueryMachine_t::handleRead(nfds_t f)
                 */
 
                 // prepare to receive response body
-                qs[q] = QS_WAIT_RD_RESPONSE;
+                setState(q, QS_WAIT_RD_RESPONSE);
                 bytesToRead[q] = length;
                 // reset and set pollfd - wait for readable
                 fdes.fds[f].events = 0x0 | POLLIN;
@@ -595,11 +660,14 @@ void Sphinx::QueryMachine_t::handleRead(nfds_t f)
         case QS_WAIT_RD_RESPONSE :
         {
             // read response
+            int pending = bytesToRead[q];
+            stats[q].syscalls++;
             int ret = responses[q].readOnReadable(fdes.fds[f].fd, bytesToRead[q],
                                                  "read_response");
+            stats[q].bytesReceived += pending - bytesToRead[q];
             if (ret == 0) {
+                stats[q].responseTime = elapsedUs(q);
                 // all response has been read, finish
-                qs[q] = QS_FINISHED;
                 //printf("%lu. QS_FINISHED, datalen: %u\n", q, responses[q].dataEndPtr);
 
                 if (responseStatuses[q] != SEARCHD_OK) {
@@ -614,8 +682,10 @@ void Sphinx::QueryMachine_t::handleRead(nfds_t f)
                 }
 
                 // done
+                setState(q, QS_FINISHED);
                 fdes.removeFd(f);
                 disableTimeout(q);
+                completed.push_back(q);
             } else if (ret > 0) {
                 // continue - not all read
                 setReadTimeout(q);
@@ -641,6 +711,39 @@ bool Sphinx::QueryMachine_t::finished() const
     return finished;
 }
 
+uint32_t Sphinx::QueryMachine_t::elapsedUs(size_t index)
+{
+    ferTimerStop(&timers[index]);
+    return ferTimerElapsedInUs(&timers[index]);
+}
+
+Sphinx::QueryEvent_t Sphinx::QueryMachine_t::makeEvent(size_t index)
+{
+    QueryEvent_t event;
+    event.query = index;
+    event.connection = &cconfig;
+    event.state = qs[index];
+    event.elapsed = elapsedUs(index);
+    event.stats = &stats[index];
+    return event;
+}
+
+void Sphinx::QueryMachine_t::notifyStateChanged(size_t index,
+                                                QueryState_t state)
+{
+    observer->stateChanged(makeEvent(index), state);
+}
+
+void Sphinx::QueryMachine_t::notifyFailed(const std::string &message)
+{
+    // machine fails as a whole, report all unfinished queries
+    for (size_t i = 0; i < qs.size(); i++) {
+        if (qs[i] == QS_FINISHED || qs[i] == QS_FAILED) continue;
+        observer->failed(makeEvent(i), message);
+        qs[i] = QS_FAILED;
+    }
+}
+
 void Sphinx::QueryMachine_t::setReadTimeout(size_t index)
 {
     timeouts[index] = cconfig.getReadTimeout();
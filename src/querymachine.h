@@ -51,6 +51,9 @@
 #include <netdb.h>
 
 #include "error.h"
+#include <sphinxclient/observer.h>
+#include "timer.h"
+#include "probes.h"
 
 namespace Sphinx
 {
@@ -130,6 +133,23 @@ private:
 
 };
 
+/** @brief Receives responses of queries as they finish
+ *
+ *  Called from QueryMachine_t::launch() between polls, so the response
+ *  can be parsed (and its buffer released) while other queries are
+ *  still in flight. Handler must not throw.
+ */
+class QueryCompletion_t
+{
+public:
+    virtual ~QueryCompletion_t() {}
+
+    /** @brief response of query was received completely
+      * @param index query index
+      */
+    virtual void completed(size_t index) = 0;
+};
+
 /* @brief State machine to send queries and receive
  *        responses with sphinx-searchd.
  *
@@ -137,7 +157,9 @@ private:
  * is launched (by launch()). Machine maintains connection to searchd
  * for each query by non-blocking asynchronous i/o. When all responses are
  * successfully received, the machine is finished and responses
- * can be fetched by getResponse() method.
+ * can be fetched by getResponse() method. With QueryCompletion_t
+ * passed to launch() each response is handed over as soon as it
+ * arrives.
  * 
  * Even when single connection fails, all fails (throws ConnectionError_t)
  *
@@ -156,8 +178,9 @@ public:
      *
      * @param cconfig connection config
      */
-    QueryMachine_t(const ConnectionConfig_t &cconfig)
-        : cconfig(cconfig), ai(0x0), aip(0x0)
+    QueryMachine_t(const ConnectionConfig_t &cconfig,
+                   QueryObserver_t *observer = 0)
+        : cconfig(cconfig), ai(0x0), aip(0x0), observer(observer)
     {}
 
     /* @brief desctructor frees address info structures
@@ -180,8 +203,11 @@ public:
     /** @brief launch query machine - start query processing
       *
       * query machine takes over program control
+      *
+      * @param completion handler notified as each query finishes
+      *        (not owned), may be null
       */
-    void launch();
+    void launch(QueryCompletion_t *completion = 0);
 
     /** Gets response (call after launch successfully finished)
       * @param i query index
@@ -189,8 +215,29 @@ public:
       */
     Sphinx::Query_t & getResponse(int i) {return responses[i];}
 
+    /** Releases buffer of response already processed by the caller
+      * @param i query index
+      */
+    void releaseResponse(int i) {responses[i] = Query_t(0);}
+
+    /** Gets request of query as added
+      * @param i query index
+      * @return serialized request
+      */
+    const Sphinx::Query_t & getQuery(int i) const {return queries[i];}
+
+    /** Gets execution statistics of query (parseTime is left zero)
+      * @param i query index
+      * @return statistics for query with index i
+      */
+    const QueryStats_t & getStats(int i) const {return stats[i];}
+
 
 private:
+    /** @brief poll loop of launch()
+      */
+    void run(QueryCompletion_t *completion);
+
     /** @brief decrement current timeout for all active descriptors
       * @param ms miliseconds to decrement
       */
@@ -242,28 +289,6 @@ private:
     static int setupLocalConnection(
         const Sphinx::ConnectionConfig_t &cconfig);
 
-    /* @brief Internal state of query state machine
-     */
-    enum QueryState_t {
-        /// waiting for connect to finish
-        QS_WAIT_WR_CONNECT          = 0,
-        /// waiting to read the protocol version from server
-        QS_WAIT_RD_VERSION          = 1,
-        /// waiting for write the protocol version to server
-        QS_WAIT_WR_VERSION          = 2,
-        /// wating to write reguest to server
-        QS_WAIT_WR_REQUEST          = 3,
-        /// waiting to read the response header from server
-        QS_WAIT_RD_RESPONSE_HEADER  = 4,
-        /// waiting to read the response body from server
-        QS_WAIT_RD_RESPONSE         = 5,
-        /// query is successfully processed
-        QS_FINISHED                 = 6,
-        /// query processing failed
-        QS_FAILED                   = 7,
-        QS_WAIT_RETRY_CONNECT       = 8,
-    };
-
     /** handle socket writable on filedescriptor
       *
       * Do some action, change state and set new poll event on connection
@@ -280,6 +305,30 @@ private:
       */
     void handleRead(nfds_t fdIndex);
 
+    /** @brief changes state of query, notifies observer
+      * @param index query index
+      * @param state new state
+      */
+    void setState(size_t index, QueryState_t state)
+    {
+        SPHINX_PROBE3(state__change, index, int(qs[index]), int(state));
+        if (observer) notifyStateChanged(index, state);
+        qs[index] = state;
+    }
+
+    /// fills event for observer
+    QueryEvent_t makeEvent(size_t index);
+
+    // observer notifications (called only when observer is set)
+    void notifyStateChanged(size_t index, QueryState_t state);
+    void notifyFailed(const std::string &message);
+
+    /** @brief time elapsed since the query was added
+      * @param index query index
+      * @return microseconds
+      */
+    uint32_t elapsedUs(size_t index);
+
     /** @brief returns true when all processing is done
       *
       */
@@ -302,6 +351,8 @@ private:
     
     /// states of machine (for each query)
     std::vector<QueryState_t> qs;
+    /// queries finished in the last poll round, not yet handed over
+    std::vector<size_t> completed;
 
     /// pending bytes (current read) for each query
     std::vector<int> bytesToRead;
@@ -322,6 +373,14 @@ private:
     /// nr of retries in case od connect timeout occured (for each query)
     /// 0 == disabled
     std::vector<int> connectRetries;
+
+    /// execution statistics (for each query)
+    std::vector<QueryStats_t> stats;
+    /// timers started when query was added (for each query)
+    std::vector<fer_timer_t> timers;
+
+    /// observer of machine events (not owned), may be null
+    QueryObserver_t *observer;
 };
 
 }//namespace
@@ -42,6 +42,9 @@
 #include <sphinxclient/error.h>
 #include <sphinxclient/globals.h>
 #include "filter.h"
+#include "decodeplan.h"
+#include "schemacache.h"
+#include "probes.h"
 
 //-----------------------------------------------------------------------------
 
@@ -224,6 +227,9 @@ void buildQuery_v0_9_9(const std::string &query,
         data << (uint32_t) ovrI->second.first;
         data << (uint32_t) ovrI->second.second.size();
 
+        // grow once for all docs (id and widest value each)
+        data.reserve(ovrI->second.second.size() * 2 * sizeof(uint64_t));
+
         // docs overridden
         for (std::map<uint64_t, Sphinx::Value_t>::const_iterator dI
                 = ovrI->second.second.begin() ;
@@ -253,36 +259,56 @@ void buildQuery_v0_9_9(const std::string &query,
 
 
 
-template<class T>
-std::vector<Sphinx::Value_t> parseMultiAttribute(Sphinx::Query_t &data, int value)
+/** @brief resizes entries keeping their attribute nodes, entries are
+ *         moved by swap when the vector grows
+ */
+static void resizeEntries(std::vector<Sphinx::ResponseEntry_t> &entry,
+                          size_t count)
 {
-    std::vector<Sphinx::Value_t> vec;
+    if (count > entry.capacity() && !entry.empty()) {
+        std::vector<Sphinx::ResponseEntry_t> grown;
+        grown.reserve(count);
+        grown.resize(entry.size());
+        for (size_t i = 0; i < entry.size(); i++) grown[i].swap(entry[i]);
+        entry.swap(grown);
+    }//if
+    entry.resize(count);
+}//konec fce
 
-    for(int i=0 ; i<value ; ++i) {
-        T entVal;
-        data >> entVal;
-        //use conversion constructor to create instance of Value_t
-        vec.push_back(entVal);
+/** @brief releases values of previous response, keeps entries and
+ *         their attribute nodes for reuse
+ */
+static void recycleResponse(Sphinx::Response_t &response)
+{
+    // values may live in the arena, release them first
+    for (std::vector<Sphinx::ResponseEntry_t>::iterator e
+         = response.entry.begin(); e != response.entry.end(); ++e)
+    {
+        for (std::map<std::string, Sphinx::Value_t>::iterator a
+             = e->attribute.begin(); a != e->attribute.end(); ++a)
+        {
+            Sphinx::Value_t().swap(a->second);
+        }//for
     }//for
-
-    return vec;
+    response.arena.clear();
+    response.word.clear();
 }//konec fce
 
-void parseResponse_v0_9_8(Sphinx::Query_t &data, Sphinx::Response_t &response)
+void parseResponse_v0_9_8(Sphinx::Query_t &data, Sphinx::Response_t &response,
+                          const std::vector<std::string> *projection,
+                          Sphinx::RowSink_t *rows)
 {
     uint32_t matchCount;
     uint32_t wordCount;
-    uint32_t fieldCount;
-    uint32_t attrCount;
     uint32_t errorStatus;
     std::string errmsg;
 
-    response.clear();
-
     //read error status
-    if(!(data >> errorStatus))
+    if(!(data >> errorStatus)) {
+        response.clear();
         throw Sphinx::MessageError_t(
                 "Can't read any data. Probably zero-length response.");
+    }//if
     if(errorStatus!=Sphinx::SEARCHD_OK) {
         errmsg = "Response status OK, but query status failed";
         std::string description;
@@ -292,35 +318,23 @@ void parseResponse_v0_9_8(Sphinx::Query_t &data, Sphinx::Response_t &response)
         else
             errmsg += std::string(": ") + description;
 
-        if (errorStatus != Sphinx::SEARCHD_WARNING)
+        if (errorStatus != Sphinx::SEARCHD_WARNING) {
+            response.clear();
             throw Sphinx::MessageError_t(errmsg);
+        }//if
     }//if
 
-    //read fields
-    if (!(data >> fieldCount))
-        throw Sphinx::MessageError_t(
-                "Can't read any field count. Probably too short response.");
+    // previous content is decoded over, its memory is reused
+    recycleResponse(response);
 
-    for (unsigned int i=0 ; i<fieldCount ; i++)
-    {
-        std::string name;
-        data >> name;
-        response.field.push_back(name);
-    }//for
-
-    //read attributes
-    data >> attrCount;
-
-    for (unsigned int i = 0 ; i<attrCount ; i++)
-    {
-        std::string name;
-        uint32_t type;
-
-        data >> name;
-        data >> type;
-
-        response.attribute.push_back(std::make_pair(name, type));
-    }//for
+    // schema is interned, entries are reused as they are when it stays
+    Sphinx::SchemaPtr_t schema = Sphinx::SchemaCache_t::read(data);
+    if (schema.get() != response.schema.get()) {
+        response.field = schema->getFields();
+        response.attribute = schema->getAttributes();
+        response.entry.clear();
+        response.schema = schema;
+    }//if
 
     // number of entries to fetch
     if (!(data >> matchCount))
@@ -328,69 +342,28 @@ void parseResponse_v0_9_8(Sphinx::Query_t &data, Sphinx::Response_t &response)
     // 64bit id ?
     data >> response.use64bitId;
 
-    // fetch matches
-    for (unsigned int i=0 ; i<matchCount ; i++)
-    {
-        Sphinx::ResponseEntry_t entry;
-        if(response.use64bitId)
-            data >> entry.documentId;
-        else {
-            uint32_t docId;
-            data >> docId;
-            entry.documentId = docId;
-        }//else
+    // schema was compiled when seen first, rows are decoded by its steps
+    std::auto_ptr<Sphinx::DecodePlan_t> uncachedPlan;
+    const Sphinx::DecodePlan_t &plan = Sphinx::SchemaCache_t::getPlan(
+            *schema, response.use64bitId, projection, uncachedPlan);
+    if (matchCount > data.getLength() / plan.getMinRowSize())
+        throw Sphinx::MessageError_t(
+                "Error parsing response - match count exceeds data length.");
 
-        data >> entry.weight;
-        entry.groupId = entry.timestamp = 0;
+    // values are placed into response arena in arena mode
+    Sphinx::DecodeScratch_t scratch(response.useArena ? &response.arena : 0);
 
-        //read attribute values
-        for (Sphinx::AttributeTypes_t::iterator attr
-             = response.attribute.begin() ; attr!=response.attribute.end() ;
-             attr++)
-        {
-            if (attr->second == Sphinx::SPH_ATTR_FLOAT) {
-                //process floating point attributes
-                float value;
-                data >> value;
-                //doesn't matter, Value_t has conversion constructor from float
-                entry.attribute.insert(std::make_pair(attr->first, value));
-            } else if (attr->second == Sphinx::SPH_ATTR_BIGINT) {
-                // process uint64_t attributes
-                uint64_t value;
-                data >> value;
-                entry.attribute.insert(std::make_pair(attr->first, value));
-            } else if (attr->second == Sphinx::SPH_ATTR_MULTI ||
-                    attr->second == Sphinx::SPH_ATTR_MULTI_FLAG) {
-                // 32 bit multi-value attribute
-                uint32_t valueCount;
-                data >> valueCount;
-                //parse multi-attributes
-                entry.attribute.insert(std::make_pair(attr->first,
-                        parseMultiAttribute<uint32_t>(data, valueCount)));
-            } else if (attr->second == Sphinx::SPH_ATTR_MULTI64) {
-                // 64 bit multi-value attribute
-                uint32_t valueCount;
-                data >> valueCount;
-                // the count is 32 bit word count instead of value count
-                valueCount >>= 1;
-                //parse multi-attributes
-                entry.attribute.insert(std::make_pair(attr->first,
-                        parseMultiAttribute<uint64_t>(data, valueCount)));
-            } else if (attr->second == Sphinx::SPH_ATTR_STRING) {
-                //process string attributes
-                std::string value;
-                data >> value;
-                entry.attribute.insert(std::make_pair(attr->first, value));
-            } else {
-                //process uint32_t attributes
-                uint32_t value;
-                data >> value;
-                entry.attribute.insert(std::make_pair(attr->first, value));
-            }//else
-        }//for
-
-        response.entry.push_back(entry);
-    }//for
+    if (rows) {
+        // matches go straight into bound rows, binding checked once
+        response.entry.clear();
+        Sphinx::RowPlan_t(*schema, response.use64bitId, rows->getBinding())
+            .decodeRows(data, scratch, matchCount, *rows);
+    } else {
+        // fetch matches, decode them in place
+        resizeEntries(response.entry, matchCount);
+        for (unsigned int i=0 ; i<matchCount ; i++)
+            plan.decodeRow(data, scratch, response.entry[i]);
+    }//if
 
     //uint32_t totalGot, totalFound, timeConsumed;
 
@@ -418,6 +391,45 @@ void parseResponse_v0_9_8(Sphinx::Query_t &data, Sphinx::Response_t &response)
         throw Sphinx::Warning_t(std::string("Warning: ") + errmsg);
 }//konec fce
 
+/** @brief skips one search response without decoding it
+ *
+ *  Reads only lengths and counts to find where the next response of
+ *  multi-query starts. Response with error status holds the message
+ *  only.
+ *
+ *  @throws MessageError_t when the response exceeds data
+ */
+void skipResponse_v0_9_8(Sphinx::Query_t &data)
+{
+    uint32_t status, count;
+    std::string text;
+    const char *truncated = "Error parsing response - response exceeds "
+                            "data length.";
+
+    if (!(data >> status)) throw Sphinx::MessageError_t(truncated);
+    if (status != Sphinx::SEARCHD_OK) {
+        if (!(data >> text)) throw Sphinx::MessageError_t(truncated);
+        if (status != Sphinx::SEARCHD_WARNING) return;
+    }//if
+
+    // schema and matches
+    Sphinx::SchemaPtr_t schema = Sphinx::SchemaCache_t::read(data);
+    uint32_t matchCount, use64bitId;
+    if (!(data >> matchCount >> use64bitId))
+        throw Sphinx::MessageError_t(truncated);
+    Sphinx::SchemaCache_t::getPlan(*schema, use64bitId)
+        .skipRows(data, matchCount);
+
+    // totals and word statistics
+    uint32_t total;
+    if (!(data >> total >> total >> total >> count))
+        throw Sphinx::MessageError_t(truncated);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!(data >> text >> total >> total))
+            throw Sphinx::MessageError_t(truncated);
+    }//for
+}//konec fce
+
 //------------------------------------------------------------------------------
 
 
@@ -437,14 +449,39 @@ void buildQueryVersion(const std::string &query,
 
 void parseResponseVersion(Sphinx::Query_t &data,
                           Sphinx::SearchCommandVersion_t responseVersion,
-                          Sphinx::Response_t &response)
+                          Sphinx::Response_t &response,
+                          const std::vector<std::string> *projection,
+                          Sphinx::RowSink_t *rows)
 {
     switch (responseVersion)
     {
         case Sphinx::VER_COMMAND_SEARCH_0_9_9:
         case Sphinx::VER_COMMAND_SEARCH_2_0_5:
             response.commandVersion = responseVersion;
-            parseResponse_v0_9_8(data, response);
+            SPHINX_PROBE2(parse__start, int(responseVersion),
+                          data.getLength());
+            parseResponse_v0_9_8(data, response, projection, rows);
+            SPHINX_PROBE2(parse__done, int(responseVersion),
+                          response.entry.size());
+            break;
+
+        default:
+            throw Sphinx::MessageError_t(
+                    "Invalid response version (0x101, 0x104, "
+                    "0x113, 0x116 supported).");
+            break;
+    }//switch
+}//konec fce
+
+
+void skipResponseVersion(Sphinx::Query_t &data,
+                         Sphinx::SearchCommandVersion_t responseVersion)
+{
+    switch (responseVersion)
+    {
+        case Sphinx::VER_COMMAND_SEARCH_0_9_9:
+        case Sphinx::VER_COMMAND_SEARCH_2_0_5:
+            skipResponse_v0_9_8(data);
             break;
 
         default:
@@ -566,4 +603,3 @@ void parseKeywordsResponse_v0_9_8(Sphinx::Query_t &data,
     }//for
 }//konec fce
 
-
@@ -0,0 +1,355 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Binary record files - bounded lock-free queue of serialized records
+ * drained into rotating file by background thread, sequential reader
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <sphinxclient/error.h>
+#include "recordfile.h"
+
+#include <sstream>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+
+namespace {
+
+const size_t MAGIC_SIZE = 8;
+const uint64_t HEADER_SIZE = MAGIC_SIZE + sizeof(uint32_t);
+
+/// records written between flushes of the file
+const size_t WRITE_BATCH = 256;
+
+/// slot of the queue, sequence tells whose turn it is
+struct Cell_t
+{
+    volatile size_t sequence;
+    std::string *record;
+};
+
+std::string rotatedName(const std::string &path, uint32_t index)
+{
+    std::ostringstream name;
+    name << path << "." << index;
+    return name.str();
+}//konec fce
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+struct Sphinx::RecordWriter_t::PrivateData_t
+{
+    PrivateData_t(const RecordFormat_t &format, const std::string &path,
+                  uint64_t maxFileSize, uint32_t maxFiles, uint32_t queueSize)
+        : format(format), path(path), maxFileSize(maxFileSize),
+          maxFiles(maxFiles), enqueuePos(0), dequeuePos(0), queued(0),
+          processed(0), written(0), dropped(0), stopping(false), file(0),
+          fileSize(0)
+    {
+        size_t size = 2;
+        while (size < queueSize) size <<= 1;
+        cells.resize(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence = i;
+            cells[i].record = 0;
+        }
+        mask = size - 1;
+    }
+
+    /// adds record, false when queue is full (any thread)
+    bool enqueue(std::string *record);
+    /// takes record, false when queue is empty (writer thread only)
+    bool dequeue(std::string *&record);
+
+    /// opens new file and writes header
+    void open();
+    /// shifts rotated files and opens new one
+    void rotate();
+    /// writes one record
+    void write(const std::string &record);
+
+    static void *writerThread(void *arg);
+
+    RecordFormat_t format;
+    std::string path;
+    uint64_t maxFileSize;
+    uint32_t maxFiles;
+    std::vector<Cell_t> cells;
+    size_t mask;
+
+    // producer and consumer positions on own cache lines (padded, heap
+    // allocation doesn't honour extended alignment in C++98)
+    char pad0[64];
+    size_t enqueuePos;
+    char pad1[64];
+    size_t dequeuePos;
+    char pad2[64];
+
+    uint64_t queued;
+    uint64_t processed;
+    uint64_t written;
+    uint64_t dropped;
+    volatile bool stopping;
+
+    pthread_t thread;
+    FILE *file;
+    uint64_t fileSize;
+};
+
+bool Sphinx::RecordWriter_t::PrivateData_t::enqueue(std::string *record)
+{
+    size_t pos = enqueuePos;
+    for (;;) {
+        Cell_t &cell = cells[pos & mask];
+        intptr_t diff = intptr_t(cell.sequence) - intptr_t(pos);
+        if (diff == 0) {
+            // slot free, claim it
+            if (__sync_bool_compare_and_swap(&enqueuePos, pos, pos + 1))
+                break;
+            pos = enqueuePos;
+        } else if (diff < 0) {
+            // full
+            return false;
+        } else {
+            pos = enqueuePos;
+        }
+    }
+
+    Cell_t &cell = cells[pos & mask];
+    cell.record = record;
+    __sync_synchronize();
+    cell.sequence = pos + 1;
+    return true;
+}//konec fce
+
+bool Sphinx::RecordWriter_t::PrivateData_t::dequeue(std::string *&record)
+{
+    Cell_t &cell = cells[dequeuePos & mask];
+    if (cell.sequence != dequeuePos + 1) return false;
+    __sync_synchronize();
+    record = cell.record;
+    cell.record = 0;
+    __sync_synchronize();
+    cell.sequence = dequeuePos + mask + 1;
+    ++dequeuePos;
+    return true;
+}//konec fce
+
+void Sphinx::RecordWriter_t::PrivateData_t::open()
+{
+    file = fopen(path.c_str(), "wb");
+    if (!file) return;
+    uint32_t version = htonl(format.version);
+    fwrite(format.magic, MAGIC_SIZE, 1, file);
+    fwrite(&version, sizeof(version), 1, file);
+    fileSize = HEADER_SIZE;
+}//konec fce
+
+void Sphinx::RecordWriter_t::PrivateData_t::rotate()
+{
+    if (file) fclose(file);
+    file = 0;
+    if (maxFiles) {
+        for (uint32_t i = maxFiles - 1; i > 0; --i) {
+            ::rename(rotatedName(path, i).c_str(),
+                     rotatedName(path, i + 1).c_str());
+        }
+        ::rename(path.c_str(), rotatedName(path, 1).c_str());
+    }
+    open();
+}//konec fce
+
+void Sphinx::RecordWriter_t::PrivateData_t::write(const std::string &record)
+{
+    uint64_t size = sizeof(uint32_t) + record.size();
+    if (fileSize > HEADER_SIZE && fileSize + size > maxFileSize)
+        rotate();
+    if (!file) return;
+
+    uint32_t length = htonl(record.size());
+    if (fwrite(&length, sizeof(length), 1, file) != 1
+        || fwrite(record.data(), record.size(), 1, file) != 1)
+    {
+        return;
+    }
+    fileSize += size;
+    __sync_fetch_and_add(&written, 1);
+}//konec fce
+
+void *Sphinx::RecordWriter_t::PrivateData_t::writerThread(void *arg)
+{
+    PrivateData_t &d = *static_cast<PrivateData_t *>(arg);
+    uint64_t processed = 0;
+    for (;;) {
+        // when stopping, only the records queued so far are written, so
+        // that ongoing submits can't keep the thread running
+        bool stop = d.stopping;
+        uint64_t stopAt = stop ? __sync_fetch_and_add(&d.queued, 0) : 0;
+        size_t batch = 0;
+        std::string *record;
+        while ((stop ? processed < stopAt : batch < WRITE_BATCH)
+               && d.dequeue(record))
+        {
+            d.write(*record);
+            delete record;
+            ++processed;
+            ++batch;
+        }
+
+        // records of the batch are visible in the file from now
+        if (d.file) fflush(d.file);
+        __sync_lock_test_and_set(&d.processed, processed);
+        if (stop) break;
+        if (batch < WRITE_BATCH) usleep(2000);
+    }
+    return 0;
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::RecordWriter_t::RecordWriter_t(const RecordFormat_t &format,
+                                       const std::string &path,
+                                       uint64_t maxFileSize,
+                                       uint32_t maxFiles, uint32_t queueSize)
+    : d(new PrivateData_t(format, path, maxFileSize, maxFiles, queueSize))
+{
+    // keep file of previous run
+    if (::access(path.c_str(), F_OK) == 0) d->rotate();
+    else d->open();
+    if (!d->file) {
+        std::string msg = strError((std::string("Can't open ") + format.name
+                                    + " " + path).c_str());
+        delete d;
+        throw ClientUsageError_t(msg);
+    }
+    int ret = pthread_create(&d->thread, 0, PrivateData_t::writerThread, d);
+    if (ret) {
+        fclose(d->file);
+        std::string msg = strError((std::string("Can't start ") + format.name
+                                    + " writer").c_str(), ret);
+        delete d;
+        throw ClientUsageError_t(msg);
+    }
+}//konstruktor
+
+Sphinx::RecordWriter_t::~RecordWriter_t()
+{
+    d->stopping = true;
+    pthread_join(d->thread, 0);
+    if (d->file) fclose(d->file);
+
+    // records queued after stop
+    std::string *record;
+    while (d->dequeue(record)) delete record;
+    delete d;
+}//destruktor
+
+bool Sphinx::RecordWriter_t::submit(const Query_t &record)
+{
+    std::string *serialized = new std::string(
+        reinterpret_cast<const char *>(record.data + record.dataStartPtr),
+        record.getLength());
+    if (!d->enqueue(serialized)) {
+        delete serialized;
+        __sync_fetch_and_add(&d->dropped, 1);
+        return false;
+    }
+    __sync_fetch_and_add(&d->queued, 1);
+    return true;
+}//konec fce
+
+void Sphinx::RecordWriter_t::flush()
+{
+    uint64_t target = __sync_fetch_and_add(&d->queued, 0);
+    while (__sync_fetch_and_add(&d->processed, 0) < target)
+        usleep(1000);
+}//konec fce
+
+uint64_t Sphinx::RecordWriter_t::getWritten() const
+{
+    return __sync_fetch_and_add(&d->written, 0);
+}//konec fce
+
+uint64_t Sphinx::RecordWriter_t::getDropped() const
+{
+    return __sync_fetch_and_add(&d->dropped, 0);
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::RecordReader_t::RecordReader_t(const RecordFormat_t &format,
+                                       const std::string &path)
+    : file(fopen(path.c_str(), "rb"))
+{
+    if (!file)
+        throw ClientUsageError_t(strError((std::string("Can't open ")
+                                           + format.name + " "
+                                           + path).c_str()));
+    char magic[MAGIC_SIZE];
+    uint32_t version;
+    if (fread(magic, sizeof(magic), 1, file) != 1
+        || memcmp(magic, format.magic, sizeof(magic))
+        || fread(&version, sizeof(version), 1, file) != 1
+        || ntohl(version) != format.version)
+    {
+        fclose(file);
+        throw ClientUsageError_t(std::string("Not a ") + format.name + ": "
+                                 + path);
+    }
+}//konstruktor
+
+Sphinx::RecordReader_t::~RecordReader_t()
+{
+    fclose(file);
+}//destruktor
+
+bool Sphinx::RecordReader_t::next(Query_t &data)
+{
+    uint32_t length;
+    if (fread(&length, sizeof(length), 1, file) != 1) return false;
+    length = ntohl(length);
+
+    std::vector<char> buffer(length);
+    if (length && fread(&buffer[0], length, 1, file) != 1) return false;
+
+    data.clear();
+    data.convertEndian = true;
+    if (length) data.append(&buffer[0], length);
+    return true;
+}//konec fce
@@ -0,0 +1,149 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Binary record files shared by slow query log and request capture
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file recordfile.h
+
+#ifndef __RECORDFILE_H__
+#define __RECORDFILE_H__
+
+#include <sphinxclient/sphinxclientquery.h>
+
+#include <stdio.h>
+#include <string>
+#include <stdint.h>
+
+namespace Sphinx
+{
+
+/** @brief Format of record file
+ *
+ *  File starts with 8 bytes of magic and uint32_t format version,
+ *  followed by records, each prefixed by uint32_t length. Numbers are
+ *  in network byte order.
+ */
+struct RecordFormat_t
+{
+    /// magic, exactly 8 characters
+    const char *magic;
+    /// format version
+    uint32_t version;
+    /// file description for error messages
+    const char *name;
+};//struct
+
+/** @brief Writes records to rotating file from background thread
+ *
+ *  submit() only copies the record into bounded lock-free MPSC queue,
+ *  record is dropped when the queue is full. Writer thread drains the
+ *  queue into the file and flushes it after each batch of records (or
+ *  when the queue gets empty), so flush() and the destructor finish
+ *  under sustained submission too.
+ */
+class RecordWriter_t
+{
+public:
+    /** @brief rotates existing file, opens new one and starts writer thread
+     *  @param maxFileSize rotate when the file would exceed (bytes)
+     *  @param maxFiles number of rotated files (.1, .2, ...) kept
+     *  @param queueSize queue capacity (records), rounded up to power of 2
+     *  @throws ClientUsageError_t when file can't be opened
+     */
+    RecordWriter_t(const RecordFormat_t &format, const std::string &path,
+                   uint64_t maxFileSize, uint32_t maxFiles,
+                   uint32_t queueSize);
+
+    //! @brief writes pending records and stops writer thread
+    ~RecordWriter_t();
+
+    /** @brief queues serialized record (any thread)
+     *  @return false when the queue is full and record was dropped
+     */
+    bool submit(const Query_t &record);
+
+    //! @brief blocks until the records queued so far are in the file
+    void flush();
+
+    //! @brief number of records written to file
+    uint64_t getWritten() const;
+
+    //! @brief number of records dropped on full queue
+    uint64_t getDropped() const;
+
+private:
+    RecordWriter_t(const RecordWriter_t &);
+    RecordWriter_t &operator=(const RecordWriter_t &);
+
+    struct PrivateData_t;
+    PrivateData_t *d;
+};//class
+
+/** @brief Reads records of record file
+ */
+class RecordReader_t
+{
+public:
+    /** @brief opens file and checks its header
+     *  @throws ClientUsageError_t when file can't be opened or has
+     *          different format
+     */
+    RecordReader_t(const RecordFormat_t &format, const std::string &path);
+    ~RecordReader_t();
+
+    /** @brief reads next record into data (convertEndian set)
+     *  @return false at the end of file (or on truncated record)
+     */
+    bool next(Query_t &data);
+
+private:
+    RecordReader_t(const RecordReader_t &);
+    RecordReader_t &operator=(const RecordReader_t &);
+
+    FILE *file;
+};//class
+
+/** @brief reads one value of record
+ *  @return false when record is too short
+ */
+template <typename Value_t>
+inline bool readField(Query_t &data, Value_t &value)
+{
+    return !!(data >> value);
+}//konec fce
+
+}//namespace
+
+#endif
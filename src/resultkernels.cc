@@ -0,0 +1,383 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Sorting, filtering and grouping of decoded matches by attribute columns
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <sphinxclient/resultkernels.h>
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/error.h>
+
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+/// radix digit width of sortRows() (bits)
+const unsigned int DIGIT_BITS = 8;
+const size_t DIGITS = 1 << DIGIT_BITS;
+const unsigned int PASSES = 64 / DIGIT_BITS;
+
+/// float of key made by Column_t::floatKey()
+inline float keyFloat(uint64_t key)
+{
+    uint32_t bits = key;
+    bits = (bits & 0x80000000U) ? (bits & 0x7fffffffU) : ~bits;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}//konec fce
+
+/// key of row by sort key, descending keys are inverted
+inline uint64_t sortKey(const Sphinx::SortKey_t &key, uint32_t row)
+{
+    uint64_t value = key.column->getKeys()[row];
+    return key.descending ? ~value : value;
+}//konec fce
+
+/// slot of key in group table of 2^(64 - shift) slots
+inline size_t groupHash(uint64_t key, unsigned int shift)
+{
+    return (key * 0x9e3779b97f4a7c15ULL) >> shift;
+}//konec fce
+
+/// row kept for topRows(), first key cached
+struct Candidate_t
+{
+    uint64_t first;
+    /// index into input rows, breaks ties
+    uint32_t position;
+};
+
+/// orders candidates by keys, better first
+class Better_t
+{
+public:
+    Better_t(const Sphinx::SortKeys_t &keys, const uint32_t *rows)
+        : keys(keys), rows(rows)
+    {}
+
+    bool operator()(const Candidate_t &a, const Candidate_t &b) const
+    {
+        if (a.first != b.first) return a.first < b.first;
+        for (size_t i = 1; i < keys.size(); ++i) {
+            uint64_t x = sortKey(keys[i], rows[a.position]);
+            uint64_t y = sortKey(keys[i], rows[b.position]);
+            if (x != y) return x < y;
+        }
+        return a.position < b.position;
+    }
+
+private:
+    const Sphinx::SortKeys_t &keys;
+    const uint32_t *rows;
+};//class
+
+/** @brief keeps rows with key in range of keys (branch free), kept may
+ *         be rows
+ */
+void filterKeys(const std::vector<uint64_t> &keys, uint64_t minKey,
+                uint64_t maxKey, bool exclude,
+                const std::vector<uint32_t> &rows,
+                std::vector<uint32_t> &kept)
+{
+    if (minKey > maxKey) {
+        // empty range
+        if (!exclude) kept.clear();
+        else if (&kept != &rows) kept = rows;
+        return;
+    }
+    size_t count = rows.size();
+    if (&kept != &rows) kept.resize(count);
+    if (!count) return;
+
+    const uint64_t *values = keys.empty() ? 0 : &keys[0];
+    const uint32_t *in = &rows[0];
+    uint32_t *out = &kept[0];
+    uint64_t span = maxKey - minKey;
+    size_t found = 0;
+    // in place filtering only writes behind the read position
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t row = in[i];
+        out[found] = row;
+        found += (values[row] - minKey <= span) != exclude;
+    }
+    kept.resize(found);
+}//konec fce
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+Sphinx::Column_t::Column_t(const Response_t &response, const std::string &name)
+    : keys(response.entry.size()), floating(false)
+{
+    const std::vector<ResponseEntry_t> &entry = response.entry;
+    if (name == "@id") {
+        for (size_t i = 0; i < entry.size(); ++i)
+            keys[i] = entry[i].documentId;
+        return;
+    }
+    if (name == "@weight") {
+        for (size_t i = 0; i < entry.size(); ++i) keys[i] = entry[i].weight;
+        return;
+    }
+
+    for (size_t i = 0; i < entry.size(); ++i) {
+        std::map<std::string, Value_t>::const_iterator value
+            = entry[i].attribute.find(name);
+        if (value == entry[i].attribute.end() || !value->second.isValid())
+            throw ValueTypeError_t("Attribute " + name
+                                   + " is missing in response entry.");
+        ValueType_t type = value->second.getValueType();
+        if (!i) floating = type == VALUETYPE_FLOAT;
+        if (floating && type == VALUETYPE_FLOAT) {
+            keys[i] = floatKey(static_cast<float>(value->second));
+        } else if (!floating && type == VALUETYPE_UINT32) {
+            keys[i] = static_cast<uint32_t>(value->second);
+        } else if (!floating && type == VALUETYPE_UINT64) {
+            keys[i] = static_cast<uint64_t>(value->second);
+        } else {
+            throw ValueTypeError_t("Attribute " + name
+                                   + " is not a number of one type.");
+        }
+    }
+}//konstruktor
+
+Sphinx::Column_t::Column_t(const std::vector<uint64_t> &values)
+    : keys(values), floating(false)
+{}//konstruktor
+
+Sphinx::Column_t::Column_t(const std::vector<uint32_t> &values)
+    : keys(values.begin(), values.end()), floating(false)
+{}//konstruktor
+
+Sphinx::Column_t::Column_t(const std::vector<float> &values)
+    : keys(values.size()), floating(true)
+{
+    for (size_t i = 0; i < values.size(); ++i) keys[i] = floatKey(values[i]);
+}//konstruktor
+
+uint64_t Sphinx::Column_t::getUInt(size_t row) const
+{
+    return floating ? static_cast<uint64_t>(keyFloat(keys[row])) : keys[row];
+}//konec fce
+
+float Sphinx::Column_t::getFloat(size_t row) const
+{
+    return floating ? keyFloat(keys[row]) : static_cast<float>(keys[row]);
+}//konec fce
+
+uint64_t Sphinx::Column_t::floatKey(float value)
+{
+    // negative zero sorts with zero
+    if (value == 0) value = 0;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000U) ? ~bits : (bits | 0x80000000U);
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+void Sphinx::selectAllRows(size_t count, std::vector<uint32_t> &rows)
+{
+    rows.resize(count);
+    for (size_t i = 0; i < count; ++i) rows[i] = i;
+}//konec fce
+
+void Sphinx::sortRows(const SortKeys_t &keys, std::vector<uint32_t> &rows)
+{
+    size_t count = rows.size();
+    if (count < 2) return;
+    std::vector<uint64_t> values(count), valuesTmp(count);
+    std::vector<uint32_t> rowsTmp(count);
+    std::vector<size_t> counts(PASSES * DIGITS);
+
+    // least significant key first, each pass is stable
+    for (size_t k = keys.size(); k-- > 0; ) {
+        // digits that are the same in all keys need no pass
+        uint64_t anyBits = 0;
+        uint64_t allBits = ~uint64_t(0);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t value = sortKey(keys[k], rows[i]);
+            values[i] = value;
+            anyBits |= value;
+            allBits &= value;
+        }
+        uint64_t varying = anyBits ^ allBits;
+
+        unsigned int passes[PASSES];
+        unsigned int passCount = 0;
+        for (unsigned int p = 0; p < PASSES; ++p)
+            if ((varying >> (p * DIGIT_BITS)) & (DIGITS - 1))
+                passes[passCount++] = p;
+
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < count; ++i) {
+            for (unsigned int p = 0; p < passCount; ++p) {
+                unsigned int shift = passes[p] * DIGIT_BITS;
+                ++counts[p * DIGITS + ((values[i] >> shift) & (DIGITS - 1))];
+            }
+        }
+
+        for (unsigned int p = 0; p < passCount; ++p) {
+            size_t *offsets = &counts[p * DIGITS];
+            unsigned int shift = passes[p] * DIGIT_BITS;
+            size_t offset = 0;
+            for (size_t d = 0; d < DIGITS; ++d) {
+                size_t digitCount = offsets[d];
+                offsets[d] = offset;
+                offset += digitCount;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                size_t position = offsets[(values[i] >> shift) & (DIGITS - 1)]++;
+                valuesTmp[position] = values[i];
+                rowsTmp[position] = rows[i];
+            }
+            values.swap(valuesTmp);
+            rows.swap(rowsTmp);
+        }
+    }
+}//konec fce
+
+void Sphinx::topRows(const SortKeys_t &keys, size_t count,
+                     const std::vector<uint32_t> &rows,
+                     std::vector<uint32_t> &top)
+{
+    if (count >= rows.size() || keys.empty()) {
+        if (&top != &rows) top = rows;
+        sortRows(keys, top);
+        if (top.size() > count) top.resize(count);
+        return;
+    }
+    if (!count) {
+        top.clear();
+        return;
+    }
+
+    // heap of the best rows so far, the worst on top
+    Better_t better(keys, &rows[0]);
+    std::vector<Candidate_t> heap;
+    heap.reserve(count);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        Candidate_t candidate = {sortKey(keys[0], rows[i]),
+                                 static_cast<uint32_t>(i)};
+        if (heap.size() < count) {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end(), better);
+        } else if (better(candidate, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), better);
+
+    std::vector<uint32_t> best(count);
+    for (size_t i = 0; i < count; ++i) best[i] = rows[heap[i].position];
+    top.swap(best);
+}//konec fce
+
+void Sphinx::filterRange(const Column_t &column, uint64_t minValue,
+                         uint64_t maxValue, bool exclude,
+                         const std::vector<uint32_t> &rows,
+                         std::vector<uint32_t> &kept)
+{
+    if (column.isFloat())
+        throw ValueTypeError_t("Integer range filter of float column.");
+    filterKeys(column.getKeys(), minValue, maxValue, exclude, rows, kept);
+}//konec fce
+
+void Sphinx::filterFloatRange(const Column_t &column, float minValue,
+                              float maxValue, bool exclude,
+                              const std::vector<uint32_t> &rows,
+                              std::vector<uint32_t> &kept)
+{
+    if (!column.isFloat())
+        throw ValueTypeError_t("Float range filter of integer column.");
+    filterKeys(column.getKeys(), Column_t::floatKey(minValue),
+               Column_t::floatKey(maxValue), exclude, rows, kept);
+}//konec fce
+
+void Sphinx::groupRows(const Column_t &column, const Column_t *sum,
+                       const std::vector<uint32_t> &rows,
+                       std::vector<Group_t> &groups)
+{
+    groups.clear();
+    if (rows.empty()) return;
+    const std::vector<uint64_t> &keys = column.getKeys();
+
+    // open addressing by key, slots hold group index + 1 and are kept at
+    // most half full
+    std::vector<uint64_t> groupKeys;
+    std::vector<uint32_t> slots(64);
+    unsigned int shift = 64 - 6;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        uint32_t row = rows[i];
+        uint64_t key = keys[row];
+        size_t mask = slots.size() - 1;
+        size_t slot = groupHash(key, shift);
+        while (slots[slot] && groupKeys[slots[slot] - 1] != key)
+            slot = (slot + 1) & mask;
+
+        size_t index;
+        if (slots[slot]) {
+            index = slots[slot] - 1;
+        } else {
+            index = groups.size();
+            Group_t group = {row, 0, 0};
+            groups.push_back(group);
+            groupKeys.push_back(key);
+            slots[slot] = index + 1;
+            if (2 * groups.size() > slots.size()) {
+                slots.assign(2 * slots.size(), 0);
+                --shift;
+                mask = slots.size() - 1;
+                for (size_t g = 0; g < groupKeys.size(); ++g) {
+                    size_t s = groupHash(groupKeys[g], shift);
+                    while (slots[s]) s = (s + 1) & mask;
+                    slots[s] = g + 1;
+                }
+            }
+        }
+
+        Group_t &group = groups[index];
+        ++group.count;
+        if (sum) {
+            group.sum += sum->isFloat() ? sum->getFloat(row)
+                : static_cast<double>(sum->getKeys()[row]);
+        }
+    }
+}//konec fce
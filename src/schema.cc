@@ -0,0 +1,423 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Interned response schemas
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include "schemacache.h"
+#include "decodeplan.h"
+#include <sphinxclient/error.h>
+
+#include <map>
+#include <pthread.h>
+
+namespace {
+
+/// least recently used schema is evicted when the cache holds this many
+const size_t MAX_CACHED_SCHEMAS = 1024;
+
+/// projections whose plans are kept by one schema, further ones are
+/// compiled for each response
+const size_t MAX_PROJECTED_PLANS = 16;
+
+/// seeds tried for one table size before it is doubled
+const uint32_t PERFECT_HASH_SEEDS = 64;
+
+/// FNV-1a of attribute name, seed varies the hash for perfect hashing
+inline uint32_t nameHash(const std::string &name, uint32_t seed)
+{
+    uint32_t hash = 2166136261U ^ (seed * 0x9e3779b9U);
+    for (size_t i = 0; i < name.size(); ++i) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619U;
+    }
+    return hash ^ (hash >> 15);
+}//konec fce
+
+/// FNV-1a of schema bytes
+uint64_t bytesHash(const unsigned char *data, unsigned int length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned int i = 0; i < length; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}//konec fce
+
+/// skips string at read position
+void skipString(Sphinx::Query_t &data)
+{
+    uint32_t length;
+    if (!(data >> length) || length > data.getLength())
+        throw Sphinx::MessageError_t(
+                "Error parsing response - schema exceeds data length.");
+    data.dataStartPtr += length;
+}//konec fce
+
+typedef std::map<uint64_t, std::vector<Sphinx::SchemaPtr_t> > Cache_t;
+
+/// lookups take it shared, inserts exclusive
+pthread_rwlock_t cacheLock = PTHREAD_RWLOCK_INITIALIZER;
+/// schemas by hash of their bytes
+Cache_t cache;
+size_t cacheSize = 0;
+/// count of inserts so far, schemas are stamped by it when used
+volatile unsigned long cacheEpoch = 0;
+
+/// schema the calling thread got last, hit without touching the cache
+pthread_once_t lastHitOnce = PTHREAD_ONCE_INIT;
+pthread_key_t lastHitKey;
+
+void dropLastHit(void *last)
+{
+    delete static_cast<Sphinx::SchemaPtr_t *>(last);
+}//konec fce
+
+void createLastHitKey()
+{
+    pthread_key_create(&lastHitKey, dropLastHit);
+}//konec fce
+
+Sphinx::SchemaPtr_t &lastHit()
+{
+    pthread_once(&lastHitOnce, createLastHitKey);
+    Sphinx::SchemaPtr_t *last
+        = static_cast<Sphinx::SchemaPtr_t *>(pthread_getspecific(lastHitKey));
+    if (!last) {
+        last = new Sphinx::SchemaPtr_t();
+        pthread_setspecific(lastHitKey, last);
+    }
+    return *last;
+}//konec fce
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+const size_t Sphinx::Schema_t::NO_ATTRIBUTE;
+
+struct Sphinx::Schema_t::PrivateData_t
+{
+    PrivateData_t(const AttributeTypes_t &attributes)
+        : lastUsed(cacheEpoch), plan32(attributes, false),
+          plan64(attributes, true), projectedCount(0)
+    {
+        pthread_mutex_init(&mutex, 0);
+    }
+
+    ~PrivateData_t()
+    {
+        for (size_t i = 0; i < projectedCount; ++i) delete projected[i];
+        pthread_mutex_destroy(&mutex);
+    }
+
+    /// whether the schema was read from these bytes
+    bool holds(const unsigned char *data, unsigned int length,
+               bool convertEndian) const
+    {
+        return this->convertEndian == convertEndian
+            && bytes.size() == length
+            && !bytes.compare(0, length, reinterpret_cast<const char *>(data),
+                              length);
+    }
+
+    /// stamps the schema as used, shared line is written only when the
+    /// stamp changes
+    void touch()
+    {
+        unsigned long now = cacheEpoch;
+        if (lastUsed != now) lastUsed = now;
+    }
+
+    /// plan decoding projected attributes only
+    struct Projected_t
+    {
+        Projected_t(const AttributeTypes_t &attributes, bool use64bitId,
+                    const std::vector<std::string> &projection)
+            : use64bitId(use64bitId), projection(projection),
+              plan(attributes, use64bitId, &projection)
+        {}
+
+        bool use64bitId;
+        std::vector<std::string> projection;
+        DecodePlan_t plan;
+    };
+
+    /// schema bytes as received, the cache key
+    std::string bytes;
+    bool convertEndian;
+    /// cache epoch when the schema was used last
+    volatile unsigned long lastUsed;
+    DecodePlan_t plan32;
+    DecodePlan_t plan64;
+    /// serializes adding projected plans
+    pthread_mutex_t mutex;
+    /// plans compiled for projections so far, they come from code so
+    /// there are few of them; published ones never change or move, so
+    /// readers scan them without the mutex
+    Projected_t *projected[MAX_PROJECTED_PLANS];
+    volatile size_t projectedCount;
+};
+
+Sphinx::Schema_t::Schema_t()
+    : seed(0), d(0), refs(0)
+{}//konstruktor
+
+Sphinx::Schema_t::~Schema_t()
+{
+    delete d;
+}//destruktor
+
+size_t Sphinx::Schema_t::findAttribute(const std::string &name) const
+{
+    if (slots.empty()) return NO_ATTRIBUTE;
+    uint32_t slot = slots[nameHash(name, seed) & (slots.size() - 1)];
+    if (slot && attributes[slot - 1].first == name) return slot - 1;
+    return NO_ATTRIBUTE;
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::SchemaPtr_t::SchemaPtr_t(Schema_t *schema)
+    : schema(schema)
+{
+    if (schema) __sync_add_and_fetch(&schema->refs, 1);
+}//konstruktor
+
+Sphinx::SchemaPtr_t::SchemaPtr_t(const SchemaPtr_t &from)
+    : schema(from.schema)
+{
+    if (schema) __sync_add_and_fetch(&schema->refs, 1);
+}//konstruktor
+
+Sphinx::SchemaPtr_t &Sphinx::SchemaPtr_t::operator=(const SchemaPtr_t &from)
+{
+    SchemaPtr_t(from).swap(*this);
+    return *this;
+}//konec fce
+
+Sphinx::SchemaPtr_t::~SchemaPtr_t()
+{
+    if (schema && !__sync_sub_and_fetch(&schema->refs, 1)) delete schema;
+}//destruktor
+
+//------------------------------------------------------------------------------
+
+Sphinx::SchemaPtr_t Sphinx::SchemaCache_t::read(Query_t &data)
+{
+    // find the end of the schema by lengths only
+    unsigned int start = data.dataStartPtr;
+    uint32_t count;
+    if (!(data >> count))
+        throw MessageError_t(
+                "Can't read any field count. Probably too short response.");
+    if (count > data.getLength() / sizeof(uint32_t))
+        throw MessageError_t(
+                "Error parsing response - field count exceeds data length.");
+    for (uint32_t i = 0; i < count; ++i) skipString(data);
+
+    if (!(data >> count) || count > data.getLength() / (2 * sizeof(uint32_t)))
+        throw MessageError_t(
+                "Error parsing response - attribute count exceeds data "
+                "length.");
+    for (uint32_t i = 0; i < count; ++i) {
+        skipString(data);
+        if (data.getLength() < sizeof(uint32_t))
+            throw MessageError_t(
+                    "Error parsing response - schema exceeds data length.");
+        data.dataStartPtr += sizeof(uint32_t);
+    }
+
+    const unsigned char *bytes = data.data + start;
+    unsigned int length = data.dataStartPtr - start;
+    uint64_t hash = bytesHash(bytes, length) ^ data.convertEndian;
+
+    // responses of one thread mostly repeat the schema
+    SchemaPtr_t &last = lastHit();
+    if (last.get() && last->d->holds(bytes, length, data.convertEndian)) {
+        last->d->touch();
+        return last;
+    }
+
+    pthread_rwlock_rdlock(&cacheLock);
+    Cache_t::const_iterator found = cache.find(hash);
+    if (found != cache.end()) {
+        const std::vector<SchemaPtr_t> &candidates = found->second;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (candidates[i]->d->holds(bytes, length, data.convertEndian)) {
+                candidates[i]->d->touch();
+                last = candidates[i];
+                pthread_rwlock_unlock(&cacheLock);
+                return last;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&cacheLock);
+
+    // seen first, parse and compile it
+    unsigned int end = data.dataStartPtr;
+    data.dataStartPtr = start;
+    SchemaPtr_t schema(new Schema_t());
+    Schema_t &fresh = *schema.schema;
+
+    data >> count;
+    fresh.fields.resize(count);
+    for (uint32_t i = 0; i < count; ++i) data >> fresh.fields[i];
+    data >> count;
+    fresh.attributes.resize(count);
+    for (uint32_t i = 0; i < count; ++i)
+        data >> fresh.attributes[i].first >> fresh.attributes[i].second;
+    data.dataStartPtr = end;
+
+    fresh.d = new Schema_t::PrivateData_t(fresh.attributes);
+    fresh.d->bytes.assign(reinterpret_cast<const char *>(bytes), length);
+    fresh.d->convertEndian = data.convertEndian;
+
+    // perfect hash of names, equal names share a slot (the last wins)
+    size_t size = 1;
+    while (size < 2 * fresh.attributes.size()) size <<= 1;
+    for (bool built = fresh.attributes.empty(); !built; size <<= 1) {
+        for (uint32_t seed = 0; seed < PERFECT_HASH_SEEDS && !built; ++seed) {
+            fresh.slots.assign(size, 0);
+            fresh.seed = seed;
+            built = true;
+            for (uint32_t i = 0; i < fresh.attributes.size() && built; ++i) {
+                const std::string &name = fresh.attributes[i].first;
+                uint32_t &slot = fresh.slots[nameHash(name, seed) & (size - 1)];
+                // duplicate name keeps the first slot
+                if (!slot)
+                    slot = i + 1;
+                else if (fresh.attributes[slot - 1].first != name)
+                    built = false;
+            }
+        }
+    }
+
+    // other thread may have interned the same schema meanwhile, both
+    // are fine
+    pthread_rwlock_wrlock(&cacheLock);
+    if (cacheSize >= MAX_CACHED_SCHEMAS) evictLeastRecentlyUsed();
+    ++cacheEpoch;
+    fresh.d->lastUsed = cacheEpoch;
+    cache[hash].push_back(schema);
+    ++cacheSize;
+    pthread_rwlock_unlock(&cacheLock);
+    last = schema;
+    return schema;
+}//konec fce
+
+void Sphinx::SchemaCache_t::evictLeastRecentlyUsed()
+{
+    // runs only when a new schema comes to the full cache
+    Cache_t::iterator oldest = cache.end();
+    size_t oldestIndex = 0;
+    for (Cache_t::iterator i = cache.begin(); i != cache.end(); ++i) {
+        for (size_t j = 0; j < i->second.size(); ++j) {
+            if (oldest == cache.end()
+                || i->second[j]->d->lastUsed
+                   < oldest->second[oldestIndex]->d->lastUsed)
+            {
+                oldest = i;
+                oldestIndex = j;
+            }
+        }
+    }
+    if (oldest == cache.end()) return;
+
+    std::vector<SchemaPtr_t> &candidates = oldest->second;
+    candidates.erase(candidates.begin() + oldestIndex);
+    if (candidates.empty()) cache.erase(oldest);
+    --cacheSize;
+}//konec fce
+
+const Sphinx::DecodePlan_t &Sphinx::SchemaCache_t::getPlan(
+        const Schema_t &schema, bool use64bitId)
+{
+    return use64bitId ? schema.d->plan64 : schema.d->plan32;
+}//konec fce
+
+const Sphinx::DecodePlan_t &Sphinx::SchemaCache_t::getPlan(
+        const Schema_t &schema, bool use64bitId,
+        const std::vector<std::string> *projection,
+        std::auto_ptr<DecodePlan_t> &uncached)
+{
+    typedef Schema_t::PrivateData_t::Projected_t Projected_t;
+    Schema_t::PrivateData_t &d = *schema.d;
+    if (!projection || projection->empty())
+        return getPlan(schema, use64bitId);
+
+    // published plans first, without the mutex
+    size_t count = d.projectedCount;
+    __sync_synchronize();
+    for (size_t i = 0; i < count; ++i) {
+        const Projected_t &p = *d.projected[i];
+        if (p.use64bitId == use64bitId && p.projection == *projection)
+            return p.plan;
+    }
+
+    pthread_mutex_lock(&d.mutex);
+    for (size_t i = count; i < d.projectedCount; ++i) {
+        const Projected_t &p = *d.projected[i];
+        if (p.use64bitId == use64bitId && p.projection == *projection) {
+            pthread_mutex_unlock(&d.mutex);
+            return p.plan;
+        }
+    }
+    if (d.projectedCount < MAX_PROJECTED_PLANS) {
+        Projected_t *p = new Projected_t(schema.attributes, use64bitId,
+                                         *projection);
+        d.projected[d.projectedCount] = p;
+        // plan is complete before readers can see it
+        __sync_synchronize();
+        ++d.projectedCount;
+        pthread_mutex_unlock(&d.mutex);
+        return p->plan;
+    }
+    pthread_mutex_unlock(&d.mutex);
+
+    // too many projections of one schema, this one is not kept
+    uncached.reset(new DecodePlan_t(schema.attributes, use64bitId,
+                                    projection));
+    return *uncached;
+}//konec fce
+
+size_t Sphinx::SchemaCache_t::getSize()
+{
+    pthread_rwlock_rdlock(&cacheLock);
+    size_t size = cacheSize;
+    pthread_rwlock_unlock(&cacheLock);
+    return size;
+}//konec fce
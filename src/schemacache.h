@@ -0,0 +1,101 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Process-wide cache of response schemas
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file schemacache.h
+
+#ifndef __SCHEMACACHE_H__
+#define __SCHEMACACHE_H__
+
+#include <stddef.h>
+#include <memory>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/sphinxclientquery.h>
+
+namespace Sphinx
+{
+
+class DecodePlan_t;
+
+/** @brief Interns schemas of search responses
+ *
+ *  Schema bytes (field and attribute lists) are hashed and looked up,
+ *  only schema seen for the first time is parsed and compiled. Each
+ *  thread remembers the schema it got last and hits it without taking
+ *  any lock, other lookups share a read lock. The cache is bounded,
+ *  when full the least recently used schema is evicted; schemas still
+ *  referenced by responses live on.
+ */
+class SchemaCache_t
+{
+public:
+    /** @brief reads field and attribute lists at read position
+     *  @return interned schema
+     *  @throws MessageError_t when the lists exceed data
+     */
+    static SchemaPtr_t read(Query_t &data);
+
+    //! @brief decode plan of schema for given document id width
+    static const DecodePlan_t &getPlan(const Schema_t &schema,
+                                       bool use64bitId);
+
+    /** @brief decode plan of projected attributes of schema
+     *
+     *  Plan for a projection is compiled once and kept by the schema,
+     *  up to a few projections per schema.
+     *
+     *  @param projection names of attributes to decode (0 or empty for
+     *         all)
+     *  @param uncached gets the plan compiled for this call only when
+     *         the schema keeps too many projections already
+     */
+    static const DecodePlan_t &getPlan(
+            const Schema_t &schema, bool use64bitId,
+            const std::vector<std::string> *projection,
+            std::auto_ptr<DecodePlan_t> &uncached);
+
+    //! @brief count of schemas held by the cache
+    static size_t getSize();
+
+private:
+    /// drops the schema used least recently, cache is locked
+    static void evictLeastRecentlyUsed();
+};//class
+
+}//namespace
+
+#endif
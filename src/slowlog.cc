@@ -0,0 +1,186 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Sampled slow query log
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <sphinxclient/slowlog.h>
+#include <sphinxclient/error.h>
+#include "recordfile.h"
+
+#include <time.h>
+#include <pthread.h>
+
+namespace {
+
+const Sphinx::RecordFormat_t SLOWLOG_FORMAT = {
+    "SPHXSLOW", 1, "slow query log"
+};
+
+/// per-thread state of sampling generator (xorshift)
+__thread uint32_t sampleState = 0;
+
+uint32_t sampleRandom()
+{
+    if (!sampleState) {
+        sampleState = uint32_t(pthread_self()) ^ uint32_t(time(0)) ^ 0x9e3779b9;
+        if (!sampleState) sampleState = 1;
+    }
+    sampleState ^= sampleState << 13;
+    sampleState ^= sampleState >> 17;
+    sampleState ^= sampleState << 5;
+    return sampleState;
+}//konec fce
+
+}//namespace
+
+//------------------------------------------------------------------------------
+
+Sphinx::SlowQueryLogConfig_t::SlowQueryLogConfig_t(const std::string &path)
+    : path(path), thresholdMs(1000), sampleEvery(0),
+      maxFileSize(64 << 20), maxFiles(4), queueSize(1024)
+{}
+
+//------------------------------------------------------------------------------
+
+struct Sphinx::SlowQueryLog_t::PrivateData_t
+{
+    PrivateData_t(const SlowQueryLogConfig_t &config)
+        : config(config),
+          writer(SLOWLOG_FORMAT, config.path, config.maxFileSize,
+                 config.maxFiles, config.queueSize)
+    {}
+
+    SlowQueryLogConfig_t config;
+    RecordWriter_t writer;
+};
+
+Sphinx::SlowQueryLog_t::SlowQueryLog_t(const SlowQueryLogConfig_t &config)
+    : d(new PrivateData_t(config))
+{}//konstruktor
+
+Sphinx::SlowQueryLog_t::~SlowQueryLog_t()
+{
+    delete d;
+}//destruktor
+
+void Sphinx::SlowQueryLog_t::flush()
+{
+    d->writer.flush();
+}//konec fce
+
+uint64_t Sphinx::SlowQueryLog_t::getWritten() const
+{
+    return d->writer.getWritten();
+}//konec fce
+
+uint64_t Sphinx::SlowQueryLog_t::getDropped() const
+{
+    return d->writer.getDropped();
+}//konec fce
+
+uint32_t Sphinx::SlowQueryLog_t::select(uint32_t elapsed) const
+{
+    uint32_t flags = 0;
+    if (d->config.thresholdMs && elapsed >= d->config.thresholdMs * 1000)
+        flags |= SLOWLOG_SLOW;
+    if (d->config.sampleEvery && sampleRandom() % d->config.sampleEvery == 0)
+        flags |= SLOWLOG_SAMPLED;
+    return flags;
+}//konec fce
+
+void Sphinx::SlowQueryLog_t::submit(const SlowQueryRecord_t &record)
+{
+    Query_t data;
+    data.convertEndian = true;
+    data << record.timestamp << record.flags << record.elapsed
+         << record.endpoint
+         << record.stats.connectTime << record.stats.versionTime
+         << record.stats.requestTime << record.stats.headerTime
+         << record.stats.responseTime << record.stats.parseTime
+         << record.stats.bytesSent << record.stats.bytesReceived
+         << record.stats.syscalls << record.stats.connectRetries
+         << record.query << record.config
+         << uint32_t(record.requests.size());
+    for (size_t i = 0; i < record.requests.size(); ++i)
+        data << record.requests[i];
+
+    d->writer.submit(data);
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::SlowQueryLogReader_t::SlowQueryLogReader_t(const std::string &path)
+    : reader(new RecordReader_t(SLOWLOG_FORMAT, path))
+{}//konstruktor
+
+Sphinx::SlowQueryLogReader_t::~SlowQueryLogReader_t()
+{
+    delete reader;
+}//destruktor
+
+bool Sphinx::SlowQueryLogReader_t::next(SlowQueryRecord_t &record)
+{
+    Query_t data;
+    if (!reader->next(data)) return false;
+
+    uint32_t requestCount;
+    QueryStats_t &stats = record.stats;
+    if (!(readField(data, record.timestamp)
+          && readField(data, record.flags)
+          && readField(data, record.elapsed)
+          && readField(data, record.endpoint)
+          && readField(data, stats.connectTime)
+          && readField(data, stats.versionTime)
+          && readField(data, stats.requestTime)
+          && readField(data, stats.headerTime)
+          && readField(data, stats.responseTime)
+          && readField(data, stats.parseTime)
+          && readField(data, stats.bytesSent)
+          && readField(data, stats.bytesReceived)
+          && readField(data, stats.syscalls)
+          && readField(data, stats.connectRetries)
+          && readField(data, record.query)
+          && readField(data, record.config)
+          && readField(data, requestCount)))
+    {
+        return false;
+    }
+    if (requestCount > data.getLength()) return false;
+    record.requests.resize(requestCount);
+    for (uint32_t i = 0; i < requestCount; ++i)
+        if (!readField(data, record.requests[i])) return false;
+    return true;
+}//konec fce
@@ -41,6 +41,8 @@
 #include <sphinxclient/sphinxclientquery.h>
 #include <sphinxclient/error.h>
 #include <sphinxclient/globals.h>
+#include <sphinxclient/slowlog.h>
+#include <sphinxclient/capture.h>
 #include <filter.h>
 
 #include <sstream>
@@ -53,6 +55,7 @@
 #include <ctype.h>
 #include <netdb.h>
 #include <poll.h>
+#include <sys/time.h>
 
 #include <stdarg.h>
 
@@ -63,6 +66,9 @@
 
 #include "querymachine.h"
 #include "timer.h"
+#include "clientmetrics.h"
+#include "cowptr.h"
+#include "parallelparse.h"
 
 
 //------------------------------------------------------------------------------
@@ -76,7 +82,9 @@ void buildQueryVersion(const std::string &, const Sphinx::SearchConfig_t &,
                        Sphinx::Query_t &);
 
 void parseResponseVersion(Sphinx::Query_t &, Sphinx::SearchCommandVersion_t,
-                          Sphinx::Response_t &);
+                          Sphinx::Response_t &,
+                          const std::vector<std::string> *,
+                          Sphinx::RowSink_t *);
 
 void buildHeader(Sphinx::Command_t, unsigned short, int, Sphinx::Query_t &,
                  int queryCount=1);
@@ -208,79 +216,75 @@ const char *Sphinx::ConnectionConfig_t::getDomainSocketPath() const {
 
 //------------------------------------------------------------------------------
 
+struct Sphinx::SharedEnumFilter_t::PrivateData_t
+{
+    PrivateData_t() {}
+    PrivateData_t(const CowPtr_t<EnumFilterPayload_t> &payload)
+        : payload(payload)
+    {}
 
-namespace Sphinx {
-    struct SearchConfig_t::Dptr_t
-    {
-        void makeCopy(const Dptr_t &from)
-        {
-            msgOffset = from.msgOffset;
-            msgLimit = from.msgLimit;
-            matchMode = from.matchMode;
-            sortMode = from.sortMode;
-            rankingMode = from.rankingMode;
-            sortBy = from.sortBy;
-            groupBy = from.groupBy;
-            groupFunction = from.groupFunction;
-            maxMatches = from.maxMatches;
-            groupSort = from.groupSort;
-            commandVersion = from.commandVersion;
-            indexes = from.indexes;
-            searchCutOff = from.searchCutOff;
-            distRetryCount = from.distRetryCount;
-            distRetryDelay = from.distRetryDelay;
-            groupDistinctAttribute = from.groupDistinctAttribute;
-            anchorPoints = from.anchorPoints;
-            indexWeights = from.indexWeights;
-            maxQueryTime = from.maxQueryTime;
-            fieldWeights = from.fieldWeights;
-            queryComment = from.queryComment;
-            selectClause = from.selectClause;
-            attributeOverrides = from.attributeOverrides;
-            /* handle filters*/
-            for (std::vector<Filter_t *>::const_iterator i = from.filters.begin();
-                i != from.filters.end(); ++i)
-            {
-                filters.push_back((*i)->clone());
-            }
-            rankingExpr = from.rankingExpr;
-        }
+    CowPtr_t<EnumFilterPayload_t> payload;
+};
 
-        void clear() {
-            // handle filters
-            for (std::vector<Filter_t *>::const_iterator i = filters.begin();
-                i != filters.end(); i++)
-            {
-                delete *i;
-            }
-        }
+Sphinx::SharedEnumFilter_t::SharedEnumFilter_t(const Int64Array_t &values)
+    : d(new PrivateData_t)
+{
+    d->payload.detach().assign(values);
+}
 
-        Dptr_t(SearchCommandVersion_t cmdVer) :
-            msgOffset(0), msgLimit(20),
-            matchMode(SPH_MATCH_ALL), sortMode(SPH_SORT_RELEVANCE),
-            rankingMode(SPH_RANK_PROXIMITY_BM25),
-            sortBy(""), groupBy(""), groupFunction(SPH_GROUPBY_DAY), maxMatches(1000),
-            groupSort("@group desc"), commandVersion(cmdVer), indexes("*"),
-            searchCutOff(0), distRetryCount(0), distRetryDelay(0), maxQueryTime(0),
-            selectClause("*")
-        {}
+Sphinx::SharedEnumFilter_t::SharedEnumFilter_t(const IntArray_t &values)
+    : d(new PrivateData_t)
+{
+    d->payload.detach().assign(values);
+}
 
-        Dptr_t(const Dptr_t &from) {
-            makeCopy(from);
-        }
+Sphinx::SharedEnumFilter_t::SharedEnumFilter_t(
+        const Sphinx::SharedEnumFilter_t &from)
+    : d(new PrivateData_t(from.d->payload))
+{}
 
-        ~Dptr_t() {
-            clear();
-        }
+Sphinx::SharedEnumFilter_t &Sphinx::SharedEnumFilter_t::operator=(
+    const Sphinx::SharedEnumFilter_t &from)
+{
+    d->payload = from.d->payload;
+    return *this;
+}
 
-        Dptr_t &operator = (const Dptr_t &from) {
-            if (&from != this) {
-                clear();
-                makeCopy(from);
-            }
-            return *this;
-        }
+Sphinx::SharedEnumFilter_t::~SharedEnumFilter_t()
+{
+    delete d;
+}
+
+size_t Sphinx::SharedEnumFilter_t::size() const
+{
+    return d->payload->count;
+}
+
+Sphinx::Int64Array_t Sphinx::SharedEnumFilter_t::getValues() const
+{
+    return d->payload->getValues();
+}
 
+//------------------------------------------------------------------------------
+
+
+namespace Sphinx {
+    /* Config data are split into groups shared between copies of the
+     * config. Copying a config only bumps the reference counts, each
+     * group is detached (copied) when it is going to be modified.
+     */
+
+    /// scalar query parameters
+    struct SearchConfigScalars_t
+    {
+        SearchConfigScalars_t(SearchCommandVersion_t cmdVer = VER_COMMAND_SEARCH_2_0_5) :
+            msgOffset(0), msgLimit(20),
+            matchMode(SPH_MATCH_ALL), sortMode(SPH_SORT_RELEVANCE),
+            rankingMode(SPH_RANK_PROXIMITY_BM25),
+            groupFunction(SPH_GROUPBY_DAY), maxMatches(1000),
+            commandVersion(cmdVer),
+            searchCutOff(0), distRetryCount(0), distRetryDelay(0), maxQueryTime(0)
+        {}
 
         uint32_t msgOffset; //!< @brief specifies, how many matches to skip
         uint32_t msgLimit;  //!< @brief specifies, how many matches to fetch
@@ -293,49 +297,103 @@ namespace Sphinx {
         //         since version 113
         RankingMode_t rankingMode;
 
-        std::string sortBy;          //!< @brief which columns to sort the result by
-        std::string groupBy;        //!< @brief which columns to group the result by
         //! @brief group function - fetch the match with greatest relevance per
         //!        group
         GroupFunction_t groupFunction;
         int maxMatches;  //!< @brief maximum matches to search for
 
-        std::string groupSort; //!< $brief group-by sorting clause (to sort groups in result set with)
-        std::vector<Filter_t *> filters; //!< $brief array to hold attribute filter (range, enum)
-
         //! @brief Command version - allowed values are 0x101, 0x104, 0x107, 0x113, 0x116
         SearchCommandVersion_t commandVersion;
-        //! @brief Index file names to search in
-        std::string indexes;
 
         //----- od verze query 113 -----
         //! @brief stop searching after cutoff matches (default 0 - disabled)
         uint32_t searchCutOff;
         //! @brief distributed search retry count and delay
         uint32_t distRetryCount, distRetryDelay;
+        //! @brief max query duration, milliseconds (default is 0, do not limit)
+        uint32_t maxQueryTime;
+    };
+
+    /// string query parameters
+    struct SearchConfigExpressions_t
+    {
+        SearchConfigExpressions_t() :
+            sortBy(""), groupBy(""), groupSort("@group desc"), indexes("*"),
+            selectClause("*")
+        {}
+
+        std::string sortBy;          //!< @brief which columns to sort the result by
+        std::string groupBy;        //!< @brief which columns to group the result by
+        std::string groupSort; //!< $brief group-by sorting clause (to sort groups in result set with)
+        //! @brief Index file names to search in
+        std::string indexes;
         //! @brief count-distinct attribute (its name) for group-by query
         std::string groupDistinctAttribute;
+        //! @brief query comment
+        std::string queryComment;
+
+        //! @brief select columns to fetch in SQL-like select syntax. Available
+        //         aggregation functions are MIN, MAX, SUM, AVG. AS is required
+        std::string selectClause;
 
+        //! @brief Expression for match ranking. Used with SPH_RANK_EXPR only.
+        std::string rankingExpr;
+
+        //! @brief attributes to decode from matches, empty for all
+        std::vector<std::string> projection;
+    };
+
+    /// attribute filters, owns the filter objects
+    struct SearchConfigFilters_t
+    {
+        SearchConfigFilters_t() {}
+
+        SearchConfigFilters_t(const SearchConfigFilters_t &from) {
+            for (std::vector<Filter_t *>::const_iterator i = from.filters.begin();
+                i != from.filters.end(); ++i)
+            {
+                filters.push_back((*i)->clone());
+            }
+        }
+
+        ~SearchConfigFilters_t() {
+            for (std::vector<Filter_t *>::const_iterator i = filters.begin();
+                i != filters.end(); i++)
+            {
+                delete *i;
+            }
+        }
+
+        std::vector<Filter_t *> filters; //!< $brief array to hold attribute filter (range, enum)
+
+    private:
+        SearchConfigFilters_t &operator=(const SearchConfigFilters_t &);
+    };
+
+    /// weights and geo anchors
+    struct SearchConfigWeights_t
+    {
         //! @brief anchor points to do distance sorting
         std::vector<GeoAnchorPoint_t> anchorPoints;
 
         //! @brief per index weights (map of index name to index weight)
         std::map<std::string, uint32_t> indexWeights;
-        //! @brief max query duration, milliseconds (default is 0, do not limit)
-        uint32_t maxQueryTime;
         //! @brief per field weights (map of field name to field weight)
         std::map<std::string, uint32_t> fieldWeights;
-        //! @brief query comment
-        std::string queryComment;
+    };
 
-        //! @brief select columns to fetch in SQL-like select syntax. Available
-        //         aggregation functions are MIN, MAX, SUM, AVG. AS is required
-        std::string selectClause;
-        //! @brief attribute overrides - map attrName->(attrType, map docId->attrValue)
-        AttributeOverrides_t attributeOverrides;
+    struct SearchConfig_t::Dptr_t
+    {
+        Dptr_t(SearchCommandVersion_t cmdVer) :
+            scalars(SearchConfigScalars_t(cmdVer))
+        {}
 
-        //! @brief Expression for match ranking. Used with SPH_RANK_EXPR only.
-        std::string rankingExpr;
+        CowPtr_t<SearchConfigScalars_t> scalars;
+        CowPtr_t<SearchConfigExpressions_t> expressions;
+        CowPtr_t<SearchConfigFilters_t> filters;
+        CowPtr_t<SearchConfigWeights_t> weights;
+        //! @brief attribute overrides - map attrName->(attrType, map docId->attrValue)
+        CowPtr_t<AttributeOverrides_t> attributeOverrides;
     };
 }//namespace
 
@@ -355,8 +413,7 @@ Sphinx::SearchConfig_t &Sphinx::SearchConfig_t::operator= (
     const Sphinx::SearchConfig_t &from)
 {
     if (&from != this) {
-        delete dptr;
-        dptr = new Dptr_t(*(from.dptr));
+        *dptr = *(from.dptr);
     }
     return *this;
 }
@@ -370,29 +427,36 @@ Sphinx::SearchConfig_t::~SearchConfig_t() {
 void Sphinx::SearchConfig_t::addRangeFilter(const std::string &attrName,
         uint64_t minValue, uint64_t maxValue, bool excludeFlag)
 {
-    dptr->filters.push_back(new RangeFilter_t(attrName, minValue,
-                                          maxValue, excludeFlag));
+    dptr->filters.detach().filters.push_back(
+            new RangeFilter_t(attrName, minValue, maxValue, excludeFlag));
 }
 
 void Sphinx::SearchConfig_t::addEnumFilter(const std::string &attrName,
         const Int64Array_t &values, bool excludeFlag)
 {
-    dptr->filters.push_back(new EnumFilter_t(attrName, values,
-                                         excludeFlag));
+    dptr->filters.detach().filters.push_back(
+            new EnumFilter_t(attrName, values, excludeFlag));
 }
 
 void Sphinx::SearchConfig_t::addEnumFilter(const std::string &attrName,
         const IntArray_t &values, bool excludeFlag)
 {
-    dptr->filters.push_back(new EnumFilter_t(attrName, values,
-                                         excludeFlag));
+    dptr->filters.detach().filters.push_back(
+            new EnumFilter_t(attrName, values, excludeFlag));
+}
+
+void Sphinx::SearchConfig_t::addEnumFilter(const std::string &attrName,
+        const SharedEnumFilter_t &values, bool excludeFlag)
+{
+    dptr->filters.detach().filters.push_back(
+            new EnumFilter_t(attrName, values.d->payload, excludeFlag));
 }
 
 void Sphinx::SearchConfig_t::addFloatRangeFilter(const std::string &attrName,
         float minValue, float maxValue, bool excludeFlag)
 {
-    dptr->filters.push_back(new FloatRangeFilter_t(attrName, minValue,
-                                                   maxValue, excludeFlag));
+    dptr->filters.detach().filters.push_back(
+            new FloatRangeFilter_t(attrName, minValue, maxValue, excludeFlag));
 }
 
 void Sphinx::SearchConfig_t::addAttributeOverride(
@@ -400,7 +464,8 @@ void Sphinx::SearchConfig_t::addAttributeOverride(
                                  AttributeType_t attrType,
                                  const std::map<uint64_t, Value_t> &values)
 {
-    dptr->attributeOverrides[attrName] = std::make_pair(attrType, values);
+    dptr->attributeOverrides.detach()[attrName]
+        = std::make_pair(attrType, values);
 }//konec fce
 
 void Sphinx::SearchConfig_t::addAttributeOverride(
@@ -410,7 +475,7 @@ void Sphinx::SearchConfig_t::addAttributeOverride(
 {
     // get or insert attribute entry
     std::pair<AttributeType_t, std::map<uint64_t, Value_t> >
-        &override = dptr->attributeOverrides[attrName];
+        &override = dptr->attributeOverrides.detach()[attrName];
 
     // update the entry
     override.first = attrType;
@@ -422,12 +487,9 @@ void Sphinx::SearchConfig_t::addAttributeOverride(
 bool Sphinx::SearchConfig_t::getFilter(int index, std::string &attrname,
         bool &exclude, float &minValue, float &maxValue) const
 {
-    // check index limits
-    if (index < 0 || (unsigned)index >= dptr->filters.size())
-        throw ClientUsageError_t("Filter index out of range.");
-
-    // check filter type
-    FloatRangeFilter_t *flt = dynamic_cast<FloatRangeFilter_t*>(dptr->filters[index]);
+    // check type and index limits
+    const FloatRangeFilter_t *flt
+        = dynamic_cast<const FloatRangeFilter_t*>(getFilter(index));
     if (!flt)
         return false;
 
@@ -442,12 +504,9 @@ bool Sphinx::SearchConfig_t::getFilter(int index, std::string &attrname,
 bool Sphinx::SearchConfig_t::getFilter(int index, std::string &attrname,
         bool &exclude, uint64_t &minValue, uint64_t &maxValue) const
 {
-    // check index limits
-    if (index < 0 || (unsigned)index >= dptr->filters.size())
-        throw ClientUsageError_t("Filter index out of range.");
-
-    // check filter type
-    RangeFilter_t *flt = dynamic_cast<RangeFilter_t*>(dptr->filters[index]);
+    // check type and index limits
+    const RangeFilter_t *flt
+        = dynamic_cast<const RangeFilter_t*>(getFilter(index));
     if (!flt)
         return false;
 
@@ -462,206 +521,235 @@ bool Sphinx::SearchConfig_t::getFilter(int index, std::string &attrname,
 bool Sphinx::SearchConfig_t::getFilter(int index, std::string &attrname,
         bool &exclude, Int64Array_t &values) const
 {
-    // check index limits
-    if (index < 0 || (unsigned)index >= dptr->filters.size())
-        throw ClientUsageError_t("Filter index out of range.");
-
-    // check filter type
-    EnumFilter_t *flt = dynamic_cast<EnumFilter_t*>(dptr->filters[index]);
+    // check type and index limits
+    const EnumFilter_t *flt
+        = dynamic_cast<const EnumFilter_t*>(getFilter(index));
     if (!flt)
         return false;
 
     // fetch data
     attrname = flt->attrName;
     exclude = flt->excludeFlag;
-    values = flt->values;
+    values = flt->getValues();
     return true;
 }
 
 
+void Sphinx::SearchConfig_t::normalizeFilters() {
+    Sphinx::normalizeFilters(dptr->filters.detach().filters);
+}
+
 unsigned Sphinx::SearchConfig_t::getFilterCount() const {
-    return dptr->filters.size();
+    return dptr->filters->filters.size();
 }
 
 const Sphinx::Filter_t *Sphinx::SearchConfig_t::getFilter(int index) const {
+    const std::vector<Filter_t *> &filters = dptr->filters->filters;
+
     // check index limits
-    if (index < 0 || (unsigned)index >= dptr->filters.size())
+    if (index < 0 || (unsigned)index >= filters.size())
         throw ClientUsageError_t("Filter index out of range.");
 
-    return dptr->filters[index];
+    return filters[index];
 }
 
 Sphinx::SearchCommandVersion_t Sphinx::SearchConfig_t::getCommandVersion() const {
-    return dptr->commandVersion;
+    return dptr->scalars->commandVersion;
 }
 
 void Sphinx::SearchConfig_t::setPaging(uint32_t msgOffset, uint32_t msgLimit) {
-    dptr->msgLimit = msgLimit;
-    dptr->msgOffset = msgOffset;
+    SearchConfigScalars_t &scalars = dptr->scalars.detach();
+    scalars.msgLimit = msgLimit;
+    scalars.msgOffset = msgOffset;
 }
 
 void Sphinx::SearchConfig_t::setMatchMode(MatchMode_t matchMode) {
-    dptr->matchMode = matchMode;
+    dptr->scalars.detach().matchMode = matchMode;
 }
 
 void Sphinx::SearchConfig_t::setSorting(
         SortMode_t sortMode, const std::string &sortBy) {
-    dptr->sortMode = sortMode;
-    dptr->sortBy = sortBy;
+    dptr->scalars.detach().sortMode = sortMode;
+    dptr->expressions.detach().sortBy = sortBy;
 }
 
 void Sphinx::SearchConfig_t::setRanking(
         RankingMode_t rankingMode, const std::string &rankExpr) {
-    dptr->rankingMode = rankingMode;
-    dptr->rankingExpr = rankExpr;
+    dptr->scalars.detach().rankingMode = rankingMode;
+    dptr->expressions.detach().rankingExpr = rankExpr;
 }
 
 void Sphinx::SearchConfig_t::setGrouping(
         GroupFunction_t groupFunction,
         const std::string &groupBy,
         const std::string &groupSort) {
-    dptr->groupFunction = groupFunction;
-    dptr->groupBy = groupBy;
-    dptr->groupSort = groupSort;
+    dptr->scalars.detach().groupFunction = groupFunction;
+    SearchConfigExpressions_t &expressions = dptr->expressions.detach();
+    expressions.groupBy = groupBy;
+    expressions.groupSort = groupSort;
 }
 
 void Sphinx::SearchConfig_t::setGroupDistinctAttribute(
         const std::string &attributeName) {
-    dptr->groupDistinctAttribute = attributeName;
+    dptr->expressions.detach().groupDistinctAttribute = attributeName;
 }
 
 void Sphinx::SearchConfig_t::setMaxMatches(int maxMatches) {
-    dptr->maxMatches = maxMatches;
+    dptr->scalars.detach().maxMatches = maxMatches;
 }
 
 void Sphinx::SearchConfig_t::setMaxQueryTime(uint32_t maxQueryTime) {
-    dptr->maxQueryTime = maxQueryTime;
+    dptr->scalars.detach().maxQueryTime = maxQueryTime;
 }
 
 void Sphinx::SearchConfig_t::setSearchedIndexes(const std::string &indexNames) {
-    dptr->indexes = indexNames;
+    dptr->expressions.detach().indexes = indexNames;
 }
 
 void Sphinx::SearchConfig_t::setIndexWeight(
         const std::string &indexName, uint32_t weight) {
-    dptr->indexWeights[indexName] = weight;
+    dptr->weights.detach().indexWeights[indexName] = weight;
 }
 
 void Sphinx::SearchConfig_t::setFieldWeight(
         const std::string &fieldName, uint32_t weight) {
-    dptr->fieldWeights[fieldName] = weight;
+    dptr->weights.detach().fieldWeights[fieldName] = weight;
 }
 
 void Sphinx::SearchConfig_t::setSearchCutoff(uint32_t searchCutOff) {
-    dptr->searchCutOff = searchCutOff;
+    dptr->scalars.detach().searchCutOff = searchCutOff;
 }
 
 void Sphinx::SearchConfig_t::setRetries(
         uint32_t distRetryCount, uint32_t distRetryDelay) {
-    dptr->distRetryCount = distRetryCount;
-    dptr->distRetryDelay = distRetryDelay;
+    SearchConfigScalars_t &scalars = dptr->scalars.detach();
+    scalars.distRetryCount = distRetryCount;
+    scalars.distRetryDelay = distRetryDelay;
 }
 
 void Sphinx::SearchConfig_t::setGeoAnchorPoints(
         const std::vector<GeoAnchorPoint_t> &anchorPoints) {
-    dptr->anchorPoints = anchorPoints;
+    dptr->weights.detach().anchorPoints = anchorPoints;
 }
 
 void Sphinx::SearchConfig_t::setQueryComment(const std::string &queryComment) {
-    dptr->queryComment = queryComment;
+    dptr->expressions.detach().queryComment = queryComment;
 }
 
 void Sphinx::SearchConfig_t::setSelectClause(const std::string &selectClause) {
-    dptr->selectClause = selectClause;
+    dptr->expressions.detach().selectClause = selectClause;
 }
 
 
 uint32_t Sphinx::SearchConfig_t::getPagingOffset() const {
-    return dptr->msgOffset;
+    return dptr->scalars->msgOffset;
 }
 
 uint32_t Sphinx::SearchConfig_t::getPagingLimit() const {
-    return dptr->msgLimit;
+    return dptr->scalars->msgLimit;
 }
 
 Sphinx::MatchMode_t Sphinx::SearchConfig_t::getMatchMode() const {
-    return dptr->matchMode;
+    return dptr->scalars->matchMode;
 }
 
 Sphinx::SortMode_t Sphinx::SearchConfig_t::getSortingMode() const {
-    return dptr->sortMode;
+    return dptr->scalars->sortMode;
 }
 
 const std::string &Sphinx::SearchConfig_t::getSortingExpr() const {
-    return dptr->sortBy;
+    return dptr->expressions->sortBy;
 }
 
 Sphinx::RankingMode_t Sphinx::SearchConfig_t::getRankingMode() const {
-    return dptr->rankingMode;
+    return dptr->scalars->rankingMode;
 }
 
 const std::string &Sphinx::SearchConfig_t::getRankingExpr() const {
-    return dptr->rankingExpr;
+    return dptr->expressions->rankingExpr;
 }
 
 Sphinx::GroupFunction_t Sphinx::SearchConfig_t::getGroupingFunction() const {
-    return dptr->groupFunction;
+    return dptr->scalars->groupFunction;
 }
 const std::string &Sphinx::SearchConfig_t::getGroupByExpr() const {
-    return dptr->groupBy;
+    return dptr->expressions->groupBy;
 }
 const std::string &Sphinx::SearchConfig_t::getGroupSortExpr() const {
-    return dptr->groupSort;
+    return dptr->expressions->groupSort;
 }
 const std::string &Sphinx::SearchConfig_t::getGroupDistinctAttribute() const {
-    return dptr->groupDistinctAttribute;
+    return dptr->expressions->groupDistinctAttribute;
 }
 
 int Sphinx::SearchConfig_t::getMaxMatches() const {
-    return dptr->maxMatches;
+    return dptr->scalars->maxMatches;
 }
 uint32_t Sphinx::SearchConfig_t::getMaxQueryTime() const {
-    return dptr->maxQueryTime;
+    return dptr->scalars->maxQueryTime;
 }
 
 const std::string &Sphinx::SearchConfig_t::getSearchedIndexes() const {
-    return dptr->indexes;
+    return dptr->expressions->indexes;
 }
 const std::map<std::string, uint32_t> &
 Sphinx::SearchConfig_t::getIndexWeights() const {
-    return dptr->indexWeights;
+    return dptr->weights->indexWeights;
 }
 const std::map<std::string, uint32_t> &
 Sphinx::SearchConfig_t::getFieldWeights() const {
-    return dptr->fieldWeights;
+    return dptr->weights->fieldWeights;
 }
 
 uint32_t Sphinx::SearchConfig_t::getSearchCutoff() const {
-    return dptr->searchCutOff;
+    return dptr->scalars->searchCutOff;
 }
 uint32_t Sphinx::SearchConfig_t::getDistRetryCount() const {
-    return dptr->distRetryCount;
+    return dptr->scalars->distRetryCount;
 }
 uint32_t Sphinx::SearchConfig_t::getDistRetryDelay() const {
-    return dptr->distRetryDelay;
+    return dptr->scalars->distRetryDelay;
 }
 
 const std::vector<Sphinx::GeoAnchorPoint_t> &
 Sphinx::SearchConfig_t::getGeoAnchorPoints() const {
-    return dptr->anchorPoints;
+    return dptr->weights->anchorPoints;
 }
 
 const std::string &Sphinx::SearchConfig_t::getQueryComment() const {
-    return dptr->queryComment;
+    return dptr->expressions->queryComment;
 }
 
 const std::string &Sphinx::SearchConfig_t::getSelectClause() const {
-    return dptr->selectClause;
+    return dptr->expressions->selectClause;
+}
+
+void Sphinx::SearchConfig_t::setProjection(
+        const std::vector<std::string> &attributes, bool narrowSelect)
+{
+    SearchConfigExpressions_t &expressions = dptr->expressions.detach();
+    expressions.projection = attributes;
+    if (!narrowSelect || attributes.empty()
+        || expressions.selectClause != "*")
+    {
+        return;
+    }
+
+    std::string selectClause;
+    for (size_t i = 0; i < attributes.size(); ++i) {
+        if (i) selectClause += ", ";
+        selectClause += attributes[i];
+    }
+    expressions.selectClause = selectClause;
+}
+
+const std::vector<std::string> &Sphinx::SearchConfig_t::getProjection() const {
+    return dptr->expressions->projection;
 }
 
 const Sphinx::SearchConfig_t::AttributeOverrides_t &
 Sphinx::SearchConfig_t::getAttributeOverrides() const {
-    return dptr->attributeOverrides;
+    return *dptr->attributeOverrides;
 }
 
 
@@ -690,21 +778,64 @@ struct SocketCloser_t
 
 //------------------------------------------------------------------------------
 
+Sphinx::QueryStats_t::QueryStats_t()
+    : connectTime(0), versionTime(0), requestTime(0), headerTime(0),
+      responseTime(0), parseTime(0), bytesSent(0), bytesReceived(0),
+      syscalls(0), connectRetries(0)
+{}
+
+Sphinx::Response_t::Response_t()
+    : entriesGot(0), entriesFound(0), timeConsumed(0), use64bitId(0),
+      commandVersion(VER_COMMAND_SEARCH_0_9_9), useArena(false)
+{}
+
 void Sphinx::Response_t::clear()
 {
+    // values may live in the arena, destroy them first
     entry.clear();
+    arena.clear();
     word.clear();
     field.clear();
     attribute.clear();
+    SchemaPtr_t().swap(schema);
     entriesGot = 0;
     entriesFound = 0;
     timeConsumed = 0;
 }//konec fce
 
+void Sphinx::Response_t::swap(Response_t &other)
+{
+    arena.swap(other.arena);
+    field.swap(other.field);
+    attribute.swap(other.attribute);
+    schema.swap(other.schema);
+    entry.swap(other.entry);
+    word.swap(other.word);
+    std::swap(entriesGot, other.entriesGot);
+    std::swap(entriesFound, other.entriesFound);
+    std::swap(timeConsumed, other.timeConsumed);
+    std::swap(use64bitId, other.use64bitId);
+    std::swap(commandVersion, other.commandVersion);
+    std::swap(useArena, other.useArena);
+    std::swap(stats, other.stats);
+}//konec fce
+
 //------------------------------------------------------------------------------
 
+/** @brief metrics label of searchd endpoint
+ */
+static std::string endpointName(const Sphinx::ConnectionConfig_t &settings)
+{
+    if (settings.isDomainSocketUsed()) return "unix://" + settings.getHost();
+    std::ostringstream name;
+    name << settings.getHost() << ":" << settings.getPort();
+    return name.str();
+}//konec fce
+
 Sphinx::Client_t::Client_t(const ConnectionConfig_t &settings)
-    : connection(settings)
+    : connection(settings),
+      metricsEndpoint(Metrics::registerEndpoint(endpointName(settings))),
+      observer(0), slowLog(0), capture(0), parseThreads(1)
 {}//konstruktor
 
 //-------------------------------------------------------------------------
@@ -719,6 +850,7 @@ void Sphinx::MultiQuery_t::initQuery(SearchCommandVersion_t cv)
     queryCount = 0;
     commandVersion = cv;
     queries.clear();
+    projections.clear();
 }//konec fce
 
 
@@ -736,6 +868,7 @@ void Sphinx::MultiQuery_t::addQuery(const std::string& query,
     // append to multiquery
     queries.convertEndian = true;
     buildQueryVersion(query, queryAttr, queries);
+    projections.push_back(queryAttr.getProjection());
 }//konec fce
 
 int Sphinx::MultiQuery_t::getQueryCount() const { return queryCount; }
@@ -744,6 +877,11 @@ const Sphinx::Query_t &Sphinx::MultiQuery_t::getQueries() const {
     return queries;
 }
 
+const std::vector<std::string> &
+Sphinx::MultiQuery_t::getProjection(int i) const {
+    return projections[i];
+}
+
 Sphinx::SearchCommandVersion_t Sphinx::MultiQuery_t::getCommandVersion() const {
     return commandVersion;
 }//konec fce
@@ -751,9 +889,19 @@ Sphinx::SearchCommandVersion_t Sphinx::MultiQuery_t::getCommandVersion() const {
 //-------------------------------------------------------------------------
 
 Sphinx::MultiQueryOpt_t::MultiQueryOpt_t(SearchCommandVersion_t cv)
-    : commandVersion(cv)
+    : commandVersion(cv), connectionBudget(0)
 {}//konec fce
 
+void Sphinx::MultiQueryOpt_t::setConnectionBudget(size_t budget)
+{
+    connectionBudget = budget;
+}//konec fce
+
+size_t Sphinx::MultiQueryOpt_t::getConnectionBudget() const
+{
+    return connectionBudget;
+}//konec fce
+
 void Sphinx::MultiQueryOpt_t::initQuery(SearchCommandVersion_t cv)
 {
     commandVersion = cv;
@@ -870,8 +1018,9 @@ void Sphinx::MultiQueryOpt_t::optimise() {
     //printf("optimisation enabled\n");
 
     //printf("going to sort sorted queries ...\n");
-    // sort queries by hash
-    std::sort(sortedQueries.begin(), sortedQueries.end(), QuerySorter_t());
+    // sort queries by hash, queries with equal hash keep their order
+    std::stable_sort(sortedQueries.begin(), sortedQueries.end(),
+                     QuerySorter_t());
     //printf("sorting done.\n");
 
     // build response index and groupQueries
@@ -897,6 +1046,134 @@ void Sphinx::MultiQueryOpt_t::optimise() {
     }
     // sort by first indexes
     std::sort(responseIndex.begin(), responseIndex.end());
+
+    if (connectionBudget) planGroups();
+}
+
+namespace {
+
+typedef std::vector<const Sphinx::SourceQuery_t *> PlanQueries_t;
+
+/** @brief part of multiquery planned to one connection
+ */
+struct PlanUnit_t {
+    PlanUnit_t() : cost(0), splittable(true) {}
+
+    /// recompute cost, matching stage is paid once per hash
+    void updateCost() {
+        cost = 0;
+        for (PlanQueries_t::const_iterator i = queries.begin();
+             i != queries.end(); ++i)
+        {
+            if (i == queries.begin() || (*i)->getHash() != (*(i-1))->getHash())
+                cost += (*i)->getMatchCost();
+            cost += (*i)->getSortCost();
+        }
+    }
+
+    PlanQueries_t queries;
+    unsigned long cost;
+    /// false when splitting was tried and didn't pay
+    bool splittable;
+};
+
+struct PlanUnitCostGreater_t {
+    bool operator()(const PlanUnit_t &lhs, const PlanUnit_t &rhs) const {
+        return lhs.cost > rhs.cost;
+    }
+};
+
+}//namespace
+
+void Sphinx::MultiQueryOpt_t::planGroups()
+{
+    size_t budget = connectionBudget;
+    if (budget > MAX_PARALLEL_CONNECTIONS) budget = MAX_PARALLEL_CONNECTIONS;
+
+    // one unit per query group
+    std::vector<PlanUnit_t> units(groupQueries.size());
+    for (size_t i = 0; i < groupQueries.size(); ++i) {
+        PlanQueries_t::const_iterator begin
+            = sortedQueries.begin() + groupQueries[i];
+        units[i].queries.assign(begin, begin + getQueryCountAtGroup(i));
+        units[i].updateCost();
+    }
+
+    // split the most expensive unit while there are idle connections
+    while (units.size() < budget) {
+        size_t worst = units.size();
+        for (size_t i = 0; i < units.size(); ++i) {
+            if (units[i].splittable && units[i].queries.size() > 1
+                && (worst == units.size() || units[i].cost > units[worst].cost))
+                worst = i;
+        }
+        if (worst == units.size()) break;
+
+        // split by half of sorting cost, both parts must be non-empty
+        PlanQueries_t &queries = units[worst].queries;
+        unsigned long total = 0, prefix = 0;
+        for (size_t i = 0; i < queries.size(); ++i)
+            total += queries[i]->getSortCost();
+        size_t half = 1;
+        for (prefix = queries[0]->getSortCost();
+             half < queries.size() - 1 && 2 * prefix < total; ++half)
+            prefix += queries[half]->getSortCost();
+
+        PlanUnit_t first, second;
+        first.queries.assign(queries.begin(), queries.begin() + half);
+        second.queries.assign(queries.begin() + half, queries.end());
+        first.updateCost();
+        second.updateCost();
+
+        // splitting duplicates matching stage, keep the unit whole when
+        // it doesn't pay and try the others
+        if (std::max(first.cost, second.cost) >= units[worst].cost) {
+            units[worst].splittable = false;
+            continue;
+        }
+
+        units[worst] = first;
+        units.push_back(second);
+    }
+
+    // merge units into connections, the longest processing time first
+    std::vector<PlanUnit_t> connections;
+    if (units.size() > budget) {
+        std::stable_sort(units.begin(), units.end(), PlanUnitCostGreater_t());
+        connections.resize(budget);
+        for (std::vector<PlanUnit_t>::const_iterator i = units.begin();
+             i != units.end(); ++i)
+        {
+            size_t lightest = 0;
+            for (size_t j = 1; j < connections.size(); ++j) {
+                if (connections[j].cost < connections[lightest].cost)
+                    lightest = j;
+            }
+            connections[lightest].queries.insert(
+                connections[lightest].queries.end(),
+                i->queries.begin(), i->queries.end());
+            connections[lightest].cost += i->cost;
+        }
+    } else {
+        connections.swap(units);
+    }
+
+    // rebuild sorted queries, groups and response index
+    sortedQueries.clear();
+    groupQueries.clear();
+    responseIndex.clear();
+    for (std::vector<PlanUnit_t>::const_iterator i = connections.begin();
+         i != connections.end(); ++i)
+    {
+        groupQueries.push_back(sortedQueries.size());
+        for (PlanQueries_t::const_iterator j = i->queries.begin();
+             j != i->queries.end(); ++j)
+        {
+            responseIndex.push_back(std::pair<int,int>(sortedQueries.size(),
+                                                       (*j)->getInputSeqNo()));
+            sortedQueries.push_back(*j);
+        }
+    }
 }
 
 int Sphinx::MultiQueryOpt_t::getQueryCount() const
@@ -913,7 +1190,7 @@ Sphinx::SearchCommandVersion_t Sphinx::MultiQueryOpt_t::getCommandVersion() cons
 Sphinx::SourceQuery_t::SourceQuery_t(const std::string &query,
                              const SearchConfig_t &attr,
                              int seqNo)
-    : inputSeqNo(seqNo)
+    : inputSeqNo(seqNo), projection(attr.getProjection())
 {
     // serialize query and store
     serializedQuery.convertEndian = true;
@@ -925,10 +1202,18 @@ Sphinx::SourceQuery_t::SourceQuery_t(const std::string &query,
       << attr.getSelectClause() << "\t"
       << attr.getMatchMode() << "\t";
     // add filters to hash
+    size_t filterValues = 0;
     for (unsigned i = 0; i < attr.getFilterCount(); ++i) {
         o << *attr.getFilter(i) << "\t";
+        filterValues += attr.getFilter(i)->getValueCount();
     }
     hash = o.str();
+
+    // estimate cost, matching stage is shared by queries with same hash
+    // (fixed cost of one pass thru the index plus filter tests), sorting
+    // stage grows with count of kept matches
+    matchCost = 1000 + query.size() + 4 * filterValues;
+    sortCost = attr.getMaxMatches() > 0 ? attr.getMaxMatches() : 1;
 }
 
 
@@ -939,163 +1224,501 @@ Sphinx::SourceQuery_t::SourceQuery_t(const std::string &query,
 
 //-------------------------------------------------------------------------
 
+/** @brief short description of search configuration for slow query log
+ */
+static std::string summarizeConfig(const Sphinx::SearchConfig_t &attrs)
+{
+    std::ostringstream summary;
+    summary << "indexes=" << attrs.getSearchedIndexes()
+            << " mode=" << attrs.getMatchMode()
+            << " ranking=" << attrs.getRankingMode()
+            << " sort=" << attrs.getSortingMode();
+    if (!attrs.getSortingExpr().empty())
+        summary << ":" << attrs.getSortingExpr();
+    if (!attrs.getGroupByExpr().empty())
+        summary << " group=" << attrs.getGroupingFunction() << ":"
+                << attrs.getGroupByExpr();
+    summary << " offset=" << attrs.getPagingOffset()
+            << " limit=" << attrs.getPagingLimit()
+            << " maxMatches=" << attrs.getMaxMatches()
+            << " filters=" << attrs.getFilterCount()
+            << " cutoff=" << attrs.getSearchCutoff()
+            << " maxQueryTime=" << attrs.getMaxQueryTime();
+    return summary.str();
+}//konec fce
+
+/** @brief stats of the response that finished last
+ */
+static const Sphinx::QueryStats_t &slowestStats(
+        const std::vector<Sphinx::Response_t> &response)
+{
+    size_t slowest = 0;
+    for (size_t i = 1; i < response.size(); i++)
+        if (response[i].stats.responseTime
+            > response[slowest].stats.responseTime)
+        {
+            slowest = i;
+        }
+    return response[slowest].stats;
+}//konec fce
+
 void Sphinx::Client_t::query(const std::string& query,
                              const SearchConfig_t &attrs,
                              Response_t &response)
 {
-    Query_t data, request;
-    data.convertEndian = true;
-    request.convertEndian = true;
+    search(query, attrs, response, 0);
+}//konec fce
+
+namespace {
+
+/// binding of document id alone, rows are the ids themselves
+class DocumentIdBinding_t : public Sphinx::RowBindingBase_t
+{
+public:
+    DocumentIdBinding_t()
+    {
+        documentId.type = Sphinx::BOUND_UINT64;
+        documentId.store = storeId;
+    }
 
-    //-------------------build query---------------
-    buildQueryVersion(query, attrs, data);
-    buildHeader(SEARCHD_COMMAND_SEARCH, attrs.getCommandVersion(),
-            data.getLength(), request);
-    request << data;
+private:
+    static void storeId(void *row, const void *, const void *value)
+    {
+        *static_cast<uint64_t *>(row) = *static_cast<const uint64_t *>(value);
+    }
+};//class
+
+/// rows of DocumentIdBinding_t decoded into id array
+class DocumentIdSink_t : public Sphinx::RowSink_t
+{
+public:
+    DocumentIdSink_t(const DocumentIdBinding_t &binding,
+                     std::vector<uint64_t> &ids)
+        : Sphinx::RowSink_t(binding), ids(ids)
+    {}
 
-    // initialize query polling machine
-    Sphinx::QueryMachine_t queryMachine(connection);
+    virtual void *resize(size_t count)
+    {
+        ids.resize(count);
+        return count ? &ids[0] : 0;
+    }
 
-    // put query into query machine
-    queryMachine.addQuery(request);
+    virtual size_t getStride() const { return sizeof(uint64_t); }
 
-    // launch query machine
-    queryMachine.launch();
+private:
+    std::vector<uint64_t> &ids;
+};//class
 
-    Query_t responseData = queryMachine.getResponse(0);
+}//namespace
 
-    //--------- parse response -------------------
-    parseResponseVersion(responseData, attrs.getCommandVersion(), response);
+void Sphinx::Client_t::query(const std::string& query,
+                             const SearchConfig_t &attrs,
+                             DocumentIdSet_t &ids,
+                             Response_t &response)
+{
+    // decoded over the memory of the previous ids
+    std::vector<uint64_t> decoded;
+    ids.adopt(decoded);
+    DocumentIdBinding_t binding;
+    DocumentIdSink_t sink(binding, decoded);
+    search(query, attrs, response, &sink);
+    ids.adopt(decoded);
 }//konec fce
 
-void Sphinx::Client_t::query(const MultiQueryOpt_t &mq,
-                             std::vector<Response_t> &response)
+void Sphinx::Client_t::search(const std::string& query,
+                              const SearchConfig_t &attrs,
+                              Response_t &response, RowSink_t *rows)
 {
-    SearchCommandVersion_t cmdVer = mq.getCommandVersion();
+    CallMetrics_t metrics(METRICS_SEARCH, metricsEndpoint);
+    try {
+        Query_t data, request;
+        data.convertEndian = true;
+        request.convertEndian = true;
 
-    // test, if multiquery initialized, get the query
-    size_t groupCount = mq.getGroupQueryCount();
-    if (!groupCount) 
-        throw ClientUsageError_t("multiQuery not initialised or zero length.");
+        //-------------------build query---------------
+        buildQueryVersion(query, attrs, data);
+        CapturedCall_t captured;
+        if (capture) captured.addRequest(data);
+        buildHeader(SEARCHD_COMMAND_SEARCH, attrs.getCommandVersion(),
+                data.getLength(), request);
+        request << data;
 
-    // initialize query polling machine
-    Sphinx::QueryMachine_t queryMachine(connection);
+        // initialize query polling machine
+        Sphinx::QueryMachine_t queryMachine(connection, observer);
 
-    // put queries into query machine
-    for (size_t i=0; i<groupCount; i++) {
-        Sphinx::Query_t groupQuery = mq.getGroupQuery(i);
-        size_t queryCount = mq.getQueryCountAtGroup(i);
+        // put query into query machine
+        queryMachine.addQuery(request);
 
-        if (!groupQuery.getLength() || !queryCount) {
-            throw ClientUsageError_t("multiQuery not initialised "
-                                      " or zero length.");
+        // launch query machine
+        queryMachine.launch();
+        metrics.addResponseSize(queryMachine.getStats(0).bytesReceived);
+
+        Query_t responseData = queryMachine.getResponse(0);
+
+        //--------- parse response -------------------
+        parseResponseStats(responseData, attrs.getCommandVersion(), response,
+                           queryMachine.getStats(0), &attrs.getProjection(),
+                           rows);
+        if (slowLog) {
+            uint32_t elapsed = metrics.getElapsed();
+            uint32_t flags = slowLog->select(elapsed);
+            if (flags) {
+                std::vector<const Query_t *> requests(
+                        1, &queryMachine.getQuery(0));
+                logSlowQuery(flags, elapsed, response.stats, query,
+                             summarizeConfig(attrs), requests);
+            }
         }
+        if (capture) {
+            captureCall(captured, SEARCHD_COMMAND_SEARCH,
+                        attrs.getCommandVersion(), metrics.getElapsed());
+        }
+    } catch (...) {
+        metrics.failed();
+        throw;
+    }
+}//konec fce
 
-        Query_t request;
-        request.convertEndian = true;
-        // create request header
-        buildHeader(SEARCHD_COMMAND_SEARCH, cmdVer,
-                    groupQuery.getLength(),
-                    request, queryCount);
-            
-        // add body to request
-        request << groupQuery;
+namespace {
 
-        //printf("launching group query, %lu subqueries\n", queryCount);
-        queryMachine.addQuery(request);
+/** @brief resizes responses keeping the memory they hold, responses are
+ *         moved by swap when the vector grows
+ */
+void resizeResponses(std::vector<Sphinx::Response_t> &response, size_t count)
+{
+    if (count > response.capacity() && !response.empty()) {
+        std::vector<Sphinx::Response_t> grown;
+        grown.reserve(count);
+        grown.resize(response.size());
+        for (size_t i = 0; i < response.size(); i++)
+            grown[i].swap(response[i]);
+        response.swap(grown);
     }
-    // launch query machine
-    queryMachine.launch();
-
-    // prepare response vector
-    response.clear();
-    response.resize(mq.getQueryCount());
+    response.resize(count);
+}//konec fce
 
-    // parse responses
-    std::string lastQueryWarning;
+/** @brief Parses group responses of optimised multiquery as they arrive
+ *
+ *  Group parsed while other groups are in flight has its receive
+ *  buffer released at once. Group that fails to parse (searchd warning
+ *  or error) is left for serial parsing after the machine finishes.
+ */
+class GroupParser_t : public Sphinx::QueryCompletion_t
+{
+public:
+    /** @param queryCounts number of queries in each group
+     *  @param targets output response of each query in group order
+     *  @param projections attributes to decode of each query in group
+     *         order
+     */
+    GroupParser_t(Sphinx::SearchCommandVersion_t cmdVer,
+                  Sphinx::QueryMachine_t &queryMachine,
+                  const std::vector<size_t> &queryCounts,
+                  const std::vector<Sphinx::Response_t *> &targets,
+                  const std::vector<const std::vector<std::string> *>
+                      &projections,
+                  size_t parseThreads)
+        : cmdVer(cmdVer), queryMachine(queryMachine),
+          queryCounts(queryCounts), targets(targets),
+          projections(projections),
+          parseThreads(parseThreads), firstSeqNo(queryCounts.size(), 0),
+          done(queryCounts.size(), false)
+    {
+        for (size_t i = 1; i < firstSeqNo.size(); i++)
+            firstSeqNo[i] = firstSeqNo[i - 1] + queryCounts[i - 1];
+    }
 
-    // step thru group responses
-    size_t seqNo = 0;
-    for (size_t i=0; i<groupCount; i++)
+    virtual void completed(size_t i)
     {
-        Query_t &data = queryMachine.getResponse(i);
-        size_t queryCount = mq.getQueryCountAtGroup(i);
-        // step thru queries within one response
-        for (size_t j = 0; j < queryCount; j++) {
-            Response_t resp;
-            try {
-                parseResponseVersion(data, cmdVer, resp);
-            } catch (const Warning_t &wt) {
-                std::ostringstream msg;
-                msg << "Query " << (i+1) << "," << (j+1) << ": " << wt.what();
-                lastQueryWarning = msg.str();
-            }
-            // place response into output
-            /*printf("%lu. response, getResponseIndex = %lu\n",
-                    seqNo, mq.getResponseIndex(seqNo));
-            */
-            response[mq.getResponseIndex(seqNo)] = resp;
-            seqNo++;
+        Sphinx::Query_t &data = queryMachine.getResponse(i);
+        unsigned int start = data.dataStartPtr;
+        try {
+            size_t queryCount = queryCounts[i];
+            Sphinx::ResponseParser_t parser(data, queryCount, cmdVer,
+                                            queryMachine.getStats(i),
+                                            parseThreads,
+                                            &targets[firstSeqNo[i]],
+                                            &projections[firstSeqNo[i]]);
+            for (size_t j = 0; j < queryCount; j++) parser.next();
+        } catch (...) {
+            data.dataStartPtr = start;
+            return;
         }
-        if (!lastQueryWarning.empty())
-            throw Warning_t(lastQueryWarning);
+        queryMachine.releaseResponse(i);
+        done[i] = true;
     }
-} 
 
-void Sphinx::Client_t::query(const MultiQuery_t &query,
-                                  std::vector<Response_t> &response)
+    /// whether group was parsed while in flight
+    bool isDone(size_t i) const { return done[i]; }
+
+    /// sequence number of the first query of group
+    size_t getFirstSeqNo(size_t i) const { return firstSeqNo[i]; }
+
+private:
+    Sphinx::SearchCommandVersion_t cmdVer;
+    Sphinx::QueryMachine_t &queryMachine;
+    const std::vector<size_t> &queryCounts;
+    const std::vector<Sphinx::Response_t *> &targets;
+    const std::vector<const std::vector<std::string> *> &projections;
+    size_t parseThreads;
+    std::vector<size_t> firstSeqNo;
+    std::vector<bool> done;
+};
+
+}//namespace
+
+void Sphinx::Client_t::query(const MultiQueryOpt_t &mq,
+                             std::vector<Response_t> &response)
 {
-    // test, if multiquery initialized, get the query
-    const Query_t &queries = query.getQueries();
-    int queryCount = query.getQueryCount();
-    int queriesLength = queries.getLength();
-    SearchCommandVersion_t cmdVer = query.getCommandVersion();
+    CallMetrics_t metrics(METRICS_SEARCH, metricsEndpoint);
+    try {
+        SearchCommandVersion_t cmdVer = mq.getCommandVersion();
+
+        // test, if multiquery initialized, get the query
+        size_t groupCount = mq.getGroupQueryCount();
+        if (!groupCount) 
+            throw ClientUsageError_t("multiQuery not initialised or zero length.");
+
+        // initialize query polling machine
+        Sphinx::QueryMachine_t queryMachine(connection, observer);
+
+        // put queries into query machine
+        CapturedCall_t captured;
+        for (size_t i=0; i<groupCount; i++) {
+            Sphinx::Query_t groupQuery = mq.getGroupQuery(i);
+            size_t queryCount = mq.getQueryCountAtGroup(i);
+
+            if (!groupQuery.getLength() || !queryCount) {
+                throw ClientUsageError_t("multiQuery not initialised "
+                                          " or zero length.");
+            }
 
-    if(!queryCount || !queriesLength)
-        throw ClientUsageError_t("multiQuery not initialised or zero length.");
+            Query_t request;
+            request.convertEndian = true;
+            // create request header
+            buildHeader(SEARCHD_COMMAND_SEARCH, cmdVer,
+                        groupQuery.getLength(),
+                        request, queryCount);
 
-    // prepare whole command and response buffer
-    Query_t data, request;
-    data.convertEndian = true;
-    request.convertEndian = true;
+            // add body to request
+            request << groupQuery;
+            if (capture) captured.addRequest(groupQuery, queryCount);
 
-    buildHeader(SEARCHD_COMMAND_SEARCH, cmdVer, queries.getLength(),
-                request, queryCount);
-    request << queries;
+            //printf("launching group query, %lu subqueries\n", queryCount);
+            queryMachine.addQuery(request);
+        }
+        // launch query machine, groups are parsed as they arrive straight
+        // into responses of the previous call
+        resizeResponses(response, mq.getQueryCount());
+        std::vector<Response_t *> targets(response.size());
+        std::vector<const std::vector<std::string> *> projections(
+                response.size());
+        for (size_t k = 0; k < targets.size(); k++) {
+            targets[k] = &response[mq.getResponseIndex(k)];
+            projections[k] = &mq.sortedQueries[k]->getProjection();
+        }
+        std::vector<size_t> queryCounts(groupCount);
+        for (size_t i=0; i<groupCount; i++)
+            queryCounts[i] = mq.getQueryCountAtGroup(i);
+        GroupParser_t groupParser(cmdVer, queryMachine, queryCounts, targets,
+                                  projections, parseThreads);
+        queryMachine.launch(&groupParser);
+        for (size_t i=0; i<groupCount; i++)
+            metrics.addResponseSize(queryMachine.getStats(i).bytesReceived);
+
+        // parse responses
+        std::string lastQueryWarning;
+
+        // step thru group responses, parse those left by group parser
+        for (size_t i=0; i<groupCount; i++)
+        {
+            if (groupParser.isDone(i)) continue;
+
+            Query_t &data = queryMachine.getResponse(i);
+            size_t queryCount = mq.getQueryCountAtGroup(i);
+            size_t seqNo = groupParser.getFirstSeqNo(i);
+            ResponseParser_t parser(data, queryCount, cmdVer,
+                                    queryMachine.getStats(i), parseThreads,
+                                    &targets[seqNo], &projections[seqNo]);
+            // step thru queries within one response
+            for (size_t j = 0; j < queryCount; j++) {
+                // parse straight into its place in output
+                /*printf("%lu. response, getResponseIndex = %lu\n",
+                        seqNo, mq.getResponseIndex(seqNo));
+                */
+                try {
+                    parser.next();
+                } catch (const Warning_t &wt) {
+                    std::ostringstream msg;
+                    msg << "Query " << (i+1) << "," << (j+1) << ": " << wt.what();
+                    lastQueryWarning = msg.str();
+                }
+                seqNo++;
+            }
+            if (!lastQueryWarning.empty()) {
+                // later groups are not returned
+                for (size_t k = groupParser.getFirstSeqNo(i) + queryCount;
+                     k < targets.size(); k++)
+                {
+                    targets[k]->clear();
+                }
+                throw Warning_t(lastQueryWarning);
+            }
+        }
+        if (slowLog) {
+            uint32_t elapsed = metrics.getElapsed();
+            uint32_t flags = slowLog->select(elapsed);
+            if (flags) {
+                std::vector<const Query_t *> requests;
+                for (size_t i=0; i<groupCount; i++)
+                    requests.push_back(&queryMachine.getQuery(i));
+                std::ostringstream config;
+                config << "multiquery " << mq.getQueryCount() << " queries, "
+                       << groupCount << " groups";
+                logSlowQuery(flags, elapsed, slowestStats(response), "",
+                             config.str(), requests);
+            }
+        }
+        if (capture) {
+            captureCall(captured, SEARCHD_COMMAND_SEARCH, cmdVer,
+                        metrics.getElapsed());
+        }
+    } catch (...) {
+        metrics.failed();
+        throw;
+    }
+} 
 
-    // initialize query polling machine
-    Sphinx::QueryMachine_t queryMachine(connection);
+void Sphinx::Client_t::query(const MultiQuery_t &query,
+                                  std::vector<Response_t> &response)
+{
+    CallMetrics_t metrics(METRICS_SEARCH, metricsEndpoint);
+    try {
+        // test, if multiquery initialized, get the query
+        const Query_t &queries = query.getQueries();
+        int queryCount = query.getQueryCount();
+        int queriesLength = queries.getLength();
+        SearchCommandVersion_t cmdVer = query.getCommandVersion();
+
+        if(!queryCount || !queriesLength)
+            throw ClientUsageError_t("multiQuery not initialised or zero length.");
+
+        // prepare whole command and response buffer
+        Query_t data, request;
+        data.convertEndian = true;
+        request.convertEndian = true;
 
-    // put query into query machine
-    queryMachine.addQuery(request);
+        buildHeader(SEARCHD_COMMAND_SEARCH, cmdVer, queries.getLength(),
+                    request, queryCount);
+        request << queries;
+        CapturedCall_t captured;
+        if (capture) captured.addRequest(queries, queryCount);
 
-    // launch query machine
-    queryMachine.launch();
+        // initialize query polling machine
+        Sphinx::QueryMachine_t queryMachine(connection, observer);
 
-    // get response data from machine
-    data = queryMachine.getResponse(0);
+        // put query into query machine
+        queryMachine.addQuery(request);
 
-    //parse responses and return
-    std::string lastQueryWarning;
+        // launch query machine
+        queryMachine.launch();
+        metrics.addResponseSize(queryMachine.getStats(0).bytesReceived);
+
+        // get response data from machine
+        data = queryMachine.getResponse(0);
+
+        //parse responses and return
+        std::string lastQueryWarning;
+
+        // parse straight into responses of the previous call, failed
+        // response and those after it are not kept
+        resizeResponses(response, queryCount);
+        std::vector<const std::vector<std::string> *> projections(queryCount);
+        for (int i = 0; i < queryCount; i++)
+            projections[i] = &query.getProjection(i);
+        std::vector<Response_t *> targets(queryCount);
+        for (int i = 0; i < queryCount; i++) targets[i] = &response[i];
+        ResponseParser_t parser(data, queryCount, cmdVer,
+                                queryMachine.getStats(0), parseThreads,
+                                &targets[0], &projections[0]);
+        for(int i=0 ; i<queryCount ; i++) {
+            try {
+                parser.next();
+            } catch (const Warning_t &wt) {
+                std::ostringstream msg;
+                msg << "Query " << (i+1) << ": " << wt.what();
+                lastQueryWarning = msg.str();
+            } catch (...) {
+                response.resize(i);
+                throw;
+            }//try
+        }//for
 
-    for(int i=0 ; i<queryCount ; i++) {
-        Response_t resp;
+        if (!lastQueryWarning.empty())
+            throw Warning_t(lastQueryWarning);
+        if (slowLog) {
+            uint32_t elapsed = metrics.getElapsed();
+            uint32_t flags = slowLog->select(elapsed);
+            if (flags) {
+                std::vector<const Query_t *> requests(
+                        1, &queryMachine.getQuery(0));
+                std::ostringstream config;
+                config << "multiquery " << queryCount << " queries";
+                logSlowQuery(flags, elapsed, response.back().stats, "",
+                             config.str(), requests);
+            }
+        }
+        if (capture) {
+            captureCall(captured, SEARCHD_COMMAND_SEARCH, cmdVer,
+                        metrics.getElapsed());
+        }
+    } catch (...) {
+        metrics.failed();
+        throw;
+    }
+}//konec fce
 
-        try {
-            parseResponseVersion(data, cmdVer, resp);
-        } catch (const Warning_t &wt) {
-            std::ostringstream msg;
-            msg << "Query " << (i+1) << ": " << wt.what();
-            lastQueryWarning = msg.str();
-        }//try
-
-        response.push_back(resp);
-    }//for
 
-    if (!lastQueryWarning.empty())
-        throw Warning_t(lastQueryWarning);
+void Sphinx::Client_t::logSlowQuery(uint32_t flags, uint32_t elapsed,
+                                    const QueryStats_t &stats,
+                                    const std::string &query,
+                                    const std::string &config,
+                                    const std::vector<const Query_t *> &requests)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+
+    SlowQueryRecord_t record;
+    record.timestamp = uint64_t(now.tv_sec) * 1000000 + now.tv_usec;
+    record.flags = flags;
+    record.elapsed = elapsed;
+    record.endpoint = endpointName(connection);
+    record.stats = stats;
+    record.query = query;
+    record.config = config;
+    for (size_t i = 0; i < requests.size(); i++) {
+        const Query_t &request = *requests[i];
+        record.requests.push_back(std::string(
+                reinterpret_cast<const char *>(request.data
+                                               + request.dataStartPtr),
+                request.getLength()));
+    }
+    slowLog->submit(record);
 }//konec fce
 
+void Sphinx::Client_t::captureCall(CapturedCall_t &call,
+                                   unsigned short command,
+                                   unsigned short version, uint32_t elapsed)
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+
+    call.timestamp = uint64_t(now.tv_sec) * 1000000 + now.tv_usec - elapsed;
+    call.elapsed = elapsed;
+    call.command = command;
+    call.version = version;
+    capture->submit(call);
+}//konec fce
 
 //-----------------------------------------------------------------------------
 
@@ -1163,36 +1786,49 @@ void Sphinx::AttributeUpdates_t::setCommandVersion(UpdateCommandVersion_t v)
 void Sphinx::Client_t::updateAttributes(const std::string &index,
                                         const AttributeUpdates_t &at)
 {
-    Query_t data, request;
-    uint32_t updatedCount;
-
-    // build request
-    data.convertEndian = request.convertEndian = true;
-    buildUpdateRequest_v0_9_8(data, index, at);
-
-    // prepend header
-    buildHeader(SEARCHD_COMMAND_UPDATE, at.commandVersion, data.getLength(),
-                request);
-    request << data;
-
-    // initialize query polling machine
-    Sphinx::QueryMachine_t queryMachine(connection);
+    CallMetrics_t metrics(METRICS_UPDATE, metricsEndpoint);
+    try {
+        Query_t data, request;
+        uint32_t updatedCount;
+
+        // build request
+        data.convertEndian = request.convertEndian = true;
+        buildUpdateRequest_v0_9_8(data, index, at);
+        CapturedCall_t captured;
+        if (capture) captured.addRequest(data);
+
+        // prepend header
+        buildHeader(SEARCHD_COMMAND_UPDATE, at.commandVersion, data.getLength(),
+                    request);
+        request << data;
+
+        // initialize query polling machine
+        Sphinx::QueryMachine_t queryMachine(connection, observer);
+
+        // put query into query machine
+        queryMachine.addQuery(request);
 
-    // put query into query machine
-    queryMachine.addQuery(request);
+        // launch query machine
+        queryMachine.launch();
+        metrics.addResponseSize(queryMachine.getStats(0).bytesReceived);
 
-    // launch query machine
-    queryMachine.launch();
+        // get response data from machine
+        data = queryMachine.getResponse(0);
 
-    // get response data from machine
-    data = queryMachine.getResponse(0);
+        //parse response
+        parseUpdateResponse_v0_9_8(data, updatedCount);
 
-    //parse response
-    parseUpdateResponse_v0_9_8(data, updatedCount);
-    
-    if(updatedCount != at.values.size())
-        throw ClientUsageError_t("Some documents weren't updated "
-                                 "- probably invalid id");
+        if(updatedCount != at.values.size())
+            throw ClientUsageError_t("Some documents weren't updated "
+                                     "- probably invalid id");
+        if (capture) {
+            captureCall(captured, SEARCHD_COMMAND_UPDATE, at.commandVersion,
+                        metrics.getElapsed());
+        }
+    } catch (...) {
+        metrics.failed();
+        throw;
+    }
 }//konec fce
 
 //-----------------------------------------------------------------------------
@@ -1202,34 +1838,47 @@ std::vector<Sphinx::KeywordResult_t> Sphinx::Client_t::getKeywords(
     const std::string &query,
     bool getWordStatistics)
 {
-    Query_t data, request;
-    std::vector<KeywordResult_t> result;
-
-    // build request
-    data.convertEndian = request.convertEndian = true;
-    buildKeywordsRequest_v0_9_8(data, index, query, getWordStatistics);
-
-    // prepend header
-    buildHeader(SEARCHD_COMMAND_KEYWORDS, VER_COMMAND_KEYWORDS_0_9_8,
-                data.getLength(), request);
-    request << data;
-
-    // initialize query polling machine
-    Sphinx::QueryMachine_t queryMachine(connection);
+    CallMetrics_t metrics(METRICS_KEYWORDS, metricsEndpoint);
+    try {
+        Query_t data, request;
+        std::vector<KeywordResult_t> result;
+
+        // build request
+        data.convertEndian = request.convertEndian = true;
+        buildKeywordsRequest_v0_9_8(data, index, query, getWordStatistics);
+        CapturedCall_t captured;
+        if (capture) captured.addRequest(data);
+
+        // prepend header
+        buildHeader(SEARCHD_COMMAND_KEYWORDS, VER_COMMAND_KEYWORDS_0_9_8,
+                    data.getLength(), request);
+        request << data;
+
+        // initialize query polling machine
+        Sphinx::QueryMachine_t queryMachine(connection, observer);
+
+        // put query into query machine
+        queryMachine.addQuery(request);
 
-    // put query into query machine
-    queryMachine.addQuery(request);
+        // launch query machine
+        queryMachine.launch();
+        metrics.addResponseSize(queryMachine.getStats(0).bytesReceived);
 
-    // launch query machine
-    queryMachine.launch();
+        // get response data from machine
+        data = queryMachine.getResponse(0);
 
-    // get response data from machine
-    data = queryMachine.getResponse(0);
+        //parse response
+        parseKeywordsResponse_v0_9_8(data, result, getWordStatistics);
+        if (capture) {
+            captureCall(captured, SEARCHD_COMMAND_KEYWORDS,
+                        VER_COMMAND_KEYWORDS_0_9_8, metrics.getElapsed());
+        }
 
-    //parse response
-    parseKeywordsResponse_v0_9_8(data, result, getWordStatistics);
-    
-    return result;
+        return result;
+    } catch (...) {
+        metrics.failed();
+        throw;
+    }
 }//konec fce
 
 //-----------------------------------------------------------------------------
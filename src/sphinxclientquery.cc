@@ -38,6 +38,10 @@
 
 #include <sphinxclient/sphinxclientquery.h>
 #include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/error.h>
+#include "bulkdecode.h"
+
+#include <limits.h>
 
 #include <sstream>
 #include <netdb.h>
@@ -74,6 +78,18 @@ Query_t::Query_t(unsigned int size)
     dataStartPtr = dataEndPtr = 0;
     error= false;
     convertEndian = false;
+    ownsData = true;
+}//konstruktor
+
+Query_t::Query_t(const Query_t &source, unsigned int start, unsigned int end)
+{
+    data = source.data;
+    dataSize = source.dataSize;
+    dataStartPtr = start;
+    dataEndPtr = end;
+    error = false;
+    convertEndian = source.convertEndian;
+    ownsData = false;
 }//konstruktor
 
 Query_t::Query_t(const Query_t &source)
@@ -84,6 +100,7 @@ Query_t::Query_t(const Query_t &source)
     dataEndPtr = source.dataEndPtr;
     error = source.error;
     convertEndian = source.convertEndian;
+    ownsData = true;
     data = new unsigned char[source.dataSize];
     //printf("%p copy const from %p, created data: %p ...\n", this, &source,data);
     //printf("data cpy %p->%p ... \n", source.data, data);
@@ -94,7 +111,8 @@ Query_t &Query_t::operator= (const Query_t &val)
 {
 
     if (&val != this) {
-        delete [] data;
+        if (ownsData) delete [] data;
+        ownsData = true;
 
         dataSize = val.dataSize;
         dataEndPtr = val.dataEndPtr;
@@ -110,7 +128,7 @@ Query_t &Query_t::operator= (const Query_t &val)
 Query_t::~Query_t()
 {
     //printf("%p destructor\n", this);
-    delete [] data;
+    if (ownsData) delete [] data;
 }//konstruktor
 
 void Query_t::doubleSizeBuffer()
@@ -119,7 +137,8 @@ void Query_t::doubleSizeBuffer()
 
     bkup = new unsigned char[dataSize];
     memcpy(bkup, data, dataEndPtr);
-    delete [] data;
+    if (ownsData) delete [] data;
+    ownsData = true;
 
     dataSize *= 2;
     data = new unsigned char[dataSize];
@@ -127,6 +146,65 @@ void Query_t::doubleSizeBuffer()
     delete [] bkup;
 }//konec fce
 
+void Query_t::reserve(unsigned int length)
+{
+    // buffer keeps one byte spare, as the << operators do
+    if (length >= UINT_MAX - dataEndPtr)
+        throw ClientUsageError_t("Query exceeds maximal buffer size.");
+    unsigned int needed = dataEndPtr + length;
+    unsigned int newSize = dataSize ? dataSize : 1;
+    while (needed >= newSize) {
+        if (newSize > UINT_MAX / 2) {
+            newSize = needed + 1;
+            break;
+        }
+        newSize *= 2;
+    }
+    if (newSize == dataSize) return;
+
+    unsigned char *newData = new unsigned char[newSize];
+    memcpy(newData, data, dataEndPtr);
+    if (ownsData) delete [] data;
+    ownsData = true;
+
+    data = newData;
+    dataSize = newSize;
+}//konec fce
+
+Query_t &Query_t::append(const void *buffer, unsigned int length)
+{
+    reserve(length);
+    memcpy(data + dataEndPtr, buffer, length);
+    dataEndPtr += length;
+    return *this;
+}//konec fce
+
+Query_t &Query_t::appendArray(const uint32_t *values, unsigned int count)
+{
+    if (count > UINT_MAX / sizeof(uint32_t))
+        throw ClientUsageError_t("Query exceeds maximal buffer size.");
+    reserve(count * sizeof(uint32_t));
+    if (convertEndian)
+        encodeNetwork32(data + dataEndPtr, values, count);
+    else
+        memcpy(data + dataEndPtr, values, count * sizeof(uint32_t));
+    dataEndPtr += count * sizeof(uint32_t);
+    return *this;
+}//konec fce
+
+Query_t &Query_t::appendArray(const uint64_t *values, unsigned int count)
+{
+    if (count > UINT_MAX / sizeof(uint64_t))
+        throw ClientUsageError_t("Query exceeds maximal buffer size.");
+    reserve(count * sizeof(uint64_t));
+    if (convertEndian)
+        encodeNetwork64(data + dataEndPtr, values, count);
+    else
+        memcpy(data + dataEndPtr, values, count * sizeof(uint64_t));
+    dataEndPtr += count * sizeof(uint64_t);
+    return *this;
+}//konec fce
+
 void Query_t::clear()
 {
     dataEndPtr = 0;
@@ -212,12 +290,7 @@ Query_t &Query_t::operator << (const std::string &val)
 
 Query_t &Query_t::operator << (const Query_t &val)
 {
-    while ((dataEndPtr+val.getLength()) >= dataSize)
-        doubleSizeBuffer();
-
-    memcpy(data+dataEndPtr, val.data+val.dataStartPtr, val.getLength());
-    dataEndPtr += val.getLength();
-    return *this;
+    return append(val.data+val.dataStartPtr, val.getLength());
 }//konec fce
 
 Query_t &Query_t::operator >> (uint32_t &val)
@@ -258,6 +331,32 @@ Query_t &Query_t::operator >> (uint64_t &val)
     return *this;
 }//konec fce
 
+Query_t &Query_t::read(uint32_t *values, unsigned int count)
+{
+    error = (dataEndPtr - dataStartPtr) / sizeof(uint32_t) < count;
+    if (error) return *this;
+
+    if (convertEndian)
+        decodeNetwork32(values, data + dataStartPtr, count);
+    else
+        memcpy(values, data + dataStartPtr, count * sizeof(uint32_t));
+    dataStartPtr += count * sizeof(uint32_t);
+    return *this;
+}//konec fce
+
+Query_t &Query_t::read(uint64_t *values, unsigned int count)
+{
+    error = (dataEndPtr - dataStartPtr) / sizeof(uint64_t) < count;
+    if (error) return *this;
+
+    if (convertEndian)
+        decodeNetwork64(values, data + dataStartPtr, count);
+    else
+        memcpy(values, data + dataStartPtr, count * sizeof(uint64_t));
+    dataStartPtr += count * sizeof(uint64_t);
+    return *this;
+}//konec fce
+
 Query_t &Query_t::operator >> (float &val)
 {
     error=false;
@@ -309,12 +408,8 @@ Query_t &Query_t::operator >> (std::string &val)
 
     if ((dataEndPtr-dataStartPtr) >= len)
     {
-        std::stringstream sstr;
-
-        for (unsigned int i=0;i<len;i++)
-            sstr << data[dataStartPtr++];
-
-        val = sstr.str();
+        val.assign(reinterpret_cast<const char *>(data + dataStartPtr), len);
+        dataStartPtr += len;
     }//if
     else
         error=true;
@@ -38,6 +38,10 @@
 
 
 #include <sphinxclient/value.h>
+#include <sphinxclient/arena.h>
+
+#include <new>
+#include <string.h>
 
 
 namespace Sphinx {
@@ -59,12 +63,15 @@ class ValueBase_t
 protected:
     ValueType_t type;
 
-    ValueBase_t(ValueType_t t) : type(t) {}
-    ValueBase_t(const ValueBase_t &v) : type(v.type) {}
+    ValueBase_t(ValueType_t t) : type(t), inArena(false) {}
+    ValueBase_t(const ValueBase_t &v) : type(v.type), inArena(false) {}
 
 public:
     virtual ~ValueBase_t() {}
 
+    /// value memory is owned by an arena (destroy, but don't delete)
+    bool inArena;
+
     inline ValueType_t getType() { return type; }
 
     virtual operator uint32_t () const {
@@ -87,6 +94,17 @@ public:
         throw ValueTypeError_t(std::string("Value is of type ")
                 + valueTypeString[type] + " but requested is string.");
     }
+
+    /// contiguous uint32_t values, 0 when not an uint32_t array
+    virtual const uint32_t *getUInt32Array(size_t &count) const {
+        count = 0;
+        return 0;
+    }
+    /// contiguous uint64_t values, 0 when not an uint64_t array
+    virtual const uint64_t *getUInt64Array(size_t &count) const {
+        count = 0;
+        return 0;
+    }
 };//class
 
 
@@ -129,8 +147,89 @@ public:
         : ValueBase_t(VALUETYPE_VECTOR), value(v) {}
     ValueVector_t(const ValueVector_t &val)
         : ValueBase_t(val), value(val.value) {}
+    //! @brief takes over content of v, v is left empty
+    ValueVector_t(std::vector<Value_t> *v)
+        : ValueBase_t(VALUETYPE_VECTOR) { value.swap(*v); }
 
     virtual operator const std::vector<Value_t>& () const { return value; }
+
+    //! @brief deep copy on the heap
+    virtual ValueVector_t *copy() const { return new ValueVector_t(*this); }
+};//class
+
+/// array of matching type, 0 otherwise
+inline const uint32_t *typedArray(const uint32_t *v, const uint32_t *)
+{ return v; }
+inline const uint32_t *typedArray(const uint64_t *, const uint32_t *)
+{ return 0; }
+inline const uint64_t *typedArray(const uint64_t *v, const uint64_t *)
+{ return v; }
+inline const uint64_t *typedArray(const uint32_t *, const uint64_t *)
+{ return 0; }
+
+/** @brief Vector of integers kept in one array
+ *
+ *  The std::vector<Value_t> view is built on the heap on first access
+ *  and published by compare-and-swap, so const values can be read from
+ *  several threads (the thread losing the race frees its view).
+ */
+template <class T>
+class ValueArray_t : public ValueVector_t
+{
+protected:
+    T *values;
+    size_t count;
+    /// values array is on the heap (not in arena)
+    bool heap;
+    /// view of values, 0 until accessed
+    mutable std::vector<Value_t> *volatile view;
+
+public:
+    ValueArray_t(const T *v, size_t n, Arena_t *arena)
+        : values(0), count(n), heap(!arena), view(0)
+    {
+        if (!count) return;
+        values = arena ? static_cast<T *>(arena->alloc(count * sizeof(T)))
+                       : new T[count];
+        memcpy(values, v, count * sizeof(T));
+    }
+    virtual ~ValueArray_t() {
+        delete view;
+        if (heap) delete [] values;
+    }
+
+    virtual operator const std::vector<Value_t>& () const {
+        std::vector<Value_t> *built = view;
+        if (built) return *built;
+
+        std::vector<Value_t> *fresh = new std::vector<Value_t>(count);
+        for (size_t i = 0; i < count; ++i) {
+            Value_t item(values[i]);
+            (*fresh)[i].swap(item);
+        }
+        built = __sync_val_compare_and_swap(
+                &view, static_cast<std::vector<Value_t> *>(0), fresh);
+        if (built) {
+            delete fresh;
+            return *built;
+        }
+        return *fresh;
+    }
+
+    virtual ValueVector_t *copy() const {
+        return new ValueArray_t<T>(values, count, 0);
+    }
+
+    virtual const uint32_t *getUInt32Array(size_t &n) const {
+        const uint32_t *result = typedArray(values, (const uint32_t *)0);
+        n = result ? count : 0;
+        return result;
+    }
+    virtual const uint64_t *getUInt64Array(size_t &n) const {
+        const uint64_t *result = typedArray(values, (const uint64_t *)0);
+        n = result ? count : 0;
+        return result;
+    }
 };//class
 
 class ValueUInt64_t : public ValueBase_t
@@ -161,6 +260,31 @@ public:
     virtual operator const std::string & () const { return value; }
 };//class
 
+/** @brief creates value in arena, or on the heap when arena is 0
+ */
+template <class Type_t, class Arg_t>
+static Type_t *newValue(Arena_t *arena, Arg_t arg)
+{
+    if (!arena) return new Type_t(arg);
+
+    Type_t *result = new (arena->alloc(sizeof(Type_t))) Type_t(arg);
+    result->inArena = true;
+    return result;
+}
+
+/** @brief creates array value in arena, or on the heap when arena is 0
+ */
+template <class T>
+static ValueBase_t *newArray(const T *values, size_t count, Arena_t *arena)
+{
+    if (!arena) return new ValueArray_t<T>(values, count, 0);
+
+    ValueArray_t<T> *result = new (arena->alloc(sizeof(ValueArray_t<T>)))
+        ValueArray_t<T>(values, count, arena);
+    result->inArena = true;
+    return result;
+}
+
 }//namespace
 
 //----------------------------------------------------------------------
@@ -176,6 +300,21 @@ Value_t::Value_t(const std::vector<Value_t> &v)
 Value_t::Value_t(uint64_t v) : value(new ValueUInt64_t(v)) {}
 Value_t::Value_t(const std::string &v) : value(new ValueString_t(v)) {}
 
+Value_t::Value_t(uint32_t v, Arena_t *arena)
+    : value(newValue<ValueUInt32_t>(arena, v)) {}
+Value_t::Value_t(float v, Arena_t *arena)
+    : value(newValue<ValueFloat_t>(arena, v)) {}
+Value_t::Value_t(uint64_t v, Arena_t *arena)
+    : value(newValue<ValueUInt64_t>(arena, v)) {}
+Value_t::Value_t(const std::string &v, Arena_t *arena)
+    : value(newValue<ValueString_t, const std::string &>(arena, v)) {}
+Value_t::Value_t(std::vector<Value_t> &v, Arena_t *arena)
+    : value(newValue<ValueVector_t>(arena, &v)) {}
+Value_t::Value_t(const uint32_t *values, size_t count, Arena_t *arena)
+    : value(newArray(values, count, arena)) {}
+Value_t::Value_t(const uint64_t *values, size_t count, Arena_t *arena)
+    : value(newArray(values, count, arena)) {}
+
 void Value_t::makeCopy(const Value_t &v)
 {
     if (v.value) {
@@ -187,7 +326,7 @@ void Value_t::makeCopy(const Value_t &v)
                 value = new ValueFloat_t(*(ValueFloat_t*)v.value);
                 break;
             case VALUETYPE_VECTOR:
-                value = new ValueVector_t(*(ValueVector_t*)v.value);
+                value = ((ValueVector_t*)v.value)->copy();
                 break;
             case VALUETYPE_UINT64:
                 value = new ValueUInt64_t(*(ValueUInt64_t*)v.value);
@@ -203,7 +342,10 @@ void Value_t::makeCopy(const Value_t &v)
 
 void Value_t::clear()
 {
-    delete value;
+    if (value && value->inArena)
+        value->~ValueBase_t();
+    else
+        delete value;
     value = 0;
 }//konec fce
 
@@ -220,6 +362,24 @@ Value_t & Value_t::operator = (const Value_t &v)
 
 ValueType_t Value_t::getValueType() const { return value->getType(); }
 
+const uint32_t *Value_t::getUInt32Array(size_t &count) const
+{
+    if (!value) {
+        count = 0;
+        return 0;
+    }
+    return value->getUInt32Array(count);
+}
+
+const uint64_t *Value_t::getUInt64Array(size_t &count) const
+{
+    if (!value) {
+        count = 0;
+        return 0;
+    }
+    return value->getUInt64Array(count);
+}
+
 Value_t::operator uint32_t () const throw (ValueTypeError_t)
 {
     return (uint32_t)(*value);
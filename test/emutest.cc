@@ -0,0 +1,1692 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Client tests run against the searchd emulator (no searchd needed)
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/error.h>
+#include <sphinxclient/metrics.h>
+#include <sphinxclient/slowlog.h>
+#include <sphinxclient/capture.h>
+
+#include "searchdemulator.h"
+#include "bulkdecode.h"
+#include "idsetkernels.h"
+#include "decodeplan.h"
+#include "filter.h"
+#include "schemacache.h"
+#include "querymachine.h"
+#include "recordfile.h"
+
+void buildHeader(Sphinx::Command_t, unsigned short, int, Sphinx::Query_t &,
+                 int queryCount=1);
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            ++failures; \
+        } \
+    } while (0)
+
+/// checks response built from default EmulatorResponse_t
+static void checkResponse(const Sphinx::Response_t &r,
+                          const Sphinx::EmulatorResponse_t &shape)
+{
+    CHECK(r.field.size() == shape.fields.size());
+    CHECK(r.attribute.size() == shape.attributes.size());
+    CHECK(r.entry.size() == shape.matchCount);
+    CHECK(r.entriesGot == shape.matchCount);
+    CHECK(r.entriesFound == shape.totalFound);
+    CHECK(r.word.size() == shape.words.size());
+    if (r.entry.size() != shape.matchCount) return;
+
+    for (size_t i = 0; i < r.entry.size(); ++i) {
+        const Sphinx::ResponseEntry_t &e = r.entry[i];
+        uint64_t docId = i + 1;
+        CHECK(e.documentId == docId);
+        CHECK(e.weight == shape.matchCount - i);
+        CHECK((uint32_t)e.attribute.find("gid")->second == docId);
+        CHECK((float)e.attribute.find("price")->second == (float)docId / 2);
+        CHECK((uint64_t)e.attribute.find("bid")->second
+              == (docId << 32 | docId));
+        std::vector<Sphinx::Value_t> tags = e.attribute.find("tags")->second;
+        CHECK(tags.size() == shape.mvaSize);
+        if (!tags.empty()) CHECK((uint32_t)tags.back()
+                                 == docId + shape.mvaSize - 1);
+        size_t tagCount;
+        const uint32_t *tagArray
+            = e.attribute.find("tags")->second.getUInt32Array(tagCount);
+        CHECK(tagArray && tagCount == shape.mvaSize);
+        if (tagArray && tagCount) CHECK(tagArray[0] == docId);
+        CHECK(((std::string)e.attribute.find("name")->second).size()
+              == shape.stringSize);
+    }
+}//konec fce
+
+/// metric sample looked up by metric()
+struct MetricQuery_t
+{
+    std::string name;
+    std::string labels;
+    int64_t value;
+};
+
+static void findMetric(const Sphinx::MetricSample_t &sample, void *data)
+{
+    MetricQuery_t &query = *static_cast<MetricQuery_t *>(data);
+    if (sample.name == query.name
+        && sample.labels.find(query.labels) != std::string::npos)
+    {
+        query.value += sample.value;
+    }
+}//konec fce
+
+/// sum of samples with given name and labels containing given string
+static int64_t metric(const std::string &name, const std::string &labels)
+{
+    MetricQuery_t query;
+    query.name = name;
+    query.labels = labels;
+    query.value = 0;
+    Sphinx::exportMetrics(findMetric, &query);
+    return query.value;
+}//konec fce
+
+static void testSearch(const Sphinx::ConnectionConfig_t &cfg,
+                       Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::EmulatorResponse_t shape;
+    emu.setResponse(shape);
+
+    Sphinx::Client_t client(cfg);
+    Sphinx::Response_t response;
+
+    // both search command versions
+    Sphinx::SearchConfig_t config;
+    client.query("test", config, response);
+    checkResponse(response, shape);
+
+    // call statistics
+    const Sphinx::QueryStats_t &stats = response.stats;
+    CHECK(stats.versionTime <= stats.requestTime);
+    CHECK(stats.requestTime <= stats.headerTime);
+    CHECK(stats.headerTime <= stats.responseTime);
+    CHECK(stats.bytesSent == emu.getLastRequest().getLength() + 12);
+    CHECK(stats.bytesReceived > 12);
+    CHECK(stats.syscalls >= 6);
+    CHECK(stats.connectRetries == 0);
+
+    Sphinx::SearchConfig_t config099(Sphinx::VER_COMMAND_SEARCH_0_9_9);
+    client.query("test", config099, response);
+    checkResponse(response, shape);
+
+    // arena decoding
+    Sphinx::Response_t arenaResponse;
+    arenaResponse.useArena = true;
+    client.query("test", config, arenaResponse);
+    checkResponse(arenaResponse, shape);
+
+    // 32bit ids, empty result
+    shape.use64bitId = false;
+    shape.matchCount = 0;
+    emu.setResponse(shape);
+    client.query("test", config, response);
+    CHECK(response.entry.empty());
+    CHECK(!response.use64bitId);
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+}//konec fce
+
+static void testReuse(const Sphinx::ConnectionConfig_t &cfg,
+                      Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::EmulatorResponse_t shape;
+    emu.setResponse(shape);
+    Sphinx::Client_t client(cfg);
+    Sphinx::SearchConfig_t config;
+
+    // arena response decoded over keeps its memory
+    Sphinx::Response_t response;
+    response.useArena = true;
+    client.query("test", config, response);
+    checkResponse(response, shape);
+    client.query("test", config, response);
+    checkResponse(response, shape);
+    CHECK(response.arena.getChunkCount() == 1);
+
+    // responses of one shape share interned schema
+    Sphinx::Response_t second;
+    client.query("test", config, second);
+    CHECK(second.schema.get() && second.schema.get() == response.schema.get());
+    CHECK(second.attribute == second.schema->getAttributes());
+    for (size_t i = 0; i < shape.attributes.size(); ++i)
+        CHECK(second.schema->findAttribute(shape.attributes[i].first) == i);
+
+    // moved by swap
+    Sphinx::Response_t moved;
+    moved.swap(response);
+    checkResponse(moved, shape);
+    CHECK(moved.useArena && response.entry.empty());
+
+    // changed schema leaves no stale attributes
+    Sphinx::EmulatorResponse_t other;
+    other.attributes.resize(2);
+    other.matchCount = shape.matchCount / 2;
+    emu.setResponse(other);
+    client.query("test", config, moved);
+    CHECK(moved.attribute.size() == 2);
+    CHECK(moved.entry.size() == other.matchCount);
+    for (size_t i = 0; i < moved.entry.size(); ++i) {
+        CHECK(moved.entry[i].attribute.size() == 2);
+        CHECK(!moved.entry[i].attribute.count("name"));
+    }
+    emu.setResponse(shape);
+
+    // multiquery replaces content of the vector
+    std::vector<Sphinx::Response_t> responses(5);
+    Sphinx::MultiQuery_t mq(config.getCommandVersion());
+    for (int i = 0; i < 3; ++i) mq.addQuery("test", config);
+    client.query(mq, responses);
+    CHECK(responses.size() == 3);
+    client.query(mq, responses);
+    CHECK(responses.size() == 3);
+    for (size_t i = 0; i < responses.size(); ++i)
+        checkResponse(responses[i], shape);
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+}//konec fce
+
+static void testSchemaCache()
+{
+    // one field, duplicate attribute name (the first one wins)
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    data << uint32_t(1) << std::string("title") << uint32_t(3)
+         << std::string("a") << uint32_t(Sphinx::SPH_ATTR_INTEGER)
+         << std::string("b") << uint32_t(Sphinx::SPH_ATTR_FLOAT)
+         << std::string("a") << uint32_t(Sphinx::SPH_ATTR_BIGINT);
+    unsigned int length = data.getLength();
+
+    Sphinx::SchemaPtr_t schema = Sphinx::SchemaCache_t::read(data);
+    CHECK(data.getLength() == 0);
+    CHECK(schema->getFields().size() == 1);
+    CHECK(schema->getAttributes().size() == 3);
+    CHECK(schema->findAttribute("a") == 0);
+    CHECK(schema->findAttribute("b") == 1);
+    CHECK(schema->findAttribute("c") == Sphinx::Schema_t::NO_ATTRIBUTE);
+    CHECK(schema->findAttribute("") == Sphinx::Schema_t::NO_ATTRIBUTE);
+
+    // same bytes give the same instance
+    size_t cached = Sphinx::SchemaCache_t::getSize();
+    data.dataStartPtr = 0;
+    CHECK(Sphinx::SchemaCache_t::read(data).get() == schema.get());
+    CHECK(Sphinx::SchemaCache_t::getSize() == cached);
+
+    // cut schema
+    Sphinx::Query_t cut;
+    cut.convertEndian = true;
+    cut.append(data.data, length - 2);
+    bool thrown = false;
+    try {
+        Sphinx::SchemaCache_t::read(cut);
+    } catch (const Sphinx::MessageError_t &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    // full cache evicts the least recently used schema, the one read
+    // again and again stays
+    Sphinx::SchemaPtr_t cold;
+    for (int i = 0; i < 1100; ++i) {
+        Sphinx::Query_t other;
+        other.convertEndian = true;
+        std::ostringstream field;
+        field << "field" << i;
+        other << uint32_t(1) << field.str() << uint32_t(0);
+        Sphinx::SchemaPtr_t read = Sphinx::SchemaCache_t::read(other);
+        if (!i) cold = read;
+        if (i % 100 == 99) {
+            data.dataStartPtr = 0;
+            CHECK(Sphinx::SchemaCache_t::read(data).get() == schema.get());
+        }
+    }
+    CHECK(Sphinx::SchemaCache_t::getSize() == 1024);
+    data.dataStartPtr = 0;
+    CHECK(Sphinx::SchemaCache_t::read(data).get() == schema.get());
+    Sphinx::Query_t coldData;
+    coldData.convertEndian = true;
+    coldData << uint32_t(1) << std::string("field0") << uint32_t(0);
+    CHECK(Sphinx::SchemaCache_t::read(coldData).get() != cold.get());
+
+    // projected plans are kept up to a bound, then compiled per call
+    for (int i = 0; i < 20; ++i) {
+        std::vector<std::string> projection(1, "a");
+        std::ostringstream name;
+        name << "x" << i;
+        projection.push_back(name.str());
+        std::auto_ptr<Sphinx::DecodePlan_t> first, second;
+        const Sphinx::DecodePlan_t &plan = Sphinx::SchemaCache_t::getPlan(
+                *schema, true, &projection, first);
+        const Sphinx::DecodePlan_t &again = Sphinx::SchemaCache_t::getPlan(
+                *schema, true, &projection, second);
+        CHECK((i < 16) == !first.get());
+        CHECK((i < 16) == (&plan == &again));
+    }
+}//konec fce
+
+/// checks response decoded with projection {"bid", "name"}
+static void checkProjected(const Sphinx::Response_t &r,
+                           const Sphinx::EmulatorResponse_t &shape)
+{
+    CHECK(r.attribute.size() == shape.attributes.size());
+    CHECK(r.entry.size() == shape.matchCount);
+    for (size_t i = 0; i < r.entry.size(); ++i) {
+        const Sphinx::ResponseEntry_t &e = r.entry[i];
+        uint64_t docId = i + 1;
+        CHECK(e.documentId == docId && e.weight == shape.matchCount - i);
+        CHECK(e.attribute.size() == 2);
+        CHECK(e.attribute.count("bid") && e.attribute.count("name"));
+        if (e.attribute.size() != 2) continue;
+        CHECK((uint64_t)e.attribute.find("bid")->second
+              == (docId << 32 | docId));
+        CHECK(((std::string)e.attribute.find("name")->second).size()
+              == shape.stringSize);
+    }
+}//konec fce
+
+static void testProjection(const Sphinx::ConnectionConfig_t &cfg,
+                           Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::EmulatorResponse_t shape;
+    emu.setResponse(shape);
+    Sphinx::Client_t client(cfg);
+
+    std::vector<std::string> names;
+    names.push_back("bid");
+    names.push_back("name");
+    Sphinx::SearchConfig_t all, projected;
+    projected.setProjection(names);
+    CHECK(projected.getSelectClause() == "*");
+
+    // reused response switches between projected and full decoding
+    Sphinx::Response_t response;
+    client.query("test", projected, response);
+    checkProjected(response, shape);
+    client.query("test", all, response);
+    checkResponse(response, shape);
+    client.query("test", projected, response);
+    checkProjected(response, shape);
+
+    // derived select clause
+    Sphinx::SearchConfig_t narrowed;
+    narrowed.setProjection(names, true);
+    CHECK(narrowed.getSelectClause() == "bid, name");
+    Sphinx::SearchConfig_t custom;
+    custom.setSelectClause("bid, @weight*2 AS w");
+    custom.setProjection(names, true);
+    CHECK(custom.getSelectClause() == "bid, @weight*2 AS w");
+
+    // each query of multiquery has its own projection
+    std::vector<Sphinx::Response_t> responses;
+    Sphinx::MultiQuery_t mq(all.getCommandVersion());
+    mq.addQuery("test", projected);
+    mq.addQuery("test", all);
+    client.query(mq, responses);
+    CHECK(responses.size() == 2);
+    if (responses.size() == 2) {
+        checkProjected(responses[0], shape);
+        checkResponse(responses[1], shape);
+    }
+
+    Sphinx::MultiQueryOpt_t mqo(all.getCommandVersion());
+    for (int i = 0; i < 4; ++i) {
+        Sphinx::SearchConfig_t c = i % 2 ? all : projected;
+        c.addRangeFilter("gid", 0, i / 2);
+        mqo.addQuery("test", c);
+    }
+    mqo.optimise();
+    client.query(mqo, responses);
+    CHECK(responses.size() == 4);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        if (i % 2) checkResponse(responses[i], shape);
+        else checkProjected(responses[i], shape);
+    }
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+}//konec fce
+
+/// row bound to attributes of default EmulatorResponse_t
+struct Hit_t
+{
+    uint64_t id;
+    uint32_t weight;
+    uint32_t gid;
+    uint64_t wideGid;
+    float price;
+    uint64_t bid;
+    std::vector<uint32_t> tags;
+    std::vector<uint64_t> wideTags;
+    std::string name;
+};
+
+static void testRowBinding(const Sphinx::ConnectionConfig_t &cfg,
+                           Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::EmulatorResponse_t shape;
+    emu.setResponse(shape);
+    Sphinx::Client_t client(cfg);
+    Sphinx::SearchConfig_t config;
+
+    Sphinx::RowBinding_t<Hit_t> binding;
+    binding.bindDocumentId(&Hit_t::id).bindWeight(&Hit_t::weight);
+    SPHINX_BIND_ATTRIBUTE(binding, Hit_t, gid);
+    SPHINX_BIND_ATTRIBUTE(binding, Hit_t, price);
+    SPHINX_BIND_ATTRIBUTE(binding, Hit_t, bid);
+    SPHINX_BIND_ATTRIBUTE(binding, Hit_t, tags);
+    SPHINX_BIND_ATTRIBUTE(binding, Hit_t, name);
+    binding.bind("gid", &Hit_t::wideGid).bind("tags", &Hit_t::wideTags);
+
+    // rows are reused by the second call
+    std::vector<Hit_t> hits;
+    Sphinx::Response_t response;
+    for (int call = 0; call < 2; ++call) {
+        client.query("test", config, binding, hits, response);
+        CHECK(hits.size() == shape.matchCount);
+        CHECK(response.entry.empty());
+        CHECK(response.entriesGot == shape.matchCount);
+        CHECK(response.attribute.size() == shape.attributes.size());
+        for (size_t i = 0; i < hits.size(); ++i) {
+            const Hit_t &h = hits[i];
+            uint64_t docId = i + 1;
+            CHECK(h.id == docId && h.weight == shape.matchCount - i);
+            CHECK(h.gid == docId && h.wideGid == docId);
+            CHECK(h.price == (float)docId / 2);
+            CHECK(h.bid == (docId << 32 | docId));
+            CHECK(h.tags.size() == shape.mvaSize);
+            CHECK(h.wideTags.size() == shape.mvaSize);
+            if (!h.tags.empty() && !h.wideTags.empty()) {
+                CHECK(h.tags[0] == docId);
+                CHECK(h.wideTags.back() == docId + shape.mvaSize - 1);
+            }
+            CHECK(h.name.size() == shape.stringSize);
+        }
+    }
+
+    // binding checked against the schema
+    Sphinx::RowBinding_t<Hit_t> wrongType;
+    wrongType.bind("price", &Hit_t::gid);
+    Sphinx::RowBinding_t<Hit_t> missing;
+    missing.bind("nothing", &Hit_t::gid);
+    for (int i = 0; i < 2; ++i) {
+        bool thrown = false;
+        try {
+            client.query("test", config, i ? missing : wrongType, hits,
+                         response);
+        } catch (const Sphinx::ValueTypeError_t &) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+}//konec fce
+
+static void testDocumentIds(const Sphinx::ConnectionConfig_t &cfg,
+                            Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::EmulatorResponse_t shape;
+    emu.setResponse(shape);
+    Sphinx::Client_t client(cfg);
+    Sphinx::SearchConfig_t config;
+
+    Sphinx::DocumentIdSet_t ids;
+    Sphinx::Response_t response;
+    for (int call = 0; call < 2; ++call) {
+        client.query("test", config, ids, response);
+        CHECK(ids.size() == shape.matchCount);
+        CHECK(response.entry.empty());
+        CHECK(response.entriesGot == shape.matchCount);
+        for (size_t i = 0; i < ids.size(); ++i)
+            CHECK(ids.getIds()[i] == i + 1);
+    }
+
+    // set fed back as filter
+    Sphinx::SearchConfig_t next;
+    next.addEnumFilter("@id", ids.getFilter());
+    std::string name;
+    bool exclude = true;
+    Sphinx::Int64Array_t values;
+    CHECK(next.getFilter(0, name, exclude, values));
+    CHECK(name == "@id" && !exclude && values == ids.getIds());
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+}//konec fce
+
+static void testMultiQuery(const Sphinx::ConnectionConfig_t &cfg,
+                           Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::EmulatorResponse_t shape;
+    Sphinx::Client_t client(cfg);
+    std::vector<Sphinx::Response_t> responses;
+
+    Sphinx::SearchConfig_t config;
+    Sphinx::MultiQuery_t mq(config.getCommandVersion());
+    for (int i = 0; i < 3; ++i) mq.addQuery("test", config);
+    client.query(mq, responses);
+    CHECK(responses.size() == 3);
+    for (size_t i = 0; i < responses.size(); ++i)
+        checkResponse(responses[i], shape);
+
+    // optimised multiquery over several connections
+    uint32_t connections = emu.getConnectionCount();
+    Sphinx::MultiQueryOpt_t mqo(config.getCommandVersion());
+    mqo.setConnectionBudget(3);
+    for (int i = 0; i < 7; ++i) {
+        Sphinx::SearchConfig_t c;
+        c.addRangeFilter("gid", 0, i % 2);
+        mqo.addQuery("test", c);
+    }
+    mqo.optimise();
+    client.query(mqo, responses);
+    CHECK(responses.size() == 7);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        checkResponse(responses[i], shape);
+        CHECK(responses[i].stats.responseTime > 0);
+    }
+    CHECK(emu.getConnectionCount() - connections == 3);
+
+    // large responses are decoded on the parse pool
+    shape.matchCount = 500;
+    emu.setResponse(shape);
+    client.setParseThreads(4);
+    Sphinx::MultiQuery_t big(config.getCommandVersion());
+    for (int i = 0; i < 8; ++i) big.addQuery("test", config);
+    responses.clear();
+    client.query(big, responses);
+    CHECK(responses.size() == 8);
+    for (size_t i = 0; i < responses.size(); ++i)
+        checkResponse(responses[i], shape);
+    client.query(mqo, responses);
+    CHECK(responses.size() == 7);
+    for (size_t i = 0; i < responses.size(); ++i)
+        checkResponse(responses[i], shape);
+
+    // pool decodes into the caller's responses, arena and entries kept
+    client.query(big, responses);
+    std::vector<const Sphinx::ResponseEntry_t *> entries;
+    for (size_t i = 0; i < responses.size(); ++i) {
+        responses[i].useArena = true;
+        entries.push_back(&responses[i].entry[0]);
+    }
+    client.query(big, responses);
+    client.query(big, responses);
+    CHECK(responses.size() == 8);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        checkResponse(responses[i], shape);
+        CHECK(responses[i].useArena);
+        CHECK(responses[i].arena.getChunkCount() == 1);
+        CHECK(&responses[i].entry[0] == entries[i]);
+    }
+
+    // warnings are reported as with serial decoding
+    shape.queryStatus = Sphinx::SEARCHD_WARNING;
+    shape.queryMessage = "emulated warning";
+    emu.setResponse(shape);
+    responses.clear();
+    bool warned = false;
+    try {
+        client.query(big, responses);
+    } catch (const Sphinx::Warning_t &e) {
+        warned = std::string(e.what()).find("Query 8") != std::string::npos;
+    }
+    CHECK(warned && responses.size() == 8);
+    if (responses.size() == 8) checkResponse(responses[7], shape);
+    warned = false;
+    try {
+        client.query(mqo, responses);
+    } catch (const Sphinx::Warning_t &) {
+        warned = true;
+    }
+    CHECK(warned && responses.size() == 7);
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+}//konec fce
+
+/// exposes connections planned by MultiQueryOpt_t
+struct PlannedQuery_t : public Sphinx::MultiQueryOpt_t
+{
+    PlannedQuery_t(Sphinx::SearchCommandVersion_t cmdVersion)
+        : Sphinx::MultiQueryOpt_t(cmdVersion)
+    {}
+
+    /// input sequence numbers per connection, "0,3 | 1 ..."
+    std::string describeConnections() const
+    {
+        std::ostringstream out;
+        for (size_t i = 0; i < getGroupQueryCount(); ++i) {
+            out << (i ? " | " : "");
+            for (size_t j = 0; j < getQueryCountAtGroup(i); ++j) {
+                out << (j ? "," : "")
+                    << sortedQueries[groupQueries[i] + j]->getInputSeqNo();
+            }
+        }
+        return out.str();
+    }
+};
+
+/// attributes decoded for query of given sequence number, unique to it
+static std::vector<std::string> plannedProjection(int seqNo)
+{
+    static const char *names[] = {"gid", "price", "bid", "tags", "name"};
+    std::vector<std::string> projection(1, names[seqNo % 5]);
+    if (seqNo >= 5) projection.push_back(names[(seqNo - 4) % 5]);
+    return projection;
+}//konec fce
+
+static void testPlanGroups(const Sphinx::ConnectionConfig_t &cfg,
+                           Sphinx::SearchdEmulator_t &emu)
+{
+    // "heavy" sorts many matches alone, four "y" queries share matching
+    // but sort unequal counts, two "zz" queries are cheap
+    static const char *queries[] = {"y", "heavy", "zz", "y", "y", "zz", "y"};
+    static const int maxMatches[] = {3000, 5000, 10, 1000, 1000, 10, 1000};
+    const size_t count = sizeof(queries) / sizeof(queries[0]);
+
+    Sphinx::EmulatorResponse_t shape;
+    emu.setResponse(shape);
+    Sphinx::Client_t client(cfg);
+    std::vector<Sphinx::Response_t> responses;
+
+    static const size_t budgets[] = {2, 3, 4, 5};
+    static const char *planned[] = {
+        // longest first: "y" (7001), "heavy" (6005), "zz" to the lighter
+        "0,3,4,6 | 1,2,5",
+        // one group per connection
+        "1 | 0,3,4,6 | 2,5",
+        // "y" split by half of sorting cost
+        "1 | 0 | 2,5 | 3,4,6",
+        // then its more expensive half
+        "1 | 0 | 2,5 | 3,4 | 6"};
+    for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); ++b) {
+        PlannedQuery_t mqo(Sphinx::SearchConfig_t().getCommandVersion());
+        mqo.setConnectionBudget(budgets[b]);
+        for (size_t i = 0; i < count; ++i) {
+            Sphinx::SearchConfig_t c;
+            c.setMaxMatches(maxMatches[i]);
+            c.setProjection(plannedProjection(i));
+            mqo.addQuery(queries[i], c);
+        }
+        mqo.optimise();
+        CHECK(mqo.describeConnections() == planned[b]);
+
+        // responses come back in the order of queries
+        client.query(mqo, responses);
+        CHECK(responses.size() == count);
+        for (size_t i = 0; i < responses.size(); ++i) {
+            std::vector<std::string> projection = plannedProjection(i);
+            CHECK(responses[i].entry.size() == shape.matchCount);
+            if (responses[i].entry.empty()) continue;
+            const Sphinx::ResponseEntry_t &e = responses[i].entry[0];
+            CHECK(e.attribute.size() == projection.size());
+            for (size_t j = 0; j < projection.size(); ++j)
+                CHECK(e.attribute.count(projection[j]));
+        }
+    }
+}//konec fce
+
+/// records queries handed over by query machine as they finish
+struct CompletionRecorder_t : public Sphinx::QueryCompletion_t
+{
+    CompletionRecorder_t(Sphinx::QueryMachine_t &machine)
+        : machine(machine)
+    {}
+
+    virtual void completed(size_t index)
+    {
+        order.push_back(index);
+        lengths.push_back(machine.getResponse(index).getLength());
+        machine.releaseResponse(index);
+    }
+
+    Sphinx::QueryMachine_t &machine;
+    std::vector<size_t> order;
+    std::vector<unsigned int> lengths;
+};
+
+static void testCompletion(const Sphinx::ConnectionConfig_t &cfg)
+{
+    Sphinx::SearchConfig_t config;
+    Sphinx::MultiQuery_t mq(config.getCommandVersion());
+    mq.addQuery("test", config);
+    Sphinx::Query_t request;
+    request.convertEndian = true;
+    buildHeader(Sphinx::SEARCHD_COMMAND_SEARCH, config.getCommandVersion(),
+                mq.getQueries().getLength(), request);
+    request << mq.getQueries();
+
+    Sphinx::QueryMachine_t machine(cfg);
+    for (int i = 0; i < 3; ++i) machine.addQuery(request);
+    CompletionRecorder_t recorder(machine);
+    machine.launch(&recorder);
+
+    // each query once, response handed over whole, buffer released
+    std::vector<size_t> order(recorder.order);
+    std::sort(order.begin(), order.end());
+    CHECK(order.size() == 3);
+    for (size_t i = 0; i < order.size() && i < 3; ++i) {
+        CHECK(order[i] == i);
+        CHECK(recorder.lengths[i] > 0);
+        CHECK(machine.getResponse(i).getLength() == 0);
+    }
+}//konec fce
+
+static void testUpdateKeywords(const Sphinx::ConnectionConfig_t &cfg,
+                               Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::Client_t client(cfg);
+
+    Sphinx::AttributeUpdates_t updates;
+    updates.addAttribute("gid");
+    for (uint64_t doc = 1; doc <= 3; ++doc) {
+        std::vector<Sphinx::Value_t> values;
+        values.push_back(Sphinx::Value_t((uint32_t)doc));
+        updates.addDocument(doc, values);
+    }
+    uint32_t before = emu.getRequestCount(Sphinx::SEARCHD_COMMAND_UPDATE);
+    client.updateAttributes("index", updates);
+    CHECK(emu.getRequestCount(Sphinx::SEARCHD_COMMAND_UPDATE) == before + 1);
+
+    // partial update is reported
+    Sphinx::EmulatorResponse_t shape;
+    shape.updatedCount = 1;
+    emu.setResponse(shape);
+    bool thrown = false;
+    try {
+        client.updateAttributes("index", updates);
+    } catch (const Sphinx::ClientUsageError_t &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+
+    std::vector<Sphinx::KeywordResult_t> words
+        = client.getKeywords("index", "Hello  World", true);
+    CHECK(words.size() == 2);
+    if (words.size() == 2) {
+        CHECK(words[0].tokenized == "Hello");
+        CHECK(words[0].normalized == "hello");
+        CHECK(words[1].statistics.docsHit == 2);
+        CHECK(words[1].statistics.totalHits == 4);
+    }
+}//konec fce
+
+/// runs query expecting exception of type Error_t
+template <class Error_t>
+static bool queryThrows(const Sphinx::ConnectionConfig_t &cfg)
+{
+    Sphinx::Client_t client(cfg);
+    Sphinx::SearchConfig_t config;
+    Sphinx::Response_t response;
+    try {
+        client.query("test", config, response);
+    } catch (const Error_t &) {
+        return true;
+    } catch (...) {
+        return false;
+    }
+    return false;
+}//konec fce
+
+static void testFaults(const Sphinx::ConnectionConfig_t &cfg,
+                       Sphinx::SearchdEmulator_t &emu)
+{
+    Sphinx::EmulatorFaults_t faults;
+    Sphinx::EmulatorResponse_t shape;
+
+    // status codes
+    faults.responseStatus = Sphinx::SEARCHD_ERROR;
+    faults.statusMessage = "emulated error";
+    emu.setFaults(faults);
+    CHECK(queryThrows<Sphinx::MessageError_t>(cfg));
+
+    faults = Sphinx::EmulatorFaults_t();
+    emu.setFaults(faults);
+    shape.queryStatus = Sphinx::SEARCHD_ERROR;
+    shape.queryMessage = "emulated query error";
+    emu.setResponse(shape);
+    CHECK(queryThrows<Sphinx::MessageError_t>(cfg));
+    shape.queryStatus = Sphinx::SEARCHD_WARNING;
+    emu.setResponse(shape);
+    CHECK(queryThrows<Sphinx::Warning_t>(cfg));
+    emu.setResponse(Sphinx::EmulatorResponse_t());
+
+    // connection resets
+    faults.reset = Sphinx::EmulatorFaults_t::RESET_ON_ACCEPT;
+    emu.setFaults(faults);
+    CHECK(queryThrows<Sphinx::Error_t>(cfg));
+    faults.reset = Sphinx::EmulatorFaults_t::RESET_AFTER_REQUEST;
+    emu.setFaults(faults);
+    CHECK(queryThrows<Sphinx::Error_t>(cfg));
+    faults.reset = Sphinx::EmulatorFaults_t::RESET_MID_RESPONSE;
+    emu.setFaults(faults);
+    CHECK(queryThrows<Sphinx::Error_t>(cfg));
+
+    // latency over read timeout
+    int64_t timeouts = metric("sphinxclient_timeouts_total",
+                              "state=\"read_response_header\"");
+    int64_t errors = metric("sphinxclient_errors_total",
+                            "class=\"ConnectionError_t\"");
+    faults = Sphinx::EmulatorFaults_t();
+    faults.latency = cfg.getReadTimeout() + 200;
+    emu.setFaults(faults);
+    CHECK(queryThrows<Sphinx::ConnectionError_t>(cfg));
+    CHECK(metric("sphinxclient_timeouts_total",
+                 "state=\"read_response_header\"") == timeouts + 1);
+    CHECK(metric("sphinxclient_errors_total",
+                 "class=\"ConnectionError_t\"") == errors + 1);
+
+    // slow trickle, each chunk within read timeout
+    faults = Sphinx::EmulatorFaults_t();
+    faults.latency = 10;
+    faults.trickleChunk = 512;
+    faults.trickleDelay = 5;
+    emu.setFaults(faults);
+    Sphinx::Client_t client(cfg);
+    Sphinx::SearchConfig_t config;
+    Sphinx::Response_t response;
+    client.query("test", config, response);
+    checkResponse(response, Sphinx::EmulatorResponse_t());
+    CHECK(response.stats.headerTime >= faults.latency * 1000);
+    CHECK(response.stats.responseTime - response.stats.headerTime
+          >= faults.trickleDelay * 1000);
+
+    emu.setFaults(Sphinx::EmulatorFaults_t());
+}//konec fce
+
+static void testMetrics(const Sphinx::ConnectionConfig_t &cfg)
+{
+    std::ostringstream endpoint;
+    if (cfg.isDomainSocketUsed()) endpoint << "unix://" << cfg.getHost();
+    else endpoint << cfg.getHost() << ":" << cfg.getPort();
+    std::string label = "endpoint=\"" + endpoint.str() + "\"";
+
+    int64_t requests = metric("sphinxclient_requests_total",
+                              "command=\"search\"");
+    int64_t calls = metric("sphinxclient_request_duration_microseconds_count",
+                           label);
+
+    Sphinx::Client_t client(cfg);
+    Sphinx::SearchConfig_t config;
+    Sphinx::Response_t response;
+    client.query("test", config, response);
+
+    CHECK(metric("sphinxclient_requests_total", "command=\"search\"")
+          == requests + 1);
+    CHECK(metric("sphinxclient_request_duration_microseconds_count", label)
+          == calls + 1);
+    CHECK(metric("sphinxclient_response_size_bytes_sum", label) > 0);
+    CHECK(metric("sphinxclient_requests_in_flight", "") == 0);
+
+    std::string text = Sphinx::exportMetricsText();
+    CHECK(text.find("# TYPE sphinxclient_request_duration_microseconds "
+                    "histogram\n") != std::string::npos);
+    CHECK(text.find("sphinxclient_request_duration_microseconds_bucket{"
+                    + label + ",le=\"+Inf\"}") != std::string::npos);
+}//konec fce
+
+/// records observed events
+class RecordingObserver_t : public Sphinx::QueryObserver_t
+{
+public:
+    RecordingObserver_t() : starts(0), timeouts(0), failures(0) {}
+
+    virtual void started(const Sphinx::QueryEvent_t &event) {
+        ++starts;
+    }
+    virtual void stateChanged(const Sphinx::QueryEvent_t &event,
+                              Sphinx::QueryState_t state)
+    {
+        states.push_back(state);
+        lastElapsed = event.elapsed;
+        lastReceived = event.stats->bytesReceived;
+    }
+    virtual void timeout(const Sphinx::QueryEvent_t &event) {
+        ++timeouts;
+    }
+    virtual void failed(const Sphinx::QueryEvent_t &event,
+                        const std::string &message)
+    {
+        ++failures;
+    }
+
+    int starts;
+    int timeouts;
+    int failures;
+    std::vector<Sphinx::QueryState_t> states;
+    uint32_t lastElapsed;
+    uint64_t lastReceived;
+};
+
+static void testObserver(const Sphinx::ConnectionConfig_t &cfg,
+                         Sphinx::SearchdEmulator_t &emu)
+{
+    RecordingObserver_t observer;
+    Sphinx::Client_t client(cfg);
+    client.setObserver(&observer);
+
+    Sphinx::SearchConfig_t config;
+    Sphinx::Response_t response;
+    client.query("test", config, response);
+    CHECK(observer.starts == 1);
+    CHECK(observer.states.size() == 6);
+    for (size_t i = 0; i < observer.states.size(); ++i)
+        CHECK(observer.states[i] == Sphinx::QueryState_t(i + 1));
+    CHECK(observer.lastElapsed >= response.stats.responseTime);
+    CHECK(observer.lastReceived == response.stats.bytesReceived);
+    CHECK(observer.timeouts == 0 && observer.failures == 0);
+
+    // read timeout fails the query
+    Sphinx::EmulatorFaults_t faults;
+    faults.latency = cfg.getReadTimeout() + 200;
+    emu.setFaults(faults);
+    bool thrown = false;
+    try {
+        client.query("test", config, response);
+    } catch (const Sphinx::ConnectionError_t &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(observer.timeouts == 1);
+    CHECK(observer.failures == 1);
+    emu.setFaults(Sphinx::EmulatorFaults_t());
+}//konec fce
+
+static void testSlowLog(const Sphinx::ConnectionConfig_t &cfg,
+                        Sphinx::SearchdEmulator_t &emu)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/sphinxslow-%d.log", (int)getpid());
+
+    Sphinx::SlowQueryLogConfig_t logConfig(path);
+    logConfig.thresholdMs = 100;
+    logConfig.sampleEvery = 0;
+    Sphinx::SlowQueryLog_t log(logConfig);
+    Sphinx::Client_t client(cfg);
+    client.setSlowQueryLog(&log);
+
+    // fast call is not logged, slow one is
+    Sphinx::SearchConfig_t config;
+    Sphinx::Response_t response;
+    client.query("fast", config, response);
+    Sphinx::EmulatorFaults_t faults;
+    faults.latency = 150;
+    emu.setFaults(faults);
+    client.query("slow", config, response);
+    emu.setFaults(Sphinx::EmulatorFaults_t());
+
+    std::vector<Sphinx::Response_t> responses;
+    Sphinx::MultiQuery_t mq(config.getCommandVersion());
+    for (int i = 0; i < 2; ++i) mq.addQuery("test", config);
+    client.query(mq, responses);
+
+    log.flush();
+    CHECK(log.getWritten() == 1);
+    CHECK(log.getDropped() == 0);
+
+    std::ostringstream endpoint;
+    if (cfg.isDomainSocketUsed()) endpoint << "unix://" << cfg.getHost();
+    else endpoint << cfg.getHost() << ":" << cfg.getPort();
+
+    {
+        Sphinx::SlowQueryLogReader_t reader(path);
+        Sphinx::SlowQueryRecord_t record;
+        CHECK(reader.next(record));
+        CHECK(record.query == "slow");
+        CHECK(record.flags == Sphinx::SLOWLOG_SLOW);
+        CHECK(record.elapsed >= 150000);
+        CHECK(record.endpoint == endpoint.str());
+        CHECK(record.stats.responseTime == response.stats.responseTime
+              || record.stats.responseTime > 0);
+        CHECK(record.config.find("indexes=*") != std::string::npos);
+        CHECK(record.requests.size() == 1);
+        CHECK(!record.requests.empty() && record.requests[0].size() > 8);
+        CHECK(!reader.next(record));
+    }
+
+    // sampling every call
+    {
+        Sphinx::SlowQueryLogConfig_t sampledConfig(path);
+        sampledConfig.thresholdMs = 0;
+        sampledConfig.sampleEvery = 1;
+        Sphinx::SlowQueryLog_t sampled(sampledConfig);
+        client.setSlowQueryLog(&sampled);
+        client.query(mq, responses);
+        sampled.flush();
+        client.setSlowQueryLog(0);
+
+        Sphinx::SlowQueryLogReader_t reader(path);
+        Sphinx::SlowQueryRecord_t record;
+        CHECK(reader.next(record));
+        CHECK(record.flags == Sphinx::SLOWLOG_SAMPLED);
+        CHECK(record.query.empty());
+        CHECK(record.config == "multiquery 2 queries");
+        CHECK(record.requests.size() == 1);
+    }
+    unlink(path);
+    unlink((std::string(path) + ".1").c_str());
+}//konec fce
+
+static void testCapture(const Sphinx::ConnectionConfig_t &cfg,
+                        Sphinx::SearchdEmulator_t &emu)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/sphinxcapt-%d.cap", (int)getpid());
+
+    Sphinx::RequestCapture_t capture((Sphinx::CaptureConfig_t(path)));
+    Sphinx::Client_t client(cfg);
+    client.setCapture(&capture);
+
+    Sphinx::SearchConfig_t config;
+    Sphinx::Response_t response;
+    client.query("test", config, response);
+
+    std::vector<Sphinx::Response_t> responses;
+    Sphinx::MultiQuery_t mq(config.getCommandVersion());
+    for (int i = 0; i < 3; ++i) mq.addQuery("test", config);
+    client.query(mq, responses);
+
+    client.getKeywords("index", "Hello World", false);
+
+    // failed call is not captured
+    Sphinx::EmulatorFaults_t faults;
+    faults.reset = Sphinx::EmulatorFaults_t::RESET_AFTER_REQUEST;
+    emu.setFaults(faults);
+    try {
+        client.query("test", config, response);
+    } catch (const Sphinx::Error_t &) {}
+    emu.setFaults(Sphinx::EmulatorFaults_t());
+    client.setCapture(0);
+
+    capture.flush();
+    CHECK(capture.getWritten() == 3);
+    CHECK(capture.getDropped() == 0);
+
+    Sphinx::RequestCaptureReader_t reader(path);
+    Sphinx::CapturedCall_t call;
+    CHECK(reader.next(call));
+    CHECK(call.command == Sphinx::SEARCHD_COMMAND_SEARCH);
+    CHECK(call.version == config.getCommandVersion());
+    CHECK(call.elapsed > 0 && call.timestamp > 0);
+    CHECK(call.requests.size() == 1);
+    if (!call.requests.empty()) {
+        CHECK(call.requests[0].queryCount == 1);
+        CHECK(call.requests[0].body.size() * 3
+              == mq.getQueries().getLength());
+    }
+    uint64_t first = call.timestamp;
+
+    CHECK(reader.next(call));
+    CHECK(call.command == Sphinx::SEARCHD_COMMAND_SEARCH);
+    CHECK(call.timestamp >= first);
+    CHECK(call.requests.size() == 1);
+    if (!call.requests.empty()) {
+        CHECK(call.requests[0].queryCount == 3);
+        CHECK(call.requests[0].body.size() == mq.getQueries().getLength());
+    }
+
+    CHECK(reader.next(call));
+    CHECK(call.command == Sphinx::SEARCHD_COMMAND_KEYWORDS);
+    CHECK(!reader.next(call));
+    unlink(path);
+}//konec fce
+
+/// search request built from config
+static std::string serialized(const Sphinx::SearchConfig_t &config)
+{
+    Sphinx::MultiQuery_t mq(config.getCommandVersion());
+    mq.addQuery("test", config);
+    const Sphinx::Query_t &queries = mq.getQueries();
+    return std::string(reinterpret_cast<const char *>(queries.data),
+                       queries.getLength());
+}//konec fce
+
+/// MVA value read by several threads at once
+static void *readValueView(void *value)
+{
+    const std::vector<Sphinx::Value_t> &view
+        = *static_cast<const Sphinx::Value_t *>(value);
+    return const_cast<std::vector<Sphinx::Value_t> *>(&view);
+}//konec fce
+
+static void testSharedValue()
+{
+    uint32_t values[64];
+    for (uint32_t i = 0; i < 64; ++i) values[i] = i * 3;
+    for (int round = 0; round < 50; ++round) {
+        const Sphinx::Value_t value(values, 64, 0);
+        pthread_t threads[4];
+        void *views[4];
+        for (int i = 0; i < 4; ++i)
+            pthread_create(&threads[i], 0, readValueView,
+                           const_cast<Sphinx::Value_t *>(&value));
+        for (int i = 0; i < 4; ++i) pthread_join(threads[i], &views[i]);
+
+        // all readers see the one published view
+        const std::vector<Sphinx::Value_t> &view = value;
+        for (int i = 0; i < 4; ++i) CHECK(views[i] == &view);
+        CHECK(view.size() == 64);
+        if (view.size() == 64) CHECK((uint32_t)view[63] == 189);
+    }
+}//konec fce
+
+/// writer kept busy by submitRecords() until stop is set
+struct BusyWriter_t
+{
+    Sphinx::RecordWriter_t *writer;
+    volatile bool stop;
+};
+
+static void *submitRecords(void *arg)
+{
+    BusyWriter_t &busy = *static_cast<BusyWriter_t *>(arg);
+    Sphinx::Query_t record;
+    record << uint32_t(42);
+    while (!busy.stop) busy.writer->submit(record);
+    return 0;
+}//konec fce
+
+static void testRecordWriterFlush()
+{
+    static const Sphinx::RecordFormat_t format = {"SPHXTEST", 1, "test file"};
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/sphinxrec-%d.bin", (int)getpid());
+
+    // flush returns while other thread keeps the queue non-empty
+    BusyWriter_t busy;
+    busy.writer = new Sphinx::RecordWriter_t(format, path, 1 << 30, 0, 64);
+    busy.stop = false;
+    pthread_t submitter;
+    pthread_create(&submitter, 0, submitRecords, &busy);
+    usleep(20000);
+    busy.writer->flush();
+    CHECK(busy.writer->getWritten() > 0);
+    busy.stop = true;
+    pthread_join(submitter, 0);
+
+    busy.writer->flush();
+    uint64_t submitted = busy.writer->getWritten();
+    delete busy.writer;
+    CHECK(submitted > 0);
+    unlink(path);
+    unlink((std::string(path) + ".1").c_str());
+}//konec fce
+
+static void testSearchConfigCopy()
+{
+    Sphinx::SearchConfig_t original;
+    original.addRangeFilter("gid", 1, 5);
+    original.setSelectClause("*, gid * 2 AS g2");
+    std::string request = serialized(original);
+
+    // copies share filters and expressions until written
+    Sphinx::SearchConfig_t copy(original);
+    Sphinx::SearchConfig_t assigned;
+    assigned = original;
+    CHECK(copy.getFilter(0) == original.getFilter(0));
+    CHECK(assigned.getFilter(0) == original.getFilter(0));
+    CHECK(&copy.getSelectClause() == &original.getSelectClause());
+    CHECK(serialized(copy) == request);
+
+    // new filter detaches the copy only
+    copy.addRangeFilter("bid", 2, 3);
+    CHECK(copy.getFilterCount() == 2 && original.getFilterCount() == 1);
+    CHECK(copy.getFilter(0) != original.getFilter(0));
+    CHECK(&copy.getSelectClause() == &original.getSelectClause());
+    CHECK(serialized(copy) != request);
+    CHECK(serialized(original) == request);
+
+    // and so does new select clause
+    assigned.setSelectClause("gid");
+    CHECK(assigned.getSelectClause() == "gid");
+    CHECK(original.getSelectClause() == "*, gid * 2 AS g2");
+    CHECK(assigned.getFilter(0) == original.getFilter(0));
+    CHECK(serialized(assigned) != request);
+    CHECK(serialized(original) == request);
+    CHECK(serialized(Sphinx::SearchConfig_t(original)) == request);
+}//konec fce
+
+/// normalized filters of config as "attr:min..max", "!attr:{a,b}" ...,
+/// integer values printed signed
+static std::string describeFilters(Sphinx::SearchConfig_t config)
+{
+    config.normalizeFilters();
+    std::ostringstream out;
+    for (unsigned i = 0; i < config.getFilterCount(); ++i) {
+        const Sphinx::Filter_t *filter = config.getFilter(i);
+        out << (i ? " " : "") << (filter->excludeFlag ? "!" : "")
+            << filter->attrName << ":";
+        if (filter->getType() == Sphinx::SPH_FILTER_RANGE) {
+            const Sphinx::RangeFilter_t *range
+                = static_cast<const Sphinx::RangeFilter_t *>(filter);
+            out << int64_t(range->minValue) << ".." << int64_t(range->maxValue);
+        } else if (filter->getType() == Sphinx::SPH_FILTER_VALUES) {
+            Sphinx::Int64Array_t values
+                = static_cast<const Sphinx::EnumFilter_t *>(filter)
+                    ->getValues();
+            out << "{";
+            for (size_t v = 0; v < values.size(); ++v)
+                out << (v ? "," : "") << int64_t(values[v]);
+            out << "}";
+        }
+    }
+    return out.str();
+}//konec fce
+
+/// two enum filter values
+static Sphinx::Int64Array_t enumValues(int64_t a, int64_t b)
+{
+    Sphinx::Int64Array_t values;
+    values.push_back(a);
+    values.push_back(b);
+    return values;
+}//konec fce
+
+static void testNormalizeFilters()
+{
+    // duplicates dropped, canonical order by attribute
+    Sphinx::SearchConfig_t dup;
+    dup.addRangeFilter("gid", 1, 5);
+    dup.addRangeFilter("bid", 2, 2);
+    dup.addRangeFilter("gid", 1, 5);
+    CHECK(describeFilters(dup) == "bid:2..2 gid:1..5");
+
+    // contiguous enums become ranges, others stay sorted enums
+    Sphinx::SearchConfig_t enums;
+    Sphinx::Int64Array_t three = enumValues(3, 1);
+    three.push_back(2);
+    enums.addEnumFilter("a", three);
+    enums.addEnumFilter("b", enumValues(3, 1));
+    enums.addEnumFilter("c", enumValues(1, 0) , true);
+    enums.addEnumFilter("c", enumValues(5, 1), true);
+    CHECK(describeFilters(enums) == "a:1..3 b:{1,3} !c:{0,1,5}");
+
+    // excluded ranges join, wider included ranges are dropped
+    Sphinx::SearchConfig_t merge;
+    merge.addRangeFilter("a", 4, 6, true);
+    merge.addRangeFilter("a", 1, 3, true);
+    merge.addRangeFilter("a", 9, 9, true);
+    merge.addRangeFilter("b", 1, 10);
+    merge.addRangeFilter("b", 2, 3);
+    CHECK(describeFilters(merge) == "!a:1..6 !a:9..9 b:2..3");
+
+    // attributes compare signed
+    Sphinx::SearchConfig_t negative;
+    negative.addRangeFilter("a", -10, -1, true);
+    negative.addRangeFilter("a", -5, 3, true);
+    negative.addRangeFilter("b", -5, 3);
+    negative.addRangeFilter("b", -10, -1);
+    CHECK(describeFilters(negative) == "!a:-10..3 b:-10..-1 b:-5..3");
+
+    Sphinx::SearchConfig_t aroundZero;
+    Sphinx::Int64Array_t values = enumValues(1, -1);
+    values.push_back(0);
+    aroundZero.addEnumFilter("a", values);
+    CHECK(describeFilters(aroundZero) == "a:-1..1");
+
+    // INT64_MAX and INT64_MIN are not neighbours, except for unsigned @id
+    const uint64_t top = (uint64_t(1) << 63) - 1;
+    Sphinx::SearchConfig_t sign;
+    sign.addEnumFilter("a", enumValues(top, top + 1));
+    sign.addEnumFilter("@id", enumValues(top, top + 1));
+    std::ostringstream expected;
+    expected << "@id:" << int64_t(top) << ".." << int64_t(top + 1)
+             << " a:{" << int64_t(top) << "," << int64_t(top + 1) << "}";
+    CHECK(describeFilters(sign) == expected.str());
+}//konec fce
+
+static void testBulkDecode()
+{
+    // big endian source at odd offset, every length around vector widths
+    unsigned char buffer[8 * 70 + 1];
+    for (size_t i = 0; i < sizeof(buffer); ++i) buffer[i] = i * 7 + 1;
+    const unsigned char *src = buffer + 1;
+
+    static const char *names[] = {"scalar", "ssse3", "avx2"};
+    for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); ++n) {
+        if (!Sphinx::setBulkDecodeImplementation(names[n])) continue;
+        for (size_t count = 0; count <= 70; ++count) {
+            uint32_t v32[70];
+            uint64_t v64[70];
+            Sphinx::decodeNetwork32(v32, src, count);
+            Sphinx::decodeNetwork64(v64, src, count);
+            for (size_t i = 0; i < count; ++i) {
+                const unsigned char *p = src + 4 * i;
+                CHECK(v32[i] == (uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16
+                                 | uint32_t(p[2]) << 8 | p[3]));
+                uint64_t expected = 0;
+                for (int b = 0; b < 8; ++b)
+                    expected = expected << 8 | src[8 * i + b];
+                CHECK(v64[i] == expected);
+            }
+        }
+    }
+    Sphinx::setBulkDecodeImplementation(0);
+
+    // appended arrays read back equal to values appended one by one
+    for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); ++n) {
+        if (!Sphinx::setBulkDecodeImplementation(names[n])) continue;
+        uint64_t v64[37];
+        for (size_t i = 0; i < 37; ++i) v64[i] = 0x0102030405060708ULL * i;
+        Sphinx::Query_t bulk, single;
+        bulk.convertEndian = single.convertEndian = true;
+        bulk << uint32_t(1);
+        bulk.appendArray(v64, 37);
+        single << uint32_t(1);
+        for (size_t i = 0; i < 37; ++i) single << v64[i];
+        CHECK(bulk.getLength() == single.getLength()
+              && !memcmp(bulk.data, single.data, bulk.getLength()));
+    }
+    Sphinx::setBulkDecodeImplementation(0);
+
+    Sphinx::IntArray_t ints;
+    for (uint32_t i = 0; i < 300; ++i) ints.push_back(i * 3);
+    Sphinx::SharedEnumFilter_t shared(ints);
+    Sphinx::Int64Array_t wide = shared.getValues();
+    CHECK(wide.size() == 300 && wide[0] == 0 && wide[299] == 897);
+
+    // short data is not read
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    data << uint32_t(1) << uint32_t(2) << uint32_t(3);
+    uint32_t values[4] = {0, 0, 0, 0};
+    CHECK(!data.read(values, 4));
+    CHECK(values[0] == 0 && data.getLength() == 12);
+    CHECK(!!data.read(values, 3));
+    CHECK(values[0] == 1 && values[2] == 3 && data.getLength() == 0);
+
+    // array value copies keep the array
+    Sphinx::Value_t mva(values, 3, 0);
+    Sphinx::Value_t copy(mva);
+    size_t count;
+    const uint32_t *array = copy.getUInt32Array(count);
+    CHECK(array && count == 3 && array != mva.getUInt32Array(count));
+    CHECK(!copy.getUInt64Array(count) && count == 0);
+    const std::vector<Sphinx::Value_t> &view = copy;
+    CHECK(view.size() == 3 && (uint32_t)view[1] == 2);
+
+    // sizes beyond unsigned int are refused, not wrapped
+    int refused = 0;
+    try {
+        data.reserve(~0U - 8);
+    } catch (const Sphinx::ClientUsageError_t &) {
+        ++refused;
+    }
+    try {
+        data.appendArray(values, ~0U / 4 + 1);
+    } catch (const Sphinx::ClientUsageError_t &) {
+        ++refused;
+    }
+    try {
+        data.appendArray(reinterpret_cast<const uint64_t *>(values),
+                         ~0U / 8 + 1);
+    } catch (const Sphinx::ClientUsageError_t &) {
+        ++refused;
+    }
+    CHECK(refused == 3 && data.getLength() == 0);
+}//konec fce
+
+/// reference result of set operation by std algorithms
+static Sphinx::Int64Array_t expectedIds(const Sphinx::Int64Array_t &a,
+                                        const Sphinx::Int64Array_t &b,
+                                        int operation)
+{
+    Sphinx::Int64Array_t out;
+    if (operation == 0)
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                              std::back_inserter(out));
+    else if (operation == 1)
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                       std::back_inserter(out));
+    else
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                            std::back_inserter(out));
+    return out;
+}//konec fce
+
+static void testDocumentIdSet()
+{
+    // unsorted input with duplicates
+    Sphinx::Int64Array_t raw;
+    raw.push_back(5);
+    raw.push_back(1);
+    raw.push_back(5);
+    raw.push_back(3);
+    Sphinx::DocumentIdSet_t set(raw);
+    CHECK(set.size() == 3 && set.getIds()[0] == 1 && set.getIds()[2] == 5);
+    CHECK(set.contains(3) && !set.contains(4));
+    CHECK(set.getFilter().getValues() == set.getIds());
+
+    // every kernel against std algorithms, sizes around block widths
+    // and far apart (galloping), densities giving few to many matches
+    static const char *names[] = {"scalar", "sse4.1", "avx2"};
+    static const size_t sizes[][2] = {{0, 5}, {1, 1}, {3, 7}, {9, 13},
+                                      {64, 61}, {200, 150}, {5, 1000},
+                                      {1000, 3}};
+    uint32_t seed = 1;
+    for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); ++n) {
+        if (!Sphinx::setIdSetImplementation(names[n])) continue;
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+            for (uint32_t spread = 1; spread <= 4; spread *= 2) {
+                Sphinx::Int64Array_t ids[2];
+                for (int k = 0; k < 2; ++k) {
+                    while (ids[k].size() < sizes[s][k]) {
+                        seed = seed * 1103515245 + 12345;
+                        ids[k].push_back((seed >> 8) % (spread * 1100)
+                                         + (uint64_t(1) << 40));
+                    }
+                }
+                Sphinx::DocumentIdSet_t a(ids[0]), b(ids[1]), result;
+                Sphinx::DocumentIdSet_t::intersect(a, b, result);
+                CHECK(result.getIds() == expectedIds(a.getIds(), b.getIds(), 0));
+                Sphinx::DocumentIdSet_t::unite(a, b, result);
+                CHECK(result.getIds() == expectedIds(a.getIds(), b.getIds(), 1));
+                Sphinx::DocumentIdSet_t::subtract(a, b, result);
+                CHECK(result.getIds() == expectedIds(a.getIds(), b.getIds(), 2));
+                Sphinx::DocumentIdSet_t::subtract(b, a, result);
+                CHECK(result.getIds() == expectedIds(b.getIds(), a.getIds(), 2));
+            }
+        }
+    }
+    Sphinx::setIdSetImplementation(0);
+
+    // result may be an operand
+    Sphinx::DocumentIdSet_t a(raw), b;
+    raw.assign(1, 3);
+    b.assign(raw);
+    Sphinx::DocumentIdSet_t::subtract(a, b, a);
+    CHECK(a.size() == 2 && !a.contains(3));
+    Sphinx::DocumentIdSet_t::unite(a, b, b);
+    CHECK(b.size() == 3 && b.contains(3));
+}//konec fce
+
+/// orders rows as sortRows() by a descending then b ascending
+struct RowOrder_t
+{
+    const std::vector<uint64_t> *a;
+    const std::vector<float> *b;
+
+    bool operator()(uint32_t x, uint32_t y) const
+    {
+        if ((*a)[x] != (*a)[y]) return (*a)[x] > (*a)[y];
+        return (*b)[x] < (*b)[y];
+    }
+};
+
+static void testResultKernels()
+{
+    // columns of response entries
+    Sphinx::Response_t response;
+    response.entry.resize(3);
+    for (uint32_t i = 0; i < 3; ++i) {
+        Sphinx::ResponseEntry_t &e = response.entry[i];
+        e.documentId = 10 - i;
+        e.weight = i;
+        e.attribute["gid"] = Sphinx::Value_t(uint32_t(i % 2));
+        e.attribute["price"] = Sphinx::Value_t(-1.5f * i);
+        e.attribute["name"] = Sphinx::Value_t(std::string("x"));
+    }
+    Sphinx::Column_t ids(response, "@id"), price(response, "price");
+    CHECK(ids.size() == 3 && ids.getUInt(2) == 8 && !ids.isFloat());
+    CHECK(price.isFloat() && price.getFloat(2) == -3.0f);
+    for (int i = 0; i < 2; ++i) {
+        bool thrown = false;
+        try {
+            Sphinx::Column_t wrong(response, i ? "name" : "nothing");
+        } catch (const Sphinx::ValueTypeError_t &) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    std::vector<uint32_t> rows;
+    Sphinx::selectAllRows(response.entry.size(), rows);
+    Sphinx::sortRows(Sphinx::SortKeys_t(1, Sphinx::SortKey_t(price)), rows);
+    CHECK(rows.size() == 3 && rows[0] == 2 && rows[2] == 0);
+
+    // random columns with many ties against std::stable_sort
+    std::vector<uint64_t> a;
+    std::vector<float> b;
+    uint32_t seed = 7;
+    for (size_t i = 0; i < 5000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        a.push_back((seed >> 8) % 20 + (i % 3 ? 0 : uint64_t(1) << 40));
+        b.push_back(float(int((seed >> 4) % 50) - 25) / 4);
+    }
+    Sphinx::Column_t columnA(a), columnB(b);
+    Sphinx::SortKeys_t keys;
+    keys.push_back(Sphinx::SortKey_t(columnA, true));
+    keys.push_back(Sphinx::SortKey_t(columnB));
+    RowOrder_t order = {&a, &b};
+
+    std::vector<uint32_t> expected;
+    Sphinx::selectAllRows(a.size(), expected);
+    std::stable_sort(expected.begin(), expected.end(), order);
+    Sphinx::selectAllRows(a.size(), rows);
+    Sphinx::sortRows(keys, rows);
+    CHECK(rows == expected);
+
+    std::vector<uint32_t> top;
+    Sphinx::selectAllRows(a.size(), rows);
+    Sphinx::topRows(keys, 100, rows, top);
+    CHECK(top.size() == 100
+          && std::equal(top.begin(), top.end(), expected.begin()));
+    Sphinx::topRows(keys, 10000, rows, top);
+    CHECK(top == expected);
+
+    // filters keep row order, run in place
+    std::vector<uint32_t> kept;
+    Sphinx::filterFloatRange(columnB, -1.0f, 0.0f, false, rows, kept);
+    size_t count = 0;
+    for (size_t i = 0; i < b.size(); ++i) {
+        if (b[i] < -1.0f || b[i] > 0.0f) continue;
+        CHECK(count < kept.size() && kept[count] == i);
+        ++count;
+    }
+    CHECK(count == kept.size());
+    Sphinx::filterRange(columnA, 5, 9, true, rows, rows);
+    for (size_t i = 0; i < rows.size(); ++i)
+        CHECK(a[rows[i]] < 5 || a[rows[i]] > 9);
+    CHECK(rows.size() == a.size() - (size_t)std::count_if(
+            a.begin(), a.end(), std::bind2nd(std::less<uint64_t>(), 10))
+          + (size_t)std::count_if(
+            a.begin(), a.end(), std::bind2nd(std::less<uint64_t>(), 5)));
+    bool thrown = false;
+    try {
+        Sphinx::filterRange(columnB, 0, 1, false, rows, kept);
+    } catch (const Sphinx::ValueTypeError_t &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    // groups against std::map
+    std::map<uint64_t, std::pair<uint32_t, double> > reference;
+    for (size_t i = 0; i < a.size(); ++i) {
+        ++reference[a[i]].first;
+        reference[a[i]].second += b[i];
+    }
+    std::vector<Sphinx::Group_t> groups;
+    Sphinx::selectAllRows(a.size(), rows);
+    Sphinx::groupRows(columnA, &columnB, rows, groups);
+    CHECK(groups.size() == reference.size());
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const std::pair<uint32_t, double> &r
+            = reference[a[groups[g].firstRow]];
+        CHECK(groups[g].count == r.first && groups[g].sum == r.second);
+        if (g) CHECK(groups[g].firstRow > groups[g - 1].firstRow);
+    }
+}//konec fce
+
+static void testDecodePlan()
+{
+    // fixed run, string, fixed run, duplicate name (the first one wins,
+    // as map insert of the original decoder did)
+    Sphinx::AttributeTypes_t schema;
+    schema.push_back(std::make_pair(std::string("b"),
+                                    (uint32_t)Sphinx::SPH_ATTR_BIGINT));
+    schema.push_back(std::make_pair(std::string("s"),
+                                    (uint32_t)Sphinx::SPH_ATTR_STRING));
+    schema.push_back(std::make_pair(std::string("f"),
+                                    (uint32_t)Sphinx::SPH_ATTR_FLOAT));
+    schema.push_back(std::make_pair(std::string("a"),
+                                    (uint32_t)Sphinx::SPH_ATTR_INTEGER));
+    schema.push_back(std::make_pair(std::string("b"),
+                                    (uint32_t)Sphinx::SPH_ATTR_INTEGER));
+    Sphinx::DecodePlan_t plan(schema, true);
+    CHECK(plan.getMinRowSize() == 8 + 4 + 8 + 4 + 4 + 4 + 4);
+
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    data << uint64_t(42) << uint32_t(7) << uint64_t(1) << std::string("xy")
+         << 1.5f << uint32_t(3) << uint32_t(4);
+    Sphinx::DecodeScratch_t scratch(0);
+    Sphinx::ResponseEntry_t entry;
+    plan.decodeRow(data, scratch, entry);
+    CHECK(entry.documentId == 42 && entry.weight == 7);
+    CHECK(entry.attribute.size() == 4 && data.getLength() == 0);
+    CHECK((std::string)entry.attribute["s"] == "xy");
+    CHECK((float)entry.attribute["f"] == 1.5f);
+    CHECK((uint32_t)entry.attribute["a"] == 3);
+    CHECK((uint64_t)entry.attribute["b"] == 1);
+
+    // projection steps over the others, reused entry drops them
+    std::vector<std::string> projection(1, "f");
+    Sphinx::DecodePlan_t projected(schema, true, &projection);
+    data.dataStartPtr = 0;
+    projected.decodeRow(data, scratch, entry);
+    CHECK(entry.attribute.size() == 1 && data.getLength() == 0);
+    CHECK((float)entry.attribute["f"] == 1.5f);
+
+    // row cut inside the second fixed run
+    data.clear();
+    data << uint64_t(42) << uint32_t(7) << uint64_t(1) << std::string("xy")
+         << 1.5f << uint32_t(3);
+    bool thrown = false;
+    try {
+        Sphinx::ResponseEntry_t cut;
+        plan.decodeRow(data, scratch, cut);
+    } catch (const Sphinx::MessageError_t &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}//konec fce
+
+static void run(const char *name, const Sphinx::ConnectionConfig_t &cfg,
+                Sphinx::SearchdEmulator_t &emu)
+{
+    printf("%s\n", name);
+    try {
+        testSearch(cfg, emu);
+        testReuse(cfg, emu);
+        testProjection(cfg, emu);
+        testRowBinding(cfg, emu);
+        testDocumentIds(cfg, emu);
+        testMultiQuery(cfg, emu);
+        testPlanGroups(cfg, emu);
+        testCompletion(cfg);
+        testUpdateKeywords(cfg, emu);
+        testFaults(cfg, emu);
+        testMetrics(cfg);
+        testObserver(cfg, emu);
+        testSlowLog(cfg, emu);
+        testCapture(cfg, emu);
+    } catch (const Sphinx::Error_t &e) {
+        printf("  FAILED: unexpected error: %s\n", e.errMsg.c_str());
+        ++failures;
+    } catch (const Sphinx::Warning_t &e) {
+        printf("  FAILED: unexpected warning: %s\n", e.errMsg.c_str());
+        ++failures;
+    }
+}//konec fce
+
+int main(int argc, char *argv[])
+{
+    printf("bulk decode (%s)\n", Sphinx::getBulkDecodeImplementation());
+    printf("id set kernels (%s)\n", Sphinx::getIdSetImplementation());
+    testBulkDecode();
+    testSharedValue();
+    testRecordWriterFlush();
+    testSearchConfigCopy();
+    testNormalizeFilters();
+    testDecodePlan();
+    testSchemaCache();
+    testDocumentIdSet();
+    testResultKernels();
+
+    {
+        Sphinx::SearchdEmulator_t emu;
+        emu.listenTcp();
+        emu.start();
+        Sphinx::ConnectionConfig_t cfg("127.0.0.1", emu.getPort(), false,
+                                       1000, 500, 500, 0);
+        run("tcp loopback", cfg, emu);
+        emu.stop();
+    }
+
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/sphinxemu-%d.sock", (int)getpid());
+        Sphinx::SearchdEmulator_t emu;
+        emu.listenUnix(path);
+        emu.start();
+        Sphinx::ConnectionConfig_t cfg(std::string("unix://") + path, 0,
+                                       false, 1000, 500, 500, 0);
+        run("unix socket", cfg, emu);
+        emu.stop();
+    }
+
+    if (failures) {
+        printf("%d check(s) failed.\n", failures);
+        return 1;
+    }
+    printf("all tests passed.\n");
+    return 0;
+}//main
@@ -0,0 +1,821 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Microbenchmarks of serialization, parsing and value handling.
+ * Output is one tab separated line per benchmark:
+ *   name  iterations  ns_per_op  bytes_per_op
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iterator>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/sphinxclientquery.h>
+
+#include "timer.h"
+#include "searchdemulator.h"
+#include "bulkdecode.h"
+#include "idsetkernels.h"
+#include "parallelparse.h"
+
+//------------------------------------------------------------------------------
+// query version handlers declarations (not part of public interface)
+//------------------------------------------------------------------------------
+
+void buildQuery_v0_9_9(const std::string &, const Sphinx::SearchConfig_t &,
+                       Sphinx::Query_t &);
+
+void parseResponse_v0_9_8(Sphinx::Query_t &, Sphinx::Response_t &,
+                          const std::vector<std::string> *,
+                          Sphinx::RowSink_t *);
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+/** @brief benchmark run context
+ *
+ * Benchmark does its setup, then runs the measured loop between
+ * start() and stop(). bytes is the amount of data processed by one
+ * operation (0 if meaningless).
+ */
+struct Context_t {
+    Context_t() : bytes(0) {}
+
+    void start() { ferTimerStart(&timer); }
+    void stop() { ferTimerStop(&timer); }
+    unsigned long elapsedNs() const { return ferTimerElapsedInNs(&timer); }
+
+    fer_timer_t timer;
+    unsigned long bytes;
+};
+
+typedef void (*BenchFn_t)(unsigned long iterations, Context_t &ctx);
+
+struct Bench_t {
+    std::string name;
+    BenchFn_t fn;
+    /// parameter of parametrized benchmark
+    unsigned long param;
+};
+
+/// parameter of currently running benchmark
+unsigned long benchParam = 0;
+
+/// keeps the compiler from removing measured code
+volatile unsigned long sink = 0;
+
+//------------------------------------------------------------------------------
+
+Sphinx::SearchConfig_t filterConfig(unsigned long values, bool shared)
+{
+    Sphinx::SearchConfig_t config;
+    config.setMaxMatches(1000);
+    config.setSorting(Sphinx::SPH_SORT_EXTENDED, "@weight DESC, gid ASC");
+    config.addRangeFilter("gid", 10, 20);
+
+    Sphinx::Int64Array_t ids;
+    for (unsigned long i = 0; i < values; ++i) ids.push_back(i * 7 + 3);
+    if (shared) config.addEnumFilter("id", Sphinx::SharedEnumFilter_t(ids));
+    else config.addEnumFilter("id", ids);
+    return config;
+}//konec fce
+
+void benchBuildQuery(unsigned long iterations, Context_t &ctx, bool shared)
+{
+    Sphinx::SearchConfig_t config = filterConfig(benchParam, shared);
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.clear();
+        buildQuery_v0_9_9("hello world", config, data);
+    }
+    ctx.stop();
+    ctx.bytes = data.getLength();
+}//konec fce
+
+void benchBuildQueryEnum(unsigned long iterations, Context_t &ctx)
+{
+    benchBuildQuery(iterations, ctx, false);
+}//konec fce
+
+void benchBuildQueryShared(unsigned long iterations, Context_t &ctx)
+{
+    benchBuildQuery(iterations, ctx, true);
+}//konec fce
+
+/// serialization of benchParam enum filter values
+void benchEnumAssign(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::Int64Array_t ids;
+    for (unsigned long i = 0; i < benchParam; ++i) ids.push_back(i * 7 + 3);
+    ctx.bytes = ids.size() * sizeof(uint64_t);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        Sphinx::SharedEnumFilter_t filter(ids);
+        sink += filter.size();
+    }
+    ctx.stop();
+}//konec fce
+
+/// query with benchParam attribute overrides
+void benchBuildQueryOverrides(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::SearchConfig_t config;
+    std::map<uint64_t, Sphinx::Value_t> values;
+    for (unsigned long i = 0; i < benchParam; ++i)
+        values[i * 7 + 3] = Sphinx::Value_t((uint32_t)i);
+    config.addAttributeOverride("gid", Sphinx::SPH_ATTR_INTEGER, values);
+    unsigned int length = 0;
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        Sphinx::Query_t data(1024);
+        data.convertEndian = true;
+        buildQuery_v0_9_9("hello world", config, data);
+        length = data.getLength();
+        sink += length;
+    }
+    ctx.stop();
+    ctx.bytes = length;
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+/// response attribute mix, index is benchParam
+Sphinx::EmulatorResponse_t responseShape(unsigned long mix)
+{
+    static const uint32_t types[] = {
+        Sphinx::SPH_ATTR_INTEGER, Sphinx::SPH_ATTR_BIGINT,
+        Sphinx::SPH_ATTR_FLOAT, Sphinx::SPH_ATTR_STRING,
+        Sphinx::SPH_ATTR_MULTI, Sphinx::SPH_ATTR_MULTI64
+    };
+    static const char *names[] = {"a_uint", "a_bigint", "a_float",
+                                  "a_string", "a_mva32", "a_mva64"};
+    const size_t typeCount = sizeof(types) / sizeof(types[0]);
+
+    Sphinx::EmulatorResponse_t shape;
+    shape.matchCount = 100;
+    shape.mvaSize = 8;
+    shape.stringSize = 32;
+    shape.attributes.clear();
+    for (size_t t = 0; t < typeCount; ++t) {
+        // one attribute type, or all of them (mix == typeCount)
+        if (mix != t && mix != typeCount) continue;
+        for (int i = 0; i < 4; ++i) {
+            char name[32];
+            snprintf(name, sizeof(name), "%s%d", names[t], i);
+            shape.attributes.push_back(std::make_pair(std::string(name),
+                                                      types[t]));
+        }
+    }
+    return shape;
+}//konec fce
+
+void benchParse(unsigned long iterations, Context_t &ctx, bool arena)
+{
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    Sphinx::SearchdEmulator_t::buildSearchResponse(responseShape(benchParam),
+                                                   1, data);
+    Sphinx::Response_t response;
+    response.useArena = arena;
+    ctx.bytes = data.getLength();
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.dataStartPtr = 0;
+        parseResponse_v0_9_8(data, response, 0, 0);
+    }
+    ctx.stop();
+    sink += response.entry.size();
+}//konec fce
+
+/// mixed response decoding two of its 24 attributes
+void benchParseProjected(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    Sphinx::SearchdEmulator_t::buildSearchResponse(responseShape(6), 1, data);
+    std::vector<std::string> projection;
+    projection.push_back("a_uint0");
+    projection.push_back("a_string0");
+    Sphinx::Response_t response;
+    ctx.bytes = data.getLength();
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.dataStartPtr = 0;
+        parseResponse_v0_9_8(data, response, &projection, 0);
+    }
+    ctx.stop();
+    sink += response.entry.size();
+}//konec fce
+
+/// row bound to the uint response of responseShape()
+struct UIntRow_t
+{
+    uint64_t id;
+    uint32_t a0, a1, a2, a3;
+};
+
+/// uint response decoded into bound rows (compare parse_response/uint)
+void benchParseRows(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    Sphinx::SearchdEmulator_t::buildSearchResponse(responseShape(0), 1, data);
+    Sphinx::RowBinding_t<UIntRow_t> binding;
+    binding.bindDocumentId(&UIntRow_t::id);
+    binding.bind("a_uint0", &UIntRow_t::a0).bind("a_uint1", &UIntRow_t::a1)
+           .bind("a_uint2", &UIntRow_t::a2).bind("a_uint3", &UIntRow_t::a3);
+    std::vector<UIntRow_t> rows;
+    Sphinx::RowVector_t<UIntRow_t> target(binding, rows);
+    Sphinx::Response_t response;
+    ctx.bytes = data.getLength();
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.dataStartPtr = 0;
+        parseResponse_v0_9_8(data, response, 0, &target);
+    }
+    ctx.stop();
+    sink += rows.size();
+}//konec fce
+
+/// MVA heavy response, benchParam values per MVA
+void benchParseWideMva(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::EmulatorResponse_t shape = responseShape(4);
+    shape.mvaSize = benchParam;
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    Sphinx::SearchdEmulator_t::buildSearchResponse(shape, 1, data);
+    Sphinx::Response_t response;
+    response.useArena = true;
+    ctx.bytes = data.getLength();
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.dataStartPtr = 0;
+        parseResponse_v0_9_8(data, response, 0, 0);
+    }
+    ctx.stop();
+    sink += response.entry.size();
+}//konec fce
+
+void benchParseHeap(unsigned long iterations, Context_t &ctx)
+{
+    benchParse(iterations, ctx, false);
+}//konec fce
+
+void benchParseArena(unsigned long iterations, Context_t &ctx)
+{
+    benchParse(iterations, ctx, true);
+}//konec fce
+
+/// multi-query of 20 mixed responses, benchParam decoding threads
+void benchParseMulti(unsigned long iterations, Context_t &ctx)
+{
+    const size_t queryCount = 20;
+    Sphinx::EmulatorResponse_t shape = responseShape(6);
+    shape.matchCount = 1000;
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    Sphinx::SearchdEmulator_t::buildSearchResponse(shape, queryCount, data);
+    Sphinx::QueryStats_t stats;
+    ctx.bytes = data.getLength();
+
+    // responses decoded over, as Client_t does with the caller's vector
+    std::vector<Sphinx::Response_t> responses(queryCount);
+    std::vector<Sphinx::Response_t *> targets(queryCount);
+    for (size_t q = 0; q < queryCount; ++q) targets[q] = &responses[q];
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.dataStartPtr = 0;
+        Sphinx::ResponseParser_t parser(data, queryCount,
+                                        Sphinx::VER_COMMAND_SEARCH_0_9_9,
+                                        stats, benchParam, &targets[0]);
+        for (size_t q = 0; q < queryCount; ++q) parser.next();
+        sink += responses.back().entry.size();
+    }
+    ctx.stop();
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+/// bulk decode implementation, index is benchParam
+const char *bulkImplementations[] = {"scalar", "ssse3", "avx2"};
+
+void benchBulkDecode(unsigned long iterations, Context_t &ctx, bool wide)
+{
+    const size_t count = 1024;
+    std::vector<unsigned char> src(count * 8 + 1, 0x5a);
+    std::vector<uint64_t> dst(count);
+    if (!Sphinx::setBulkDecodeImplementation(bulkImplementations[benchParam])) {
+        // CPU lacks the instructions, report scalar
+        Sphinx::setBulkDecodeImplementation("scalar");
+    }
+    ctx.bytes = count * (wide ? 8 : 4);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        if (wide) Sphinx::decodeNetwork64(&dst[0], &src[1], count);
+        else Sphinx::decodeNetwork32((uint32_t *)&dst[0], &src[1], count);
+    }
+    ctx.stop();
+    sink += dst[count / 2];
+    Sphinx::setBulkDecodeImplementation(0);
+}//konec fce
+
+void benchBulkDecode32(unsigned long iterations, Context_t &ctx)
+{
+    benchBulkDecode(iterations, ctx, false);
+}//konec fce
+
+void benchBulkDecode64(unsigned long iterations, Context_t &ctx)
+{
+    benchBulkDecode(iterations, ctx, true);
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+/// id set kernel implementation, index is benchParam
+const char *idSetImplementations[] = {"scalar", "sse4.1", "avx2"};
+
+/// two sets of 100000 ids, every other id of b is in a
+void sampleIdSets(Sphinx::DocumentIdSet_t &a, Sphinx::DocumentIdSet_t &b)
+{
+    Sphinx::Int64Array_t ids[2];
+    for (uint64_t i = 0; i < 100000; ++i) {
+        ids[0].push_back(i * 4);
+        ids[1].push_back(i * 8 + (i % 2 ? 1 : 0));
+    }
+    a.assign(ids[0]);
+    b.assign(ids[1]);
+}//konec fce
+
+void benchIdSet(unsigned long iterations, Context_t &ctx, bool subtract)
+{
+    Sphinx::DocumentIdSet_t a, b, result;
+    sampleIdSets(a, b);
+    if (!Sphinx::setIdSetImplementation(idSetImplementations[benchParam])) {
+        // CPU lacks the instructions, report scalar
+        Sphinx::setIdSetImplementation("scalar");
+    }
+    ctx.bytes = (a.size() + b.size()) * sizeof(uint64_t);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        if (subtract) Sphinx::DocumentIdSet_t::subtract(a, b, result);
+        else Sphinx::DocumentIdSet_t::intersect(a, b, result);
+    }
+    ctx.stop();
+    sink += result.size();
+    Sphinx::setIdSetImplementation(0);
+}//konec fce
+
+void benchIdSetIntersect(unsigned long iterations, Context_t &ctx)
+{
+    benchIdSet(iterations, ctx, false);
+}//konec fce
+
+void benchIdSetSubtract(unsigned long iterations, Context_t &ctx)
+{
+    benchIdSet(iterations, ctx, true);
+}//konec fce
+
+void benchIdSetUnite(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::DocumentIdSet_t a, b, result;
+    sampleIdSets(a, b);
+    ctx.bytes = (a.size() + b.size()) * sizeof(uint64_t);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i)
+        Sphinx::DocumentIdSet_t::unite(a, b, result);
+    ctx.stop();
+    sink += result.size();
+}//konec fce
+
+/// intersection of std::set as applications do it without DocumentIdSet_t
+void benchIdSetStdSet(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::DocumentIdSet_t a, b;
+    sampleIdSets(a, b);
+    std::set<uint64_t> setA(a.getIds().begin(), a.getIds().end());
+    std::set<uint64_t> setB(b.getIds().begin(), b.getIds().end());
+    ctx.bytes = (a.size() + b.size()) * sizeof(uint64_t);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        std::set<uint64_t> result;
+        std::set_intersection(setA.begin(), setA.end(),
+                              setB.begin(), setB.end(),
+                              std::inserter(result, result.end()));
+        sink += result.size();
+    }
+    ctx.stop();
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+/// response of 100000 entries with integer "gid" and float "price"
+const Sphinx::Response_t &sampleRows()
+{
+    static Sphinx::Response_t response;
+    if (response.entry.empty()) {
+        response.entry.resize(100000);
+        uint32_t seed = 1;
+        for (size_t i = 0; i < response.entry.size(); ++i) {
+            seed = seed * 1103515245 + 12345;
+            Sphinx::ResponseEntry_t &e = response.entry[i];
+            e.documentId = i + 1;
+            e.weight = seed >> 20;
+            e.attribute["gid"] = Sphinx::Value_t(uint32_t(seed % 1000));
+            e.attribute["price"] = Sphinx::Value_t(float(seed >> 8) / 1000);
+        }
+    }
+    return response;
+}//konec fce
+
+/// post-processing kernel, index is benchParam
+enum RowKernel_t { ROWS_COLUMN, ROWS_SORT, ROWS_TOP, ROWS_FILTER, ROWS_GROUP };
+
+void benchRows(unsigned long iterations, Context_t &ctx)
+{
+    const Sphinx::Response_t &response = sampleRows();
+    Sphinx::Column_t gid(response, "gid"), price(response, "price");
+    Sphinx::SortKeys_t keys;
+    keys.push_back(Sphinx::SortKey_t(gid));
+    keys.push_back(Sphinx::SortKey_t(price, true));
+    std::vector<uint32_t> all, rows;
+    std::vector<Sphinx::Group_t> groups;
+    Sphinx::selectAllRows(response.entry.size(), all);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        switch (benchParam) {
+        case ROWS_COLUMN: {
+            Sphinx::Column_t column(response, "price");
+            sink += column.getKeys()[i % column.size()];
+            break;
+        }
+        case ROWS_SORT:
+            rows = all;
+            Sphinx::sortRows(keys, rows);
+            break;
+        case ROWS_TOP:
+            Sphinx::topRows(keys, 100, all, rows);
+            break;
+        case ROWS_FILTER:
+            Sphinx::filterFloatRange(price, 100, 2000, false, all, rows);
+            break;
+        case ROWS_GROUP:
+            Sphinx::groupRows(gid, &price, all, groups);
+            sink += groups.size();
+            break;
+        }
+    }
+    ctx.stop();
+    sink += rows.size();
+}//konec fce
+
+/// orders entries by gid, then by price descending
+struct EntryOrder_t
+{
+    bool operator()(const Sphinx::ResponseEntry_t *a,
+                    const Sphinx::ResponseEntry_t *b) const
+    {
+        uint32_t x = a->attribute.find("gid")->second;
+        uint32_t y = b->attribute.find("gid")->second;
+        if (x != y) return x < y;
+        return (float)a->attribute.find("price")->second
+            > (float)b->attribute.find("price")->second;
+    }
+};
+
+/// the same sort over entry maps, as applications do it without columns
+void benchRowsStlSort(unsigned long iterations, Context_t &ctx)
+{
+    const Sphinx::Response_t &response = sampleRows();
+    std::vector<const Sphinx::ResponseEntry_t *> entries;
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        entries.clear();
+        for (size_t e = 0; e < response.entry.size(); ++e)
+            entries.push_back(&response.entry[e]);
+        std::stable_sort(entries.begin(), entries.end(), EntryOrder_t());
+    }
+    ctx.stop();
+    sink += entries[0]->documentId;
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+Sphinx::Value_t sampleValue(unsigned long kind)
+{
+    switch (kind) {
+    case 0: return Sphinx::Value_t((uint32_t)42);
+    case 1: return Sphinx::Value_t(std::string(32, 'x'));
+    default: {
+        std::vector<Sphinx::Value_t> mva;
+        for (uint32_t i = 0; i < 16; ++i) mva.push_back(Sphinx::Value_t(i));
+        return Sphinx::Value_t(mva);
+    }
+    }
+}//konec fce
+
+void benchValueCopy(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::Value_t value = sampleValue(benchParam);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        Sphinx::Value_t copy(value);
+        sink += copy.getValueType();
+    }
+    ctx.stop();
+}//konec fce
+
+void benchValueConvert(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::Value_t value = sampleValue(benchParam);
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        switch (value.getValueType()) {
+        case Sphinx::VALUETYPE_UINT32:
+            sink += (uint32_t)value;
+            break;
+        case Sphinx::VALUETYPE_STRING:
+            sink += ((const std::string &)value).size();
+            break;
+        default: {
+            const std::vector<Sphinx::Value_t> &mva = value;
+            for (size_t j = 0; j < mva.size(); ++j) sink += (uint32_t)mva[j];
+            break;
+        }
+        }
+    }
+    ctx.stop();
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+void benchQueryAppend(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    std::string word("keyword");
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.clear();
+        for (uint32_t j = 0; j < 256; ++j)
+            data << j << (uint64_t)j << word;
+    }
+    ctx.stop();
+    ctx.bytes = data.getLength();
+}//konec fce
+
+void benchQueryExtract(unsigned long iterations, Context_t &ctx)
+{
+    Sphinx::Query_t data;
+    data.convertEndian = true;
+    std::string word("keyword");
+    for (uint32_t j = 0; j < 256; ++j)
+        data << j << (uint64_t)j << word;
+    ctx.bytes = data.getLength();
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) {
+        data.dataStartPtr = 0;
+        uint32_t u32;
+        uint64_t u64;
+        std::string s;
+        for (uint32_t j = 0; j < 256; ++j) {
+            data >> u32 >> u64 >> s;
+            sink += u32;
+        }
+    }
+    ctx.stop();
+}//konec fce
+
+void benchEscape(unsigned long iterations, Context_t &ctx)
+{
+    std::string query("\"hello world\"~3 | (foo -bar) @title baz/2 ^start$ "
+                      "plain words without any special characters at all");
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i)
+        sink += Sphinx::escapeQueryString(query).size();
+    ctx.stop();
+    ctx.bytes = query.size();
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+void benchOptimise(unsigned long iterations, Context_t &ctx, size_t budget)
+{
+    Sphinx::MultiQueryOpt_t mq(Sphinx::VER_COMMAND_SEARCH_2_0_5);
+    mq.setConnectionBudget(budget);
+    for (unsigned long i = 0; i < benchParam; ++i) {
+        Sphinx::SearchConfig_t config;
+        config.addRangeFilter("gid", 0, i % 37);
+        config.setMaxMatches(100 + i % 1000);
+        mq.addQuery("query", config);
+    }
+
+    ctx.start();
+    for (unsigned long i = 0; i < iterations; ++i) mq.optimise();
+    ctx.stop();
+}//konec fce
+
+void benchOptimiseGroups(unsigned long iterations, Context_t &ctx)
+{
+    benchOptimise(iterations, ctx, 0);
+}//konec fce
+
+void benchOptimiseBudget(unsigned long iterations, Context_t &ctx)
+{
+    benchOptimise(iterations, ctx, 10);
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+void add(std::vector<Bench_t> &benches, const std::string &name,
+         BenchFn_t fn, unsigned long param = 0)
+{
+    Bench_t bench;
+    bench.name = name;
+    bench.fn = fn;
+    bench.param = param;
+    benches.push_back(bench);
+}//konec fce
+
+std::vector<Bench_t> allBenches()
+{
+    std::vector<Bench_t> b;
+    add(b, "build_query/filter_10", benchBuildQueryEnum, 10);
+    add(b, "build_query/filter_100000", benchBuildQueryEnum, 100000);
+    add(b, "build_query/shared_filter_100000", benchBuildQueryShared, 100000);
+    add(b, "build_query/overrides_10000", benchBuildQueryOverrides, 10000);
+    add(b, "enum_filter/assign_100000", benchEnumAssign, 100000);
+
+    static const char *mixes[] = {"uint", "bigint", "float", "string",
+                                  "mva32", "mva64", "mixed"};
+    for (unsigned long m = 0; m < sizeof(mixes) / sizeof(mixes[0]); ++m)
+        add(b, std::string("parse_response/") + mixes[m], benchParseHeap, m);
+    add(b, "parse_response/mixed_arena", benchParseArena, 6);
+    add(b, "parse_response/mixed_projected", benchParseProjected);
+    add(b, "parse_response/uint_rows", benchParseRows);
+    add(b, "parse_response/mva32_256", benchParseWideMva, 256);
+    add(b, "parse_multi/serial", benchParseMulti, 1);
+    add(b, "parse_multi/threads_2", benchParseMulti, 2);
+    add(b, "parse_multi/threads_4", benchParseMulti, 4);
+
+    for (unsigned long i = 0; i < 3; ++i) {
+        add(b, std::string("bulk_decode/32_") + bulkImplementations[i],
+            benchBulkDecode32, i);
+        add(b, std::string("bulk_decode/64_") + bulkImplementations[i],
+            benchBulkDecode64, i);
+    }
+
+    for (unsigned long i = 0; i < 3; ++i) {
+        add(b, std::string("id_set/intersect_") + idSetImplementations[i],
+            benchIdSetIntersect, i);
+        add(b, std::string("id_set/subtract_") + idSetImplementations[i],
+            benchIdSetSubtract, i);
+    }
+    add(b, "id_set/unite", benchIdSetUnite);
+    add(b, "id_set/intersect_std_set", benchIdSetStdSet);
+
+    add(b, "result_rows/column_100000", benchRows, ROWS_COLUMN);
+    add(b, "result_rows/sort_100000", benchRows, ROWS_SORT);
+    add(b, "result_rows/top_100_of_100000", benchRows, ROWS_TOP);
+    add(b, "result_rows/filter_100000", benchRows, ROWS_FILTER);
+    add(b, "result_rows/group_100000", benchRows, ROWS_GROUP);
+    add(b, "result_rows/stl_sort_100000", benchRowsStlSort);
+
+    static const char *values[] = {"uint32", "string", "mva"};
+    for (unsigned long v = 0; v < 3; ++v) {
+        add(b, std::string("value/copy_") + values[v], benchValueCopy, v);
+        add(b, std::string("value/convert_") + values[v],
+            benchValueConvert, v);
+    }
+
+    add(b, "query_t/append", benchQueryAppend);
+    add(b, "query_t/extract", benchQueryExtract);
+    add(b, "escape_query_string", benchEscape);
+
+    static const unsigned long sizes[] = {10, 100, 1000, 10000};
+    for (size_t s = 0; s < 4; ++s) {
+        char name[64];
+        snprintf(name, sizeof(name), "optimise/%lu", sizes[s]);
+        add(b, name, benchOptimiseGroups, sizes[s]);
+        snprintf(name, sizeof(name), "optimise_budget/%lu", sizes[s]);
+        add(b, name, benchOptimiseBudget, sizes[s]);
+    }
+    return b;
+}//konec fce
+
+}//namespace
+
+int main(int argc, char *argv[])
+{
+    // minimal measured time of one benchmark [ms]
+    unsigned long minTime = 200;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:h")) != -1) {
+        switch (opt) {
+        case 't': minTime = atol(optarg); break;
+        default:
+            fprintf(stderr, "Usage: %s [-t ms] [name-substring ...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Bench_t> benches = allBenches();
+
+    printf("# name\titerations\tns_per_op\tbytes_per_op\n");
+    for (std::vector<Bench_t>::const_iterator b = benches.begin();
+         b != benches.end(); ++b)
+    {
+        // run only selected benchmarks
+        bool selected = optind >= argc;
+        for (int i = optind; i < argc; ++i)
+            if (b->name.find(argv[i]) != std::string::npos) selected = true;
+        if (!selected) continue;
+
+        benchParam = b->param;
+
+        // grow iteration count until the run takes long enough
+        unsigned long iterations = 1;
+        Context_t ctx;
+        for (;;) {
+            b->fn(iterations, ctx);
+            unsigned long elapsed = ctx.elapsedNs();
+            if (elapsed >= minTime * 1000000UL) break;
+            // aim at 1.2x minimal time, at most 100x more iterations
+            unsigned long next = elapsed
+                ? (unsigned long)((double)iterations * minTime * 1.2e6
+                                  / elapsed)
+                : iterations * 100;
+            if (next > iterations * 100) next = iterations * 100;
+            if (next <= iterations) next = iterations + 1;
+            iterations = next;
+        }
+
+        printf("%s\t%lu\t%.1f\t%lu\n", b->name.c_str(), iterations,
+               (double)ctx.elapsedNs() / iterations, ctx.bytes);
+        fflush(stdout);
+    }
+    return 0;
+}//main
@@ -0,0 +1,159 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Standalone searchd emulator - serves synthetic responses until
+ * interrupted
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/error.h>
+
+#include "searchdemulator.h"
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -p port        listen on loopback TCP port (default 9312)\n"
+        "  -s path        listen on unix domain socket\n"
+        "  -m count       matches per response (default 20)\n"
+        "  -a attrs       attributes, comma separated name:type, type is\n"
+        "                 uint, float, bigint, mva, mva64 or string\n"
+        "  -v count       values per MVA attribute (default 4)\n"
+        "  -S length      length of string attributes (default 16)\n"
+        "  -l ms          latency before each response\n"
+        "  -t bytes:ms    trickle response by chunks with delay\n",
+        name);
+}//konec fce
+
+static bool parseAttributes(const std::string &spec,
+        std::vector<std::pair<std::string, uint32_t> > &attributes)
+{
+    attributes.clear();
+    std::string::size_type start = 0;
+    while (start < spec.size()) {
+        std::string::size_type end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string item(spec, start, end - start);
+        start = end + 1;
+
+        std::string::size_type colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        std::string name(item, 0, colon), type(item, colon + 1);
+
+        uint32_t t;
+        if (type == "uint") t = Sphinx::SPH_ATTR_INTEGER;
+        else if (type == "float") t = Sphinx::SPH_ATTR_FLOAT;
+        else if (type == "bigint") t = Sphinx::SPH_ATTR_BIGINT;
+        else if (type == "mva") t = Sphinx::SPH_ATTR_MULTI;
+        else if (type == "mva64") t = Sphinx::SPH_ATTR_MULTI64;
+        else if (type == "string") t = Sphinx::SPH_ATTR_STRING;
+        else return false;
+        attributes.push_back(std::make_pair(name, t));
+    }
+    return true;
+}//konec fce
+
+int main(int argc, char *argv[])
+{
+    unsigned short port = 9312;
+    std::string socketPath;
+    Sphinx::EmulatorResponse_t response;
+    Sphinx::EmulatorFaults_t faults;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:s:m:a:v:S:l:t:h")) != -1) {
+        switch (opt) {
+        case 'p': port = atoi(optarg); break;
+        case 's': socketPath = optarg; break;
+        case 'm': response.matchCount = atoi(optarg); break;
+        case 'a':
+            if (!parseAttributes(optarg, response.attributes)) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'v': response.mvaSize = atoi(optarg); break;
+        case 'S': response.stringSize = atoi(optarg); break;
+        case 'l': faults.latency = atoi(optarg); break;
+        case 't':
+            if (sscanf(optarg, "%u:%u", &faults.trickleChunk,
+                       &faults.trickleDelay) != 2)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // signals are handled by sigwait below, block them in all threads
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, 0);
+
+    try {
+        Sphinx::SearchdEmulator_t emulator;
+        if (socketPath.empty()) emulator.listenTcp(port);
+        else emulator.listenUnix(socketPath);
+        emulator.setResponse(response);
+        emulator.setFaults(faults);
+        emulator.start();
+
+        if (socketPath.empty())
+            printf("listening on 127.0.0.1:%u\n", emulator.getPort());
+        else printf("listening on unix://%s\n", socketPath.c_str());
+        fflush(stdout);
+
+        int sig;
+        sigwait(&signals, &sig);
+        emulator.stop();
+    } catch (const Sphinx::Error_t &e) {
+        fprintf(stderr, "error: %s\n", e.errMsg.c_str());
+        return 2;
+    }
+    return 0;
+}//main
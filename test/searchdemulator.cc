@@ -0,0 +1,607 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Sphinx::SearchdEmulator_t function definitions
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include "searchdemulator.h"
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/error.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <ctype.h>
+
+namespace {
+
+/// protocol version sent in handshake
+const uint32_t EMULATOR_PROTOCOL_VERSION = 1;
+/// response version sent in response header
+const uint16_t EMULATOR_RESPONSE_VERSION = 0x119;
+/// requests bigger than this are refused
+const uint32_t EMULATOR_MAX_REQUEST = 64 * 1024 * 1024;
+
+void sleepMs(uint32_t ms)
+{
+    if (!ms) return;
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+}//konec fce
+
+/// reads exactly length bytes, returns false on EOF or error
+bool readAll(int fd, Sphinx::Query_t &data, uint32_t length)
+{
+    char buff[16384];
+    while (length) {
+        ssize_t ret = ::recv(fd, buff, length < sizeof(buff)
+                                       ? length : sizeof(buff), 0);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) return false;
+        data.append(buff, ret);
+        length -= ret;
+    }
+    return true;
+}//konec fce
+
+/// writes all bytes, returns false on error
+bool writeAll(int fd, const unsigned char *data, size_t length)
+{
+    while (length) {
+        ssize_t ret = ::send(fd, data, length, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret <= 0) return false;
+        data += ret;
+        length -= ret;
+    }
+    return true;
+}//konec fce
+
+/// closes socket so that peer gets RST instead of FIN
+void resetClose(int fd)
+{
+    struct linger l;
+    l.l_onoff = 1;
+    l.l_linger = 0;
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+    ::close(fd);
+}//konec fce
+
+}//namespace
+
+//-----------------------------------------------------------------------------
+
+Sphinx::EmulatorResponse_t::EmulatorResponse_t()
+    : matchCount(20), totalFound(1000), use64bitId(true), mvaSize(4),
+      stringSize(16), queryStatus(SEARCHD_OK), updatedCount(-1)
+{
+    fields.push_back("title");
+    fields.push_back("body");
+    attributes.push_back(std::make_pair(std::string("gid"),
+                                        (uint32_t)SPH_ATTR_INTEGER));
+    attributes.push_back(std::make_pair(std::string("price"),
+                                        (uint32_t)SPH_ATTR_FLOAT));
+    attributes.push_back(std::make_pair(std::string("bid"),
+                                        (uint32_t)SPH_ATTR_BIGINT));
+    attributes.push_back(std::make_pair(std::string("tags"),
+                                        (uint32_t)SPH_ATTR_MULTI));
+    attributes.push_back(std::make_pair(std::string("name"),
+                                        (uint32_t)SPH_ATTR_STRING));
+    words.push_back("test");
+}//konec fce
+
+Sphinx::EmulatorFaults_t::EmulatorFaults_t()
+    : latency(0), trickleChunk(0), trickleDelay(0), reset(RESET_NONE),
+      responseStatus(SEARCHD_OK), every(0)
+{}//konec fce
+
+//-----------------------------------------------------------------------------
+
+struct Sphinx::SearchdEmulator_t::Connection_t
+{
+    SearchdEmulator_t *emulator;
+    int fd;
+};
+
+Sphinx::SearchdEmulator_t::SearchdEmulator_t()
+    : listenFd(-1), port(0), running(false),
+      requestCounts(SEARCHD_COMMAND_PERSIST + 1, 0), requestSeqNo(0),
+      connectionCount(0)
+{
+    wakeFd[0] = wakeFd[1] = -1;
+    pthread_mutex_init(&lock, 0);
+    pthread_cond_init(&finished, 0);
+    lastRequest.convertEndian = true;
+}//konec fce
+
+Sphinx::SearchdEmulator_t::~SearchdEmulator_t()
+{
+    stop();
+    if (listenFd >= 0) ::close(listenFd);
+    if (!unixPath.empty()) ::unlink(unixPath.c_str());
+    pthread_cond_destroy(&finished);
+    pthread_mutex_destroy(&lock);
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::listenTcp(unsigned short listenPort)
+{
+    listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        throw ConnectionError_t(strError("Unable to create socket"));
+
+    int one = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(listenPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (::bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || ::listen(listenFd, 128) < 0)
+    {
+        throw ConnectionError_t(strError("Unable to listen"));
+    }
+
+    socklen_t len = sizeof(addr);
+    if (::getsockname(listenFd, (struct sockaddr *)&addr, &len) < 0)
+        throw ConnectionError_t(strError("Unable to get socket name"));
+    port = ntohs(addr.sin_port);
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::listenUnix(const std::string &path)
+{
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path))
+        throw ConnectionError_t("Domain socket path length exceeded.");
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        throw ConnectionError_t(strError("Unable to create socket"));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    ::unlink(path.c_str());
+
+    if (::bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+        || ::listen(listenFd, 128) < 0)
+    {
+        throw ConnectionError_t(strError("Unable to listen"));
+    }
+    unixPath = path;
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::start()
+{
+    if (running) return;
+    if (listenFd < 0)
+        throw ClientUsageError_t("Emulator doesn't listen.");
+    if (::pipe(wakeFd) < 0)
+        throw ConnectionError_t(strError("Unable to create pipe"));
+    if (pthread_create(&thread, 0, acceptThread, this))
+        throw ConnectionError_t("Unable to create thread.");
+    running = true;
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::stop()
+{
+    if (!running) return;
+
+    // wake up and join the accept thread
+    char c = 0;
+    while (::write(wakeFd[1], &c, 1) < 0 && errno == EINTR);
+    pthread_join(thread, 0);
+    ::close(wakeFd[0]);
+    ::close(wakeFd[1]);
+    running = false;
+
+    // break active connections and wait for them
+    pthread_mutex_lock(&lock);
+    for (std::set<int>::const_iterator i = active.begin();
+         i != active.end(); ++i)
+    {
+        ::shutdown(*i, SHUT_RDWR);
+    }
+    while (!active.empty())
+        pthread_cond_wait(&finished, &lock);
+    pthread_mutex_unlock(&lock);
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::setResponse(const EmulatorResponse_t &r)
+{
+    pthread_mutex_lock(&lock);
+    response = r;
+    pthread_mutex_unlock(&lock);
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::setFaults(const EmulatorFaults_t &f)
+{
+    pthread_mutex_lock(&lock);
+    faults = f;
+    pthread_mutex_unlock(&lock);
+}//konec fce
+
+uint32_t Sphinx::SearchdEmulator_t::getRequestCount(Command_t command) const
+{
+    pthread_mutex_lock(&lock);
+    uint32_t count = (size_t)command < requestCounts.size()
+                     ? requestCounts[command] : 0;
+    pthread_mutex_unlock(&lock);
+    return count;
+}//konec fce
+
+uint32_t Sphinx::SearchdEmulator_t::getConnectionCount() const
+{
+    pthread_mutex_lock(&lock);
+    uint32_t count = connectionCount;
+    pthread_mutex_unlock(&lock);
+    return count;
+}//konec fce
+
+Sphinx::Query_t Sphinx::SearchdEmulator_t::getLastRequest() const
+{
+    pthread_mutex_lock(&lock);
+    Query_t request(lastRequest);
+    pthread_mutex_unlock(&lock);
+    return request;
+}//konec fce
+
+//-----------------------------------------------------------------------------
+
+void *Sphinx::SearchdEmulator_t::acceptThread(void *arg)
+{
+    SearchdEmulator_t *self = static_cast<SearchdEmulator_t *>(arg);
+
+    for (;;) {
+        struct pollfd fds[2];
+        fds[0].fd = self->listenFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = self->wakeFd[0];
+        fds[1].events = POLLIN;
+
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int fd = ::accept(self->listenFd, 0, 0);
+        if (fd < 0) continue;
+
+        pthread_mutex_lock(&self->lock);
+        self->active.insert(fd);
+        ++self->connectionCount;
+        pthread_mutex_unlock(&self->lock);
+
+        Connection_t *connection = new Connection_t;
+        connection->emulator = self;
+        connection->fd = fd;
+
+        pthread_t t;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&t, &attr, connectionThread, connection)) {
+            // no thread, run inline
+            connectionThread(connection);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    return 0;
+}//konec fce
+
+void *Sphinx::SearchdEmulator_t::connectionThread(void *arg)
+{
+    Connection_t *connection = static_cast<Connection_t *>(arg);
+    SearchdEmulator_t *self = connection->emulator;
+    int fd = connection->fd;
+    delete connection;
+
+    self->serve(fd);
+
+    pthread_mutex_lock(&self->lock);
+    self->active.erase(fd);
+    pthread_cond_broadcast(&self->finished);
+    pthread_mutex_unlock(&self->lock);
+    return 0;
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::serve(int fd)
+{
+    // reset on accept applies to connections, not requests
+    pthread_mutex_lock(&lock);
+    bool resetOnAccept = faults.reset == EmulatorFaults_t::RESET_ON_ACCEPT;
+    pthread_mutex_unlock(&lock);
+    if (resetOnAccept) {
+        resetClose(fd);
+        return;
+    }
+
+    // handshake - server sends its version first
+    Query_t version;
+    version.convertEndian = true;
+    version << EMULATOR_PROTOCOL_VERSION;
+    if (!writeAll(fd, version.data, version.getLength())) {
+        ::close(fd);
+        return;
+    }
+    version.clear();
+    if (!readAll(fd, version, 4)) {
+        ::close(fd);
+        return;
+    }
+
+    bool persistent = false;
+    do {
+        // request header
+        Query_t request;
+        request.convertEndian = true;
+        if (!readAll(fd, request, 8)) break;
+
+        uint16_t command, commandVersion;
+        uint32_t length;
+        request >> command >> commandVersion >> length;
+
+        // search command older than 0x119 is sent with length counting
+        // two 32bit words, but only query count is sent
+        if (command == SEARCHD_COMMAND_SEARCH
+            && commandVersion < VER_COMMAND_SEARCH_2_0_5 && length >= 4)
+        {
+            length -= 4;
+        }
+        if (length > EMULATOR_MAX_REQUEST) break;
+
+        request.clear();
+        if (!readAll(fd, request, length)) break;
+
+        // take snapshot of config, account the request
+        pthread_mutex_lock(&lock);
+        EmulatorResponse_t shape(response);
+        EmulatorFaults_t fault(faults);
+        if (command < requestCounts.size()) ++requestCounts[command];
+        uint32_t seqNo = ++requestSeqNo;
+        lastRequest = request;
+        pthread_mutex_unlock(&lock);
+
+        if (command == SEARCHD_COMMAND_PERSIST) {
+            // no response, connection is kept open
+            uint32_t flag = 0;
+            request >> flag;
+            persistent = flag;
+            continue;
+        }
+
+        bool faulty = fault.every <= 1 || seqNo % fault.every == 0;
+
+        if (faulty && fault.reset == EmulatorFaults_t::RESET_AFTER_REQUEST) {
+            resetClose(fd);
+            return;
+        }
+
+        // response body
+        uint16_t status = SEARCHD_OK;
+        Query_t body;
+        body.convertEndian = true;
+        if (faulty && fault.responseStatus != SEARCHD_OK) {
+            status = fault.responseStatus;
+            body << fault.statusMessage;
+        } else {
+            buildResponse(command, request, shape, status, body);
+        }
+
+        Query_t out;
+        out.convertEndian = true;
+        out << status << EMULATOR_RESPONSE_VERSION << body.getLength();
+        out << body;
+
+        sleepMs(fault.latency);
+
+        size_t length2send = out.getLength();
+        if (faulty && fault.reset == EmulatorFaults_t::RESET_MID_RESPONSE) {
+            writeAll(fd, out.data, length2send / 2);
+            resetClose(fd);
+            return;
+        }
+
+        bool ok = true;
+        if (fault.trickleChunk) {
+            for (size_t sent = 0; ok && sent < length2send;
+                 sent += fault.trickleChunk)
+            {
+                size_t chunk = length2send - sent;
+                if (chunk > fault.trickleChunk) chunk = fault.trickleChunk;
+                if (sent) sleepMs(fault.trickleDelay);
+                ok = writeAll(fd, out.data + sent, chunk);
+            }
+        } else {
+            ok = writeAll(fd, out.data, length2send);
+        }
+        if (!ok) break;
+    } while (persistent);
+
+    ::close(fd);
+}//konec fce
+
+bool Sphinx::SearchdEmulator_t::buildResponse(
+        uint16_t command, Query_t &request, const EmulatorResponse_t &shape,
+        uint16_t &status, Query_t &body)
+{
+    switch (command) {
+    case SEARCHD_COMMAND_SEARCH: {
+        // [uint32_t 0 (0x119 only)], uint32_t query count, queries
+        uint32_t first = 0, queryCount = 0;
+        request >> first;
+        if (request.getLength() >= 4 && !first) request >> queryCount;
+        else queryCount = first;
+        if (!queryCount) queryCount = 1;
+        buildSearchResponse(shape, queryCount, body);
+        return true;
+    }
+    case SEARCHD_COMMAND_UPDATE: {
+        // string index, uint32_t count {string attr}, uint32_t docs ...
+        std::string index;
+        uint32_t attrCount = 0, docCount = 0;
+        request >> index >> attrCount;
+        for (uint32_t i = 0; i < attrCount; ++i) {
+            std::string name;
+            request >> name;
+        }
+        request >> docCount;
+        body << (uint32_t)(shape.updatedCount < 0
+                           ? docCount : (uint32_t)shape.updatedCount);
+        return true;
+    }
+    case SEARCHD_COMMAND_KEYWORDS: {
+        // string query, string index, uint32_t hits
+        std::string query, index;
+        uint32_t hits = 0;
+        request >> query >> index >> hits;
+
+        std::vector<std::string> words;
+        std::string word;
+        for (std::string::const_iterator i = query.begin();
+             i != query.end(); ++i)
+        {
+            if (isspace(*i)) {
+                if (!word.empty()) words.push_back(word);
+                word.clear();
+            } else {
+                word += *i;
+            }
+        }
+        if (!word.empty()) words.push_back(word);
+
+        body << (uint32_t)words.size();
+        for (uint32_t i = 0; i < words.size(); ++i) {
+            std::string normalized(words[i]);
+            for (std::string::iterator c = normalized.begin();
+                 c != normalized.end(); ++c)
+            {
+                *c = tolower(*c);
+            }
+            body << words[i] << normalized;
+            if (hits) body << (uint32_t)(i + 1) << (uint32_t)(2 * i + 2);
+        }
+        return true;
+    }
+    default:
+        status = SEARCHD_ERROR;
+        body << std::string("unknown command");
+        return false;
+    }
+}//konec fce
+
+void Sphinx::SearchdEmulator_t::buildSearchResponse(
+        const EmulatorResponse_t &shape, uint32_t queryCount, Query_t &data)
+{
+    std::string stringValue;
+    for (uint32_t i = 0; i < shape.stringSize; ++i)
+        stringValue += (char)('a' + i % 26);
+
+    for (uint32_t q = 0; q < queryCount; ++q) {
+        data << shape.queryStatus;
+        if (shape.queryStatus != SEARCHD_OK) {
+            data << shape.queryMessage;
+            if (shape.queryStatus != SEARCHD_WARNING) continue;
+        }
+
+        // schema
+        data << (uint32_t)shape.fields.size();
+        for (size_t i = 0; i < shape.fields.size(); ++i)
+            data << shape.fields[i];
+        data << (uint32_t)shape.attributes.size();
+        for (size_t i = 0; i < shape.attributes.size(); ++i)
+            data << shape.attributes[i].first << shape.attributes[i].second;
+
+        // matches
+        data << shape.matchCount << (uint32_t)shape.use64bitId;
+        for (uint32_t m = 0; m < shape.matchCount; ++m) {
+            uint64_t docId = m + 1;
+            if (shape.use64bitId) data << docId;
+            else data << (uint32_t)docId;
+            data << (uint32_t)(shape.matchCount - m);
+
+            for (size_t a = 0; a < shape.attributes.size(); ++a) {
+                switch (shape.attributes[a].second) {
+                case SPH_ATTR_FLOAT:
+                    data << (float)docId / 2;
+                    break;
+                case SPH_ATTR_BIGINT:
+                    data << (docId << 32 | docId);
+                    break;
+                case SPH_ATTR_MULTI:
+                    data << shape.mvaSize;
+                    for (uint32_t v = 0; v < shape.mvaSize; ++v)
+                        data << (uint32_t)(docId + v);
+                    break;
+                case SPH_ATTR_MULTI64:
+                    // count of 32bit words
+                    data << 2 * shape.mvaSize;
+                    for (uint32_t v = 0; v < shape.mvaSize; ++v)
+                        data << ((docId << 32) + v);
+                    break;
+                case SPH_ATTR_STRING:
+                    data << stringValue;
+                    break;
+                default:
+                    data << (uint32_t)docId;
+                    break;
+                }
+            }
+        }
+
+        // totals
+        data << shape.matchCount << shape.totalFound << (uint32_t)1;
+
+        // word statistics
+        data << (uint32_t)shape.words.size();
+        for (size_t i = 0; i < shape.words.size(); ++i)
+            data << shape.words[i] << shape.totalFound
+                 << 2 * shape.totalFound;
+    }
+}//konec fce
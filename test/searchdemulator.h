@@ -0,0 +1,250 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * In-process searchd stand-in - speaks the searchd binary protocol and
+ * serves synthetic responses, used by tests and benchmarks
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+//! @file searchdemulator.h
+
+#ifndef __SPHINX_SEARCHDEMULATOR_H__
+#define __SPHINX_SEARCHDEMULATOR_H__
+
+#include <string>
+#include <vector>
+#include <set>
+#include <utility>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <sphinxclient/sphinxclientquery.h>
+#include <sphinxclient/globals.h>
+
+namespace Sphinx
+{
+
+/** @brief Shape of synthetic search response
+ *
+ * Every query of a (multi)query gets the same response. Document ids
+ * are 1..matchCount, attribute values are derived from the document id,
+ * so the client side can verify them.
+ */
+struct EmulatorResponse_t
+{
+    /// fields named "title" and "body", attributes "gid" (uint32),
+    /// "price" (float), "bid" (bigint), "tags" (MVA32) and "name" (string)
+    EmulatorResponse_t();
+
+    /// field names
+    std::vector<std::string> fields;
+    /// attribute names and types (AttributeType_t)
+    std::vector<std::pair<std::string, uint32_t> > attributes;
+    /// count of matches sent in each response
+    uint32_t matchCount;
+    /// total found reported
+    uint32_t totalFound;
+    /// send 64bit document ids
+    bool use64bitId;
+    /// values per multi-value attribute
+    uint32_t mvaSize;
+    /// length of string attributes
+    uint32_t stringSize;
+    /// words reported in word statistics
+    std::vector<std::string> words;
+    /// status of each query in search response (Status_t)
+    uint32_t queryStatus;
+    /// message sent with non-OK query status
+    std::string queryMessage;
+    /// count of documents reported as updated, -1 = all in request
+    int32_t updatedCount;
+};
+
+/** @brief Faults injected by emulator
+ */
+struct EmulatorFaults_t
+{
+    /// how is connection broken
+    enum Reset_t {
+        RESET_NONE = 0,          //!< @brief no reset
+        RESET_ON_ACCEPT = 1,     //!< @brief right after accept
+        RESET_AFTER_REQUEST = 2, //!< @brief request read, no response
+        RESET_MID_RESPONSE = 3   //!< @brief half of response sent
+    };
+
+    /// no faults
+    EmulatorFaults_t();
+
+    /// delay before response is sent [ms]
+    uint32_t latency;
+    /// when non zero, response is sent by chunks of this size
+    uint32_t trickleChunk;
+    /// delay between chunks [ms]
+    uint32_t trickleDelay;
+    /// connection reset mode
+    Reset_t reset;
+    /// status in response header (Status_t), non OK status sends
+    /// statusMessage as the only body
+    uint16_t responseStatus;
+    /// message sent with non OK response status
+    std::string statusMessage;
+    /// apply reset and status faults to every n-th request only
+    /// (counted from 1; 0 and 1 mean every request)
+    uint32_t every;
+};
+
+/** @brief searchd protocol emulator
+ *
+ * Listens on TCP loopback or unix domain socket and serves handshake,
+ * search (multiquery), update, keywords and persist commands from a
+ * background thread, one thread per connection. Responses are shaped by
+ * EmulatorResponse_t, faults are injected by EmulatorFaults_t. Both can
+ * be changed while the emulator runs, the change applies to requests
+ * read afterwards.
+ *
+ * Example:
+ * @code
+ * Sphinx::SearchdEmulator_t emu;
+ * emu.listenTcp();
+ * emu.start();
+ * Sphinx::ConnectionConfig_t cfg("127.0.0.1", emu.getPort());
+ * Sphinx::Client_t client(cfg);
+ * ...
+ * emu.stop();
+ * @endcode
+ */
+class SearchdEmulator_t
+{
+public:
+    SearchdEmulator_t();
+
+    //! @brief stops the emulator, closes sockets
+    ~SearchdEmulator_t();
+
+    /** @brief listen on loopback TCP port
+     *  @param port port to listen on, 0 picks a free one
+     *  @throws ConnectionError_t
+     */
+    void listenTcp(unsigned short port = 0);
+
+    /** @brief listen on unix domain socket (existing file is removed)
+     *  @param path path of the socket
+     *  @throws ConnectionError_t
+     */
+    void listenUnix(const std::string &path);
+
+    //! @brief starts serving in background thread
+    void start();
+
+    //! @brief stops serving, breaks active connections and waits for them
+    void stop();
+
+    //! @brief returns listening port (TCP only)
+    unsigned short getPort() const { return port; }
+
+    /// set response shape
+    void setResponse(const EmulatorResponse_t &response);
+    /// set injected faults
+    void setFaults(const EmulatorFaults_t &faults);
+
+    /// count of requests of given command received so far
+    uint32_t getRequestCount(Command_t command) const;
+    /// count of accepted connections
+    uint32_t getConnectionCount() const;
+    /// body of the last request received (without header)
+    Query_t getLastRequest() const;
+
+    /** @brief build search response body
+     *
+     * Builds the body of response for queryCount queries; useful for
+     * feeding the response parser without network.
+     *
+     * @param response response shape
+     * @param queryCount count of queries
+     * @param data output buffer
+     */
+    static void buildSearchResponse(const EmulatorResponse_t &response,
+                                    uint32_t queryCount, Query_t &data);
+
+private:
+    SearchdEmulator_t(const SearchdEmulator_t &);
+    SearchdEmulator_t &operator=(const SearchdEmulator_t &);
+
+    struct Connection_t;
+
+    static void *acceptThread(void *emulator);
+    static void *connectionThread(void *connection);
+
+    /// serve one connection
+    void serve(int fd);
+    /// build response for request, returns false if there is none
+    bool buildResponse(uint16_t command, Query_t &request,
+                       const EmulatorResponse_t &shape,
+                       uint16_t &status, Query_t &body);
+
+    /// listening socket
+    int listenFd;
+    /// pipe waking up accept thread
+    int wakeFd[2];
+    /// listening port
+    unsigned short port;
+    /// path of unix socket (removed at stop)
+    std::string unixPath;
+    /// accept thread
+    pthread_t thread;
+    /// accept thread is running
+    bool running;
+
+    /// guards everything below
+    mutable pthread_mutex_t lock;
+    /// signalled when a connection finishes
+    pthread_cond_t finished;
+    /// sockets of active connections
+    std::set<int> active;
+
+    EmulatorResponse_t response;
+    EmulatorFaults_t faults;
+
+    /// request counters per command
+    std::vector<uint32_t> requestCounts;
+    /// count of requests (for EmulatorFaults_t::every)
+    uint32_t requestSeqNo;
+    /// count of accepted connections
+    uint32_t connectionCount;
+    /// last request body
+    Query_t lastRequest;
+};
+
+}//namespace
+
+#endif
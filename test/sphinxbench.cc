@@ -0,0 +1,705 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Load generator - replays a query file against searchd (or in-process
+ * searchd emulator) and reports throughput and latency percentiles
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/sphinxclientquery.h>
+#include <sphinxclient/globals.h>
+#include <sphinxclient/error.h>
+
+#include "searchdemulator.h"
+
+//------------------------------------------------------------------------------
+// query version handlers declarations (not part of public interface)
+//------------------------------------------------------------------------------
+
+void buildHeader(Sphinx::Command_t, unsigned short, int, Sphinx::Query_t &,
+                 int queryCount=1);
+
+void parseResponseVersion(Sphinx::Query_t &, Sphinx::SearchCommandVersion_t,
+                          Sphinx::Response_t &,
+                          const std::vector<std::string> *,
+                          Sphinx::RowSink_t *);
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+uint64_t nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}//konec fce
+
+void sleepUntilUs(uint64_t when)
+{
+    for (;;) {
+        uint64_t now = nowUs();
+        if (now >= when) return;
+        struct timespec ts;
+        ts.tv_sec = (when - now) / 1000000;
+        ts.tv_nsec = ((when - now) % 1000000) * 1000;
+        nanosleep(&ts, 0);
+    }
+}//konec fce
+
+/** @brief Log-linear latency histogram (HDR style)
+ *
+ * Values below SUB are counted exactly, above that each power of two
+ * range is split into SUB/2 buckets, so the relative error is below
+ * 2/SUB (~3%). Recording is O(1), merging and percentiles O(buckets).
+ */
+class Histogram_t
+{
+public:
+    enum { SUB_BITS = 6, SUB = 1 << SUB_BITS, HALF = SUB / 2,
+           BUCKETS = SUB + (64 - SUB_BITS + 1) * HALF };
+
+    Histogram_t() : counts(BUCKETS, 0), count(0), sum(0), max(0) {}
+
+    void record(uint64_t value) {
+        ++counts[index(value)];
+        ++count;
+        sum += value;
+        if (value > max) max = value;
+    }
+
+    void merge(const Histogram_t &h) {
+        for (size_t i = 0; i < counts.size(); ++i) counts[i] += h.counts[i];
+        count += h.count;
+        sum += h.sum;
+        if (h.max > max) max = h.max;
+    }
+
+    uint64_t getCount() const { return count; }
+    uint64_t getMax() const { return max; }
+    double getMean() const { return count ? (double)sum / count : 0; }
+
+    /// value at percentile p (0-100), highest value of the bucket
+    uint64_t percentile(double p) const {
+        if (!count) return 0;
+        uint64_t target = (uint64_t)(p / 100.0 * count + 0.5);
+        if (target < 1) target = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                uint64_t high = lowest(i + 1) - 1;
+                return high < max ? high : max;
+            }
+        }
+        return max;
+    }
+
+private:
+    static size_t index(uint64_t v) {
+        if (v < SUB) return v;
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - SUB_BITS + 1;
+        return SUB + (shift - 1) * HALF + ((v >> shift) - HALF);
+    }
+
+    static uint64_t lowest(size_t i) {
+        if (i < SUB) return i;
+        size_t k = i - SUB;
+        int shift = k / HALF + 1;
+        return (uint64_t)(k % HALF + HALF) << shift;
+    }
+
+    std::vector<uint64_t> counts;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+};
+
+/// measured phases
+enum Phase_t {
+    PHASE_CONNECT = 0,
+    PHASE_HANDSHAKE,
+    PHASE_SERVER,
+    PHASE_TRANSFER,
+    PHASE_PARSE,
+    PHASE_SEARCHD,
+    PHASE_TOTAL,
+    PHASE_COUNT
+};
+
+const char *phaseNames[PHASE_COUNT] = {
+    "connect", "handshake", "server", "transfer", "parse",
+    "searchd", "total"
+};
+
+enum Mode_t { MODE_SINGLE, MODE_MULTI, MODE_OPT };
+
+/// benchmark configuration
+struct Options_t {
+    Options_t()
+        : host("localhost"), port(9312), index("*"), limit(20),
+          concurrency(1), requests(0), duration(10), qps(0),
+          mode(MODE_SINGLE), batch(8), reuse(false), timeout(3000),
+          emulator(false), emulatorLatency(0)
+    {}
+
+    std::string host;
+    unsigned short port;
+    std::string queryFile;
+    std::string index;
+    int limit;
+    int concurrency;
+    unsigned long requests;
+    unsigned long duration;
+    double qps;
+    Mode_t mode;
+    int batch;
+    bool reuse;
+    int timeout;
+    bool emulator;
+    uint32_t emulatorLatency;
+};
+
+/// one prepared request
+struct Request_t {
+    /// whole request with header (single and multi mode)
+    Sphinx::Query_t data;
+    /// count of queries in request
+    uint32_t queryCount;
+    /// optimised multiquery (opt mode)
+    Sphinx::MultiQueryOpt_t *mq;
+};
+
+/// shared state of all workers
+struct Shared_t {
+    const Options_t *options;
+    std::vector<Request_t> *requests;
+    Sphinx::ConnectionConfig_t *connection;
+    /// next request sequence number
+    unsigned long next;
+    /// benchmark start
+    uint64_t start;
+    /// benchmark end (duration mode)
+    uint64_t end;
+};
+
+/// per worker results
+struct Worker_t {
+    Worker_t() : shared(0), ok(0), warnings(0), errors(0), fd(-1) {}
+
+    Shared_t *shared;
+    pthread_t thread;
+    Histogram_t phases[PHASE_COUNT];
+    unsigned long ok;
+    unsigned long warnings;
+    unsigned long errors;
+    std::string lastError;
+    /// kept connection (reuse mode)
+    int fd;
+};
+
+//------------------------------------------------------------------------------
+// blocking connection with timeouts
+//------------------------------------------------------------------------------
+
+struct BenchError_t {
+    BenchError_t(const std::string &msg) : msg(msg) {}
+    std::string msg;
+};
+
+void waitFor(int fd, short events, int timeout)
+{
+    struct pollfd p;
+    p.fd = fd;
+    p.events = events;
+    for (;;) {
+        int ret = poll(&p, 1, timeout);
+        if (ret > 0) return;
+        if (ret == 0) throw BenchError_t("timeout");
+        if (errno != EINTR) throw BenchError_t(strerror(errno));
+    }
+}//konec fce
+
+void sendAll(int fd, const unsigned char *data, size_t length, int timeout)
+{
+    while (length) {
+        waitFor(fd, POLLOUT, timeout);
+        ssize_t ret = ::send(fd, data, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            throw BenchError_t(std::string("send: ") + strerror(errno));
+        }
+        data += ret;
+        length -= ret;
+    }
+}//konec fce
+
+void recvAll(int fd, Sphinx::Query_t &data, size_t length, int timeout)
+{
+    char buff[65536];
+    while (length) {
+        waitFor(fd, POLLIN, timeout);
+        ssize_t ret = ::recv(fd, buff, length < sizeof(buff)
+                                       ? length : sizeof(buff), MSG_DONTWAIT);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            throw BenchError_t(std::string("recv: ") + strerror(errno));
+        }
+        if (ret == 0) throw BenchError_t("connection closed by server");
+        data.append(buff, ret);
+        length -= ret;
+    }
+}//konec fce
+
+int connectTo(const Options_t &o)
+{
+    int fd;
+    if (o.host.compare(0, 7, "unix://") == 0) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, o.host.c_str() + 7, sizeof(addr.sun_path) - 1);
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, (struct sockaddr *)&addr,
+                                sizeof(addr)) < 0)
+        {
+            if (fd >= 0) ::close(fd);
+            throw BenchError_t(std::string("connect: ") + strerror(errno));
+        }
+        return fd;
+    }
+
+    struct addrinfo hints, *ai;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char port[16];
+    snprintf(port, sizeof(port), "%u", o.port);
+    if (getaddrinfo(o.host.c_str(), port, &hints, &ai))
+        throw BenchError_t("cannot resolve " + o.host);
+
+    fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0 || ::connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+        freeaddrinfo(ai);
+        if (fd >= 0) ::close(fd);
+        throw BenchError_t(std::string("connect: ") + strerror(errno));
+    }
+    freeaddrinfo(ai);
+    return fd;
+}//konec fce
+
+/// runs single or multi request over own connection, records phases
+void runRaw(Worker_t &w, const Request_t &request)
+{
+    const Options_t &o = *w.shared->options;
+    uint64_t t0 = nowUs();
+
+    if (w.fd < 0) {
+        w.fd = connectTo(o);
+        uint64_t t1 = nowUs();
+        w.phases[PHASE_CONNECT].record(t1 - t0);
+
+        // protocol version exchange
+        Sphinx::Query_t version;
+        version.convertEndian = true;
+        recvAll(w.fd, version, 4, o.timeout);
+        version.clear();
+        version << (uint32_t)1;
+        if (o.reuse) {
+            // persistent connection
+            version << (unsigned short)Sphinx::SEARCHD_COMMAND_PERSIST
+                    << (unsigned short)0 << (uint32_t)4 << (uint32_t)1;
+        }
+        sendAll(w.fd, version.data, version.getLength(), o.timeout);
+        w.phases[PHASE_HANDSHAKE].record(nowUs() - t1);
+    }
+
+    // send request and wait for the response
+    uint64_t t2 = nowUs();
+    sendAll(w.fd, request.data.data, request.data.getLength(), o.timeout);
+
+    Sphinx::Query_t response;
+    response.convertEndian = true;
+    recvAll(w.fd, response, 1, o.timeout);
+    uint64_t t3 = nowUs();
+    w.phases[PHASE_SERVER].record(t3 - t2);
+
+    recvAll(w.fd, response, 7, o.timeout);
+    unsigned short status, version;
+    uint32_t length;
+    response >> status >> version >> length;
+    response.clear();
+    recvAll(w.fd, response, length, o.timeout);
+    uint64_t t4 = nowUs();
+    w.phases[PHASE_TRANSFER].record(t4 - t3);
+
+    if (!o.reuse) {
+        ::close(w.fd);
+        w.fd = -1;
+    }
+
+    if (status != Sphinx::SEARCHD_OK) {
+        std::string msg;
+        response >> msg;
+        throw BenchError_t("searchd: " + msg);
+    }
+
+    // parse all responses
+    uint32_t searchd = 0;
+    bool warning = false;
+    for (uint32_t q = 0; q < request.queryCount; ++q) {
+        Sphinx::Response_t parsed;
+        try {
+            parseResponseVersion(response,
+                    (Sphinx::SearchCommandVersion_t)version, parsed, 0, 0);
+        } catch (const Sphinx::Warning_t &) {
+            warning = true;
+        }
+        searchd += parsed.timeConsumed;
+    }
+    w.phases[PHASE_PARSE].record(nowUs() - t4);
+    w.phases[PHASE_SEARCHD].record(searchd * 1000);
+    if (warning) ++w.warnings;
+}//konec fce
+
+/// runs optimised multiquery thru Client_t
+void runOpt(Worker_t &w, const Request_t &request)
+{
+    Sphinx::Client_t client(*w.shared->connection);
+    std::vector<Sphinx::Response_t> responses;
+    try {
+        client.query(*request.mq, responses);
+    } catch (const Sphinx::Warning_t &) {
+        ++w.warnings;
+    }
+
+    // phases of the slowest connection, parse time of all responses
+    uint32_t searchd = 0;
+    uint64_t parse = 0;
+    Sphinx::QueryStats_t slowest;
+    for (size_t i = 0; i < responses.size(); ++i) {
+        const Sphinx::QueryStats_t &stats = responses[i].stats;
+        if (responses[i].timeConsumed > searchd)
+            searchd = responses[i].timeConsumed;
+        if (stats.responseTime > slowest.responseTime) slowest = stats;
+        parse += stats.parseTime;
+    }
+    w.phases[PHASE_CONNECT].record(slowest.connectTime);
+    w.phases[PHASE_HANDSHAKE].record(slowest.versionTime
+                                     - slowest.connectTime);
+    w.phases[PHASE_SERVER].record(slowest.headerTime - slowest.versionTime);
+    w.phases[PHASE_TRANSFER].record(slowest.responseTime
+                                    - slowest.headerTime);
+    w.phases[PHASE_PARSE].record(parse);
+    w.phases[PHASE_SEARCHD].record(searchd * 1000);
+}//konec fce
+
+void *workerThread(void *arg)
+{
+    Worker_t &w = *static_cast<Worker_t *>(arg);
+    Shared_t &s = *w.shared;
+    const Options_t &o = *s.options;
+
+    for (;;) {
+        unsigned long seqNo = __sync_fetch_and_add(&s.next, 1);
+        if (o.requests && seqNo >= o.requests) break;
+
+        // open loop - each request has its scheduled start, latency
+        // is counted from it (no coordinated omission)
+        uint64_t start;
+        if (o.qps > 0) {
+            start = s.start + (uint64_t)(seqNo * 1e6 / o.qps);
+            if (s.end && start >= s.end) break;
+            sleepUntilUs(start);
+        } else {
+            start = nowUs();
+            if (s.end && start >= s.end) break;
+        }
+
+        const Request_t &request = (*s.requests)[seqNo % s.requests->size()];
+        bool failed = true;
+        try {
+            if (o.mode == MODE_OPT) runOpt(w, request);
+            else runRaw(w, request);
+            ++w.ok;
+            w.phases[PHASE_TOTAL].record(nowUs() - start);
+            failed = false;
+        } catch (const BenchError_t &e) {
+            w.lastError = e.msg;
+        } catch (const Sphinx::Error_t &e) {
+            w.lastError = e.errMsg;
+        }
+        if (failed) {
+            ++w.errors;
+            // connection state is unknown after error
+            if (w.fd >= 0) ::close(w.fd);
+            w.fd = -1;
+        }
+    }
+    if (w.fd >= 0) ::close(w.fd);
+    return 0;
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+void usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s -f queryfile [options]\n"
+        "  -f file       query file, one query per line (# comments)\n"
+        "  -H host       searchd host or unix://path (default localhost)\n"
+        "  -p port       searchd port (default 9312)\n"
+        "  -E            run against in-process searchd emulator\n"
+        "  -L ms         emulator latency (with -E)\n"
+        "  -i index      searched indexes (default *)\n"
+        "  -l limit      matches per query (default 20)\n"
+        "  -c count      concurrency (default 1)\n"
+        "  -n count      total requests (default: run for -d seconds)\n"
+        "  -d seconds    duration (default 10)\n"
+        "  -q qps        open loop target request rate (default closed loop)\n"
+        "  -m mode       single, multi or opt (default single)\n"
+        "  -b count      queries per multiquery (default 8)\n"
+        "  -k            reuse connections (persistent, single/multi mode)\n"
+        "  -t ms         timeout (default 3000)\n",
+        name);
+}//konec fce
+
+bool parseOptions(int argc, char *argv[], Options_t &o)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "f:H:p:EL:i:l:c:n:d:q:m:b:kt:h")) != -1) {
+        switch (opt) {
+        case 'f': o.queryFile = optarg; break;
+        case 'H': o.host = optarg; break;
+        case 'p': o.port = atoi(optarg); break;
+        case 'E': o.emulator = true; break;
+        case 'L': o.emulatorLatency = atoi(optarg); break;
+        case 'i': o.index = optarg; break;
+        case 'l': o.limit = atoi(optarg); break;
+        case 'c': o.concurrency = atoi(optarg); break;
+        case 'n': o.requests = strtoul(optarg, 0, 10); break;
+        case 'd': o.duration = strtoul(optarg, 0, 10); break;
+        case 'q': o.qps = atof(optarg); break;
+        case 'm':
+            if (!strcmp(optarg, "single")) o.mode = MODE_SINGLE;
+            else if (!strcmp(optarg, "multi")) o.mode = MODE_MULTI;
+            else if (!strcmp(optarg, "opt")) o.mode = MODE_OPT;
+            else return false;
+            break;
+        case 'b': o.batch = atoi(optarg); break;
+        case 'k': o.reuse = true; break;
+        case 't': o.timeout = atoi(optarg); break;
+        default: return false;
+        }
+    }
+    return !o.queryFile.empty() && o.concurrency > 0 && o.batch > 0;
+}//konec fce
+
+/// serializes requests from queries
+void prepareRequests(const Options_t &o,
+                     const std::vector<std::string> &queries,
+                     std::vector<Request_t> &requests)
+{
+    Sphinx::SearchConfig_t config;
+    config.setSearchedIndexes(o.index);
+    config.setPaging(0, o.limit);
+
+    size_t batch = o.mode == MODE_SINGLE ? 1 : o.batch;
+    size_t count = (queries.size() + batch - 1) / batch;
+    requests.resize(count);
+
+    for (size_t r = 0; r < count; ++r) {
+        Request_t &request = requests[r];
+        request.mq = 0;
+        request.queryCount = 0;
+
+        if (o.mode == MODE_OPT) {
+            request.mq = new Sphinx::MultiQueryOpt_t(config.getCommandVersion());
+            for (size_t q = r * batch; q < queries.size()
+                 && q < (r + 1) * batch; ++q)
+            {
+                request.mq->addQuery(queries[q], config);
+                ++request.queryCount;
+            }
+            request.mq->optimise();
+            continue;
+        }
+
+        Sphinx::MultiQuery_t mq(config.getCommandVersion());
+        for (size_t q = r * batch; q < queries.size()
+             && q < (r + 1) * batch; ++q)
+        {
+            mq.addQuery(queries[q], config);
+            ++request.queryCount;
+        }
+        request.data.convertEndian = true;
+        buildHeader(Sphinx::SEARCHD_COMMAND_SEARCH, config.getCommandVersion(),
+                    mq.getQueries().getLength(), request.data,
+                    request.queryCount);
+        request.data << mq.getQueries();
+    }
+}//konec fce
+
+}//namespace
+
+int main(int argc, char *argv[])
+{
+    Options_t o;
+    if (!parseOptions(argc, argv, o)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!o.requests && !o.duration) o.duration = 10;
+
+    // load queries
+    std::vector<std::string> queries;
+    std::ifstream in(o.queryFile.c_str());
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", o.queryFile.c_str());
+        return 1;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        queries.push_back(line);
+    }
+    if (queries.empty()) {
+        fprintf(stderr, "no queries in %s\n", o.queryFile.c_str());
+        return 1;
+    }
+
+    try {
+        Sphinx::SearchdEmulator_t emulator;
+        if (o.emulator) {
+            emulator.listenTcp();
+            Sphinx::EmulatorFaults_t faults;
+            faults.latency = o.emulatorLatency;
+            emulator.setFaults(faults);
+            emulator.start();
+            o.host = "127.0.0.1";
+            o.port = emulator.getPort();
+        }
+
+        std::vector<Request_t> requests;
+        prepareRequests(o, queries, requests);
+
+        Sphinx::ConnectionConfig_t connection(o.host, o.port, false,
+                o.timeout, o.timeout, o.timeout, 0);
+
+        Shared_t shared;
+        shared.options = &o;
+        shared.requests = &requests;
+        shared.connection = &connection;
+        shared.next = 0;
+        shared.start = nowUs();
+        shared.end = o.requests ? 0 : shared.start + o.duration * 1000000;
+
+        std::vector<Worker_t> workers(o.concurrency);
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i].shared = &shared;
+            if (pthread_create(&workers[i].thread, 0, workerThread,
+                               &workers[i]))
+            {
+                fprintf(stderr, "cannot create thread\n");
+                return 2;
+            }
+        }
+
+        Worker_t total;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            pthread_join(workers[i].thread, 0);
+            for (int p = 0; p < PHASE_COUNT; ++p)
+                total.phases[p].merge(workers[i].phases[p]);
+            total.ok += workers[i].ok;
+            total.warnings += workers[i].warnings;
+            total.errors += workers[i].errors;
+            if (!workers[i].lastError.empty())
+                total.lastError = workers[i].lastError;
+        }
+        double elapsed = (nowUs() - shared.start) / 1e6;
+
+        if (o.emulator) emulator.stop();
+        for (size_t i = 0; i < requests.size(); ++i) delete requests[i].mq;
+
+        // report
+        static const char *modes[] = {"single", "multi", "opt"};
+        printf("# mode %s, concurrency %d, reuse %s, %s\n",
+               modes[o.mode], o.concurrency, o.reuse ? "on" : "off",
+               o.qps > 0 ? "open loop" : "closed loop");
+        printf("requests\t%lu\nwarnings\t%lu\nerrors\t%lu\n",
+               total.ok, total.warnings, total.errors);
+        printf("elapsed_s\t%.3f\nrequests_per_s\t%.1f\nqueries_per_s\t%.1f\n",
+               elapsed, total.ok / elapsed,
+               total.ok / elapsed * (o.mode == MODE_SINGLE ? 1 : o.batch));
+        if (!total.lastError.empty())
+            printf("# last error: %s\n", total.lastError.c_str());
+
+        printf("# phase\tcount\tmean_us\tp50_us\tp90_us\tp99_us\tp999_us"
+               "\tmax_us\n");
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            const Histogram_t &h = total.phases[p];
+            if (!h.getCount()) continue;
+            printf("%s\t%lu\t%.0f\t%lu\t%lu\t%lu\t%lu\t%lu\n", phaseNames[p],
+                   (unsigned long)h.getCount(), h.getMean(),
+                   (unsigned long)h.percentile(50),
+                   (unsigned long)h.percentile(90),
+                   (unsigned long)h.percentile(99),
+                   (unsigned long)h.percentile(99.9),
+                   (unsigned long)h.getMax());
+        }
+        return total.errors ? 3 : 0;
+    } catch (const Sphinx::Error_t &e) {
+        fprintf(stderr, "error: %s\n", e.errMsg.c_str());
+        return 2;
+    }
+}//main
@@ -0,0 +1,376 @@
+/*
+ *
+ * C++ sphinx search client library
+ * Copyright (C) 2007  Seznam.cz, a.s.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Seznam.cz, a.s.
+ * Radlicka 2, Praha 5, 15000, Czech Republic
+ * http://www.seznam.cz, mailto:sphinxclient@firma.seznam.cz
+ *
+ *
+ * $Id$
+ *
+ * DESCRIPTION
+ * Replay tool - reissues calls captured by RequestCapture_t against
+ * searchd (or in-process searchd emulator) with original inter-arrival
+ * timing, optionally accelerated, and reports latency differences
+ *
+ * AUTHOR
+ * Sphinxclient team <sphinxclient@firma.seznam.cz>
+ *
+ * HISTORY
+ * 2026-10-18 (sphinxclient)
+ *            First draft.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <sphinxclient/sphinxclient.h>
+#include <sphinxclient/sphinxclientquery.h>
+#include <sphinxclient/globals.h>
+#include <sphinxclient/error.h>
+#include <sphinxclient/capture.h>
+
+#include "querymachine.h"
+#include "searchdemulator.h"
+
+//------------------------------------------------------------------------------
+// query version handlers declarations (not part of public interface)
+//------------------------------------------------------------------------------
+
+void buildHeader(Sphinx::Command_t, unsigned short, int, Sphinx::Query_t &,
+                 int queryCount=1);
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+uint64_t nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}//konec fce
+
+void sleepUntilUs(uint64_t when)
+{
+    for (;;) {
+        uint64_t now = nowUs();
+        if (now >= when) return;
+        struct timespec ts;
+        ts.tv_sec = (when - now) / 1000000;
+        ts.tv_nsec = ((when - now) % 1000000) * 1000;
+        nanosleep(&ts, 0);
+    }
+}//konec fce
+
+/// replay configuration
+struct Options_t {
+    Options_t()
+        : host("localhost"), port(9312), speed(1), concurrency(64),
+          requests(0), timeout(3000), emulator(false), emulatorLatency(0)
+    {}
+
+    std::string captureFile;
+    std::string host;
+    unsigned short port;
+    double speed;
+    int concurrency;
+    unsigned long requests;
+    int timeout;
+    bool emulator;
+    uint32_t emulatorLatency;
+};
+
+/// one replayed call
+struct Call_t {
+    /// whole requests with header
+    std::vector<Sphinx::Query_t> requests;
+    /// command of the call
+    uint16_t command;
+    /// start of the call relative to the first one (microseconds)
+    uint64_t offset;
+    /// original latency (microseconds)
+    uint32_t original;
+    /// replayed latency (microseconds)
+    uint32_t replayed;
+    /// replay failed
+    bool failed;
+};
+
+/// orders calls by start
+struct ByOffset_t {
+    bool operator()(const Call_t &a, const Call_t &b) const {
+        return a.offset < b.offset;
+    }
+};
+
+/// shared state of all workers
+struct Shared_t {
+    const Options_t *options;
+    std::vector<Call_t> *calls;
+    Sphinx::ConnectionConfig_t *connection;
+    /// next call sequence number
+    unsigned long next;
+    /// replay start
+    uint64_t start;
+};
+
+/// per worker results
+struct Worker_t {
+    Worker_t() : shared(0), errors(0), late(0) {}
+
+    Shared_t *shared;
+    pthread_t thread;
+    unsigned long errors;
+    /// calls started more than 1 ms after schedule (not enough workers)
+    unsigned long late;
+    std::string lastError;
+};
+
+void *workerThread(void *arg)
+{
+    Worker_t &w = *static_cast<Worker_t *>(arg);
+    Shared_t &s = *w.shared;
+    const Options_t &o = *s.options;
+
+    for (;;) {
+        unsigned long seqNo = __sync_fetch_and_add(&s.next, 1);
+        if (seqNo >= s.calls->size()) break;
+        Call_t &call = (*s.calls)[seqNo];
+
+        // open loop - latency is counted from the scheduled start
+        uint64_t start = s.start;
+        if (o.speed > 0) {
+            start += (uint64_t)(call.offset / o.speed);
+            sleepUntilUs(start);
+            if (nowUs() > start + 1000) ++w.late;
+        } else {
+            start = nowUs();
+        }
+
+        try {
+            Sphinx::QueryMachine_t queryMachine(*s.connection);
+            for (size_t i = 0; i < call.requests.size(); ++i)
+                queryMachine.addQuery(call.requests[i]);
+            queryMachine.launch();
+            call.replayed = nowUs() - start;
+        } catch (const Sphinx::Error_t &e) {
+            call.failed = true;
+            ++w.errors;
+            w.lastError = e.errMsg;
+        }
+    }
+    return 0;
+}//konec fce
+
+//------------------------------------------------------------------------------
+
+void usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s -f capturefile [options]\n"
+        "  -f file       capture file written by RequestCapture_t\n"
+        "  -H host       searchd host or unix://path (default localhost)\n"
+        "  -p port       searchd port (default 9312)\n"
+        "  -E            run against in-process searchd emulator\n"
+        "  -L ms         emulator latency (with -E)\n"
+        "  -s speed      time acceleration, 0 = as fast as possible"
+        " (default 1)\n"
+        "  -c count      maximum calls in flight (default 64)\n"
+        "  -n count      replay only first count calls\n"
+        "  -t ms         timeout (default 3000)\n",
+        name);
+}//konec fce
+
+bool parseOptions(int argc, char *argv[], Options_t &o)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "f:H:p:EL:s:c:n:t:h")) != -1) {
+        switch (opt) {
+        case 'f': o.captureFile = optarg; break;
+        case 'H': o.host = optarg; break;
+        case 'p': o.port = atoi(optarg); break;
+        case 'E': o.emulator = true; break;
+        case 'L': o.emulatorLatency = atoi(optarg); break;
+        case 's': o.speed = atof(optarg); break;
+        case 'c': o.concurrency = atoi(optarg); break;
+        case 'n': o.requests = strtoul(optarg, 0, 10); break;
+        case 't': o.timeout = atoi(optarg); break;
+        default: return false;
+        }
+    }
+    return !o.captureFile.empty() && o.concurrency > 0 && o.speed >= 0;
+}//konec fce
+
+/// reads captured calls and rebuilds their requests
+void loadCalls(const Options_t &o, std::vector<Call_t> &calls)
+{
+    Sphinx::RequestCaptureReader_t reader(o.captureFile);
+    Sphinx::CapturedCall_t captured;
+    while ((!o.requests || calls.size() < o.requests)
+           && reader.next(captured))
+    {
+        calls.push_back(Call_t());
+        Call_t &call = calls.back();
+        call.command = captured.command;
+        call.offset = captured.timestamp;
+        call.original = captured.elapsed;
+        call.replayed = 0;
+        call.failed = false;
+
+        call.requests.resize(captured.requests.size());
+        for (size_t i = 0; i < captured.requests.size(); ++i) {
+            const Sphinx::CapturedRequest_t &request = captured.requests[i];
+            Sphinx::Query_t &data = call.requests[i];
+            data.convertEndian = true;
+            buildHeader(Sphinx::Command_t(captured.command),
+                        captured.version, request.body.size(), data,
+                        request.queryCount);
+            data.append(request.body.data(), request.body.size());
+        }
+    }
+
+    // capture file is in completion order, replay in start order
+    std::stable_sort(calls.begin(), calls.end(), ByOffset_t());
+    uint64_t first = calls.empty() ? 0 : calls.front().offset;
+    for (size_t i = 0; i < calls.size(); ++i) calls[i].offset -= first;
+}//konec fce
+
+/// value at percentile p (0-100) of sorted values
+template <typename Value_t>
+Value_t percentile(const std::vector<Value_t> &sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    size_t index = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}//konec fce
+
+template <typename Value_t>
+void printRow(const char *name, std::vector<Value_t> &values)
+{
+    std::sort(values.begin(), values.end());
+    printf("%s\t%ld\t%ld\t%ld\t%ld\t%ld\n", name,
+           (long)percentile(values, 0), (long)percentile(values, 50),
+           (long)percentile(values, 90), (long)percentile(values, 99),
+           (long)percentile(values, 100));
+}//konec fce
+
+}//namespace
+
+int main(int argc, char *argv[])
+{
+    Options_t o;
+    if (!parseOptions(argc, argv, o)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::vector<Call_t> calls;
+        loadCalls(o, calls);
+        if (calls.empty()) {
+            fprintf(stderr, "no calls in %s\n", o.captureFile.c_str());
+            return 1;
+        }
+
+        Sphinx::SearchdEmulator_t emulator;
+        if (o.emulator) {
+            emulator.listenTcp();
+            Sphinx::EmulatorFaults_t faults;
+            faults.latency = o.emulatorLatency;
+            emulator.setFaults(faults);
+            emulator.start();
+            o.host = "127.0.0.1";
+            o.port = emulator.getPort();
+        }
+
+        Sphinx::ConnectionConfig_t connection(o.host, o.port, false,
+                o.timeout, o.timeout, o.timeout, 0);
+
+        Shared_t shared;
+        shared.options = &o;
+        shared.calls = &calls;
+        shared.connection = &connection;
+        shared.next = 0;
+        shared.start = nowUs();
+
+        std::vector<Worker_t> workers(o.concurrency);
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i].shared = &shared;
+            if (pthread_create(&workers[i].thread, 0, workerThread,
+                               &workers[i]))
+            {
+                fprintf(stderr, "cannot create thread\n");
+                return 2;
+            }
+        }
+
+        Worker_t total;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            pthread_join(workers[i].thread, 0);
+            total.errors += workers[i].errors;
+            total.late += workers[i].late;
+            if (!workers[i].lastError.empty())
+                total.lastError = workers[i].lastError;
+        }
+        double elapsed = (nowUs() - shared.start) / 1e6;
+        double captured = calls.back().offset / 1e6;
+
+        if (o.emulator) emulator.stop();
+
+        // latencies of successfully replayed calls
+        std::vector<int64_t> original, replayed, diff;
+        unsigned long slower = 0, faster = 0;
+        for (size_t i = 0; i < calls.size(); ++i) {
+            const Call_t &call = calls[i];
+            if (call.failed) continue;
+            original.push_back(call.original);
+            replayed.push_back(call.replayed);
+            diff.push_back(int64_t(call.replayed) - int64_t(call.original));
+            if (call.replayed > 2 * uint64_t(call.original)) ++slower;
+            if (2 * uint64_t(call.replayed) < call.original) ++faster;
+        }
+
+        // report
+        printf("# speed %g, concurrency %d\n", o.speed, o.concurrency);
+        printf("calls\t%lu\nerrors\t%lu\nlate\t%lu\n",
+               (unsigned long)calls.size(), total.errors, total.late);
+        printf("captured_s\t%.3f\nelapsed_s\t%.3f\n", captured, elapsed);
+        printf("slower_2x\t%lu\nfaster_2x\t%lu\n", slower, faster);
+        if (!total.lastError.empty())
+            printf("# last error: %s\n", total.lastError.c_str());
+
+        printf("# latency\tmin_us\tp50_us\tp90_us\tp99_us\tmax_us\n");
+        printRow("original", original);
+        printRow("replayed", replayed);
+        printRow("diff", diff);
+        return total.errors ? 3 : 0;
+    } catch (const Sphinx::Error_t &e) {
+        fprintf(stderr, "error: %s\n", e.errMsg.c_str());
+        return 2;
+    }
+}//main